@@ -0,0 +1,1080 @@
+
+// 无界面的解复用/解码性能测试程序，不打开SDL 窗口和音频设备，可以在没有显示器的linux 服务器上跑，
+// 用来在持续集成中发现性能退化。按最快速度读完整个文件，分别统计解复用、解码和图像格式转换三个阶段的耗时，
+// 输出帧率、输入数据吞吐量和单帧延迟的p50/p99/p999。
+//
+// linux 下编译：
+//   gcc -O2 -o decode_bench decode_bench.c libavcodec/*.c libavformat/*.c -lm -lpthread
+// 运行：
+//   ./decode_bench [-n 重复次数] CLOCKTXT_320.avi
+//   ./decode_bench -m msrle [-n 重复次数]	(解码器微基准，不需要输入文件)
+//   ./decode_bench -m msrleenc [-t 线程数]	(编码器微基准，同时检查解码后和输入一样)
+//   ./decode_bench -m truespeech [-x 校验和] [文件]	(TrueSpeech 解码校验和检查和逐流/批量解码帧率)
+//   ./decode_bench -m demux [-t 线程数] 文件...	(并行解复用服务和逐个文件读的结果对比)
+//   ./decode_bench -m yuv2rgb	(YUV420P 到RGB 各级SIMD 实现和C 实现逐字节对比，以及转换速度)
+//   加-c 只用C 实现，不用CPU 的加速指令，对比SIMD 实现的速度和校验和。
+
+#include "./libavformat/avformat.h"
+#include "./libavcodec/dsputil.h"
+
+#if defined(CONFIG_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define BENCH_MAX_LOOPS	100000
+
+#define FFMIN(a,b) ((a) > (b) ? (b) : (a))
+
+// 单调时钟，以纳秒为单位。
+static int64_t bench_gettime_ns(void)
+{
+#if defined(CONFIG_WIN32)
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+
+    if (!freq.QuadPart)
+	QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (int64_t)((double)now.QuadPart * 1000000000.0 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+// 单帧延迟样本，数组按需扩大。
+typedef struct BenchSamples
+{
+    int64_t *v;
+    int nb, size;
+} BenchSamples;
+
+static int samples_add(BenchSamples *s, int64_t t)
+{
+    if (s->nb == s->size)
+    {
+	int size = s->size ? s->size * 2 : 1024;
+	int64_t *v = av_realloc(s->v, size * sizeof(int64_t));
+	if (!v)
+	    return  -1;
+	s->v = v;
+	s->size = size;
+    }
+    s->v[s->nb++] = t;
+    return 0;
+}
+
+static int cmp_int64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+
+    return x < y ? -1 : x > y;
+}
+
+// 按最近秩法取千分位数，样本必须已排序。
+static double samples_permille(const BenchSamples *s, int permille)
+{
+    int64_t rank;
+
+    if (s->nb == 0)
+	return 0;
+    rank = ((int64_t)s->nb * permille + 999) / 1000;
+    if (rank < 1)
+	rank = 1;
+    return s->v[rank - 1] / 1000.0;
+}
+
+static void samples_report(const char *name, BenchSamples *s)
+{
+    if (s->nb == 0)
+	return;
+    qsort(s->v, s->nb, sizeof(int64_t), cmp_int64);
+    printf("%s latency us: p50 %.1f  p99 %.1f  p999 %.1f  max %.1f  (%d frames)\n", name,
+	samples_permille(s, 500), samples_permille(s, 990), samples_permille(s, 999),
+	s->v[s->nb - 1] / 1000.0, s->nb);
+}
+
+typedef struct BenchStats
+{
+    int64_t demux_ns, decode_ns, convert_ns;
+    int64_t in_bytes;
+    int nb_packets, nb_video, nb_audio;
+    BenchSamples video_lat;	// 每个视频帧的解码加格式转换时间
+    BenchSamples audio_lat;	// 每个音频帧的解码时间
+} BenchStats;
+
+static enum PixelFormat bench_pix_fmt = PIX_FMT_NONE;	// -p 指定的解码器直接输出格式
+static int bench_threads = 1;				// -t 指定的编码或解复用线程数
+static int bench_expect_set;				// 给了-x
+static unsigned int bench_expect;			// -x 指定的文件解码校验和
+
+// 完整跑一遍文件。视频帧转换成YUV420P，和ffplay 显示前做的转换一样。
+static int bench_file(const char *filename, BenchStats *st)
+{
+    static int16_t samples[AVCODEC_MAX_AUDIO_FRAME_SIZE];
+    AVFormatContext *ic;
+    AVCodecContext *vctx = NULL, *actx = NULL;
+    AVCodec *codec;
+    AVFrame frame;
+    AVPicture pict;
+    AVPacket pkt;
+    int i, ret, got_picture, data_size, len;
+    int video_index = -1, audio_index = -1;
+    int64_t t0, t1, t2;
+    uint8_t *buf;
+    int buf_size;
+    int pict_number = -1;
+    ImgConvertContext *convert_ctx = NULL;
+
+    if (av_open_input_file(&ic, filename, NULL, 0, NULL) < 0)
+    {
+	fprintf(stderr, "%s: could not open\n", filename);
+	return  -1;
+    }
+
+    for (i = 0; i < ic->nb_streams; i++)
+    {
+	AVCodecContext *enc = ic->streams[i]->actx;
+
+	if (enc->codec_type == CODEC_TYPE_VIDEO && video_index < 0)
+	    video_index = i;
+	else if (enc->codec_type == CODEC_TYPE_AUDIO && audio_index < 0)
+	    audio_index = i;
+	else
+	    ic->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    if (video_index >= 0)
+    {
+	vctx = ic->streams[video_index]->actx;
+	vctx->request_pix_fmt = bench_pix_fmt;
+	codec = avcodec_find_decoder(vctx->codec_id);
+	if (!codec || avcodec_open(vctx, codec) < 0)
+	{
+	    ic->streams[video_index]->discard = AVDISCARD_ALL;
+	    vctx = NULL;
+	}
+    }
+    if (audio_index >= 0)
+    {
+	actx = ic->streams[audio_index]->actx;
+	codec = avcodec_find_decoder(actx->codec_id);
+	if (!codec || avcodec_open(actx, codec) < 0)
+	{
+	    ic->streams[audio_index]->discard = AVDISCARD_ALL;
+	    actx = NULL;
+	}
+    }
+    if (!vctx && !actx)
+    {
+	fprintf(stderr, "%s: no decodable stream\n", filename);
+	av_close_input_file(ic);
+	return  -1;
+    }
+
+    memset(&frame, 0, sizeof(frame));
+    memset(&pict, 0, sizeof(pict));
+    if (vctx && avpicture_alloc(&pict, PIX_FMT_YUV420P, vctx->width, vctx->height) < 0)
+    {
+	av_close_input_file(ic);
+	return  -1;
+    }
+
+    for (;;)
+    {
+	t0 = bench_gettime_ns();
+	ret = av_read_packet(ic, &pkt);
+	t1 = bench_gettime_ns();
+	st->demux_ns += t1 - t0;
+	if (ret < 0)
+	    break;
+	if (pkt.size <= 0)
+	{
+	    av_free_packet(&pkt);
+	    if (url_feof(&ic->pb))
+		break;
+	    continue;
+	}
+	st->nb_packets++;
+	st->in_bytes += pkt.size;
+
+	if (vctx && pkt.stream_index == video_index)
+	{
+	    t0 = bench_gettime_ns();
+	    avcodec_decode_video2(vctx, &frame, &got_picture, &pkt);
+	    t1 = bench_gettime_ns();
+	    st->decode_ns += t1 - t0;
+	    if (got_picture)
+	    {
+		// 和ffplay 一样用转换上下文，连续的帧只转换变化区域。
+		convert_ctx = img_convert_ctx_get(convert_ctx, PIX_FMT_YUV420P, vctx->pix_fmt, vctx->width, vctx->height);
+		if (convert_ctx && frame.dirty_valid && pict_number >= 0 && frame.coded_picture_number == pict_number + 1)
+		{
+		    if (frame.dirty_w > 0 && frame.dirty_h > 0)
+			img_convert_ctx_rect(convert_ctx, &pict, (AVPicture*)&frame,
+			    frame.dirty_x, frame.dirty_y, frame.dirty_w, frame.dirty_h);
+		}
+		else if (convert_ctx)
+		    img_convert_ctx(convert_ctx, &pict, (AVPicture*)&frame);
+		pict_number = frame.coded_picture_number;
+		t2 = bench_gettime_ns();
+		st->convert_ns += t2 - t1;
+		st->nb_video++;
+		samples_add(&st->video_lat, t2 - t0);
+	    }
+	}
+	else if (actx && pkt.stream_index == audio_index)
+	{
+	    // 一个音频包可能包含多个音频帧，逐帧解码计时。
+	    buf = pkt.data;
+	    buf_size = pkt.size;
+	    while (buf_size > 0)
+	    {
+		t0 = bench_gettime_ns();
+		len = avcodec_decode_audio(actx, samples, &data_size, buf, buf_size);
+		t1 = bench_gettime_ns();
+		st->decode_ns += t1 - t0;
+		if (len < 0)
+		    break;
+		buf += len;
+		buf_size -= len;
+		if (data_size > 0)
+		{
+		    st->nb_audio++;
+		    samples_add(&st->audio_lat, t1 - t0);
+		}
+	    }
+	}
+	av_free_packet(&pkt);
+    }
+
+    img_convert_ctx_free(convert_ctx);
+    if (vctx)
+    {
+	avpicture_free(&pict);
+	avcodec_close(vctx);
+    }
+    if (actx)
+	avcodec_close(actx);
+    av_close_input_file(ic);
+    return 0;
+}
+
+// 伪随机数，保证每次生成的测试数据完全一样，校验和可以在不同版本之间比较。
+static unsigned int bench_rand_state = 12345;
+
+static int bench_rand(int n)
+{
+    bench_rand_state = bench_rand_state * 1103515245 + 12345;
+    return (bench_rand_state >> 16) % n;
+}
+
+// 生成一帧屏幕录像风格的RLE8/RLE4 码流：以长行程为主，夹杂短行程、少量原样像素和跳过像素的增量。
+// RLE4 的原样像素每字节两个，行程的值字节高低半字节交替输出。
+static int make_rle_frame(uint8_t *buf, int width, int height, int bpp)
+{
+    uint8_t *p = buf;
+    int x, y, n, i, bytes;
+
+    for (y = 0; y < height; y++)
+    {
+	x = 0;
+	while (x < width)
+	{
+	    n = width - x;
+	    switch (bench_rand(16))
+	    {
+	    case 0:		// 原样像素，长度至少3，奇数字节数后面补一个字节
+		n = FFMIN(n, 3 + bench_rand(40));
+		if (n < 3)
+		    goto run;
+		*p++ = 0;
+		*p++ = n;
+		bytes = bpp == 4 ? (n + 1) / 2 : n;
+		for (i = 0; i < bytes; i++)
+		    *p++ = bench_rand(256);
+		if (bytes & 1)
+		    *p++ = 0;
+		break;
+	    case 1:		// 跳过像素，保留上一帧的内容
+		n = FFMIN(n, 1 + bench_rand(64));
+		*p++ = 0;
+		*p++ = 2;
+		*p++ = n;
+		*p++ = 0;
+		break;
+	    case 2:
+	    case 3:
+	    case 4:		// 短行程
+		n = FFMIN(n, 1 + bench_rand(16));
+		goto run;
+	    default:		// 长行程
+		n = FFMIN(n, 64 + bench_rand(192));
+	    run:
+		*p++ = n;
+		*p++ = bench_rand(4) * 64;
+		break;
+	    }
+	    x += n;
+	}
+	*p++ = 0;
+	*p++ = 0;
+    }
+    *p++ = 0;
+    *p++ = 1;
+    return p - buf;
+}
+
+#define MICRO_WIDTH	1280
+#define MICRO_HEIGHT	720
+#define MICRO_FRAMES	8
+
+// 解码器微基准：反复解码几帧生成的码流，输出帧率、像素吞吐量和输出图像校验和，优化前后校验和必须一致。
+static int bench_msrle(int loops, int bpp)
+{
+    static AVPaletteControl palctrl;
+    AVCodecContext *avctx;
+    AVCodec *codec;
+    AVFrame frame;
+    uint8_t *bufs[MICRO_FRAMES];
+    int sizes[MICRO_FRAMES];
+    int i, y, got_picture, nb_frames = 0;
+    unsigned int checksum = 0;
+    int64_t start, total_ns;
+
+    codec = avcodec_find_decoder(CODEC_ID_MSRLE);
+    avctx = avcodec_alloc_context();
+    if (!codec || !avctx)
+	return  -1;
+    avctx->width = MICRO_WIDTH;
+    avctx->height = MICRO_HEIGHT;
+    avctx->bits_per_sample = bpp;
+    avctx->codec_type = CODEC_TYPE_VIDEO;
+    avctx->request_pix_fmt = bench_pix_fmt;
+    // 固定的彩色调色板，直接输出YUV420P/RGBA32 时校验和才有意义。
+    for (i = 0; i < AVPALETTE_COUNT; i++)
+	palctrl.palette[i] = (i << 16) | ((i * 7 & 0xff) << 8) | (255 - i);
+    avctx->palctrl = &palctrl;
+    if (avcodec_open(avctx, codec) < 0)
+	return  -1;
+
+    for (i = 0; i < MICRO_FRAMES; i++)
+    {
+	// 最坏情况每个像素2 字节，再加行尾标记。
+	bufs[i] = av_malloc(MICRO_WIDTH * MICRO_HEIGHT * 2 + MICRO_HEIGHT * 2 + 16 + FF_INPUT_BUFFER_PADDING_SIZE);
+	if (!bufs[i])
+	    return  -1;
+	sizes[i] = make_rle_frame(bufs[i], MICRO_WIDTH, MICRO_HEIGHT, bpp);
+    }
+
+    memset(&frame, 0, sizeof(frame));
+    start = bench_gettime_ns();
+    for (i = 0; i < loops * MICRO_FRAMES; i++)
+    {
+	avcodec_decode_video(avctx, &frame, &got_picture, bufs[i % MICRO_FRAMES], sizes[i % MICRO_FRAMES]);
+	if (got_picture)
+	    nb_frames++;
+    }
+    total_ns = bench_gettime_ns() - start;
+
+    // 只校验第一个平面：PAL8 是索引，YUV420P 是亮度，RGBA32 是全部像素。
+    for (y = 0; y < MICRO_HEIGHT; y++)
+    {
+	uint8_t *row = frame.data[0] + y * frame.linesize[0];
+	for (i = 0; i < MICRO_WIDTH * (avctx->pix_fmt == PIX_FMT_RGBA32 ? 4 : 1); i++)
+	    checksum = checksum * 16777619 ^ row[i];
+    }
+
+    printf("msrle%s %s %dx%d, %d frames, %.3f ms\n", bpp == 4 ? "4" : "",
+	avctx->pix_fmt == PIX_FMT_YUV420P ? "yuv420p" : avctx->pix_fmt == PIX_FMT_RGBA32 ? "rgba32" : "pal8",
+	MICRO_WIDTH, MICRO_HEIGHT, nb_frames, total_ns / 1e6);
+    printf("throughput: %.1f fps  %.1f Mpixel/s  checksum %08x\n",
+	nb_frames / (total_ns / 1e9), (double)nb_frames * MICRO_WIDTH * MICRO_HEIGHT / (total_ns / 1e3), checksum);
+
+    avcodec_close(avctx);
+    av_free(avctx);
+    for (i = 0; i < MICRO_FRAMES; i++)
+	av_free(bufs[i]);
+    return 0;
+}
+
+// 编码器微基准：先把生成的码流解码成几帧源图像，反复编码，输出帧率、平均帧大小和码流校验和。
+// 校验和和线程数无关。计时结束后用新的编码器和解码器把源图像编码再解码一遍，和源图像逐像素比较。
+static int bench_msrle_enc(int loops, int bpp)
+{
+    AVCodecContext *dec, *enc;
+    AVFrame frame, src[MICRO_FRAMES];
+    uint8_t *buf, *out;
+    int buf_size = MICRO_WIDTH * MICRO_HEIGHT * 2 + MICRO_HEIGHT * 8 + 16;
+    int i, x, y, size, got_picture, pass, mismatch = 0;
+    unsigned int checksum = 0;
+    int64_t start, total_ns, total_bytes = 0;
+
+    buf = av_malloc(buf_size + FF_INPUT_BUFFER_PADDING_SIZE);
+    out = av_malloc(buf_size + FF_INPUT_BUFFER_PADDING_SIZE);
+    if (!buf || !out)
+	return  -1;
+
+    for (pass = 0; pass < 2; pass++)
+    {
+	dec = avcodec_alloc_context();
+	enc = avcodec_alloc_context();
+	if (!dec || !enc)
+	    return  -1;
+	dec->width = enc->width = MICRO_WIDTH;
+	dec->height = enc->height = MICRO_HEIGHT;
+	dec->bits_per_sample = enc->bits_per_sample = bpp;
+	dec->codec_type = enc->codec_type = CODEC_TYPE_VIDEO;
+	enc->thread_count = bench_threads;
+	if (avcodec_open(dec, avcodec_find_decoder(CODEC_ID_MSRLE)) < 0 ||
+	    avcodec_open(enc, avcodec_find_encoder(CODEC_ID_MSRLE)) < 0)
+	    return  -1;
+
+	memset(&frame, 0, sizeof(frame));
+	if (pass == 0)
+	{
+	    // 生成源图像，每帧复制一份，解码器的帧缓存下一帧会被改写。
+	    for (i = 0; i < MICRO_FRAMES; i++)
+	    {
+		size = make_rle_frame(buf, MICRO_WIDTH, MICRO_HEIGHT, bpp);
+		avcodec_decode_video(dec, &frame, &got_picture, buf, size);
+		if (!got_picture || avpicture_alloc((AVPicture*)&src[i], PIX_FMT_PAL8, MICRO_WIDTH, MICRO_HEIGHT) < 0)
+		    return  -1;
+		img_copy((AVPicture*)&src[i], (AVPicture*)&frame, PIX_FMT_PAL8, MICRO_WIDTH, MICRO_HEIGHT);
+		// 第一帧跳过的像素是帧缓存的初始值，4 位编码只能表示16 个索引。
+		for (y = 0; bpp == 4 && y < MICRO_HEIGHT; y++)
+		    for (x = 0; x < MICRO_WIDTH; x++)
+			src[i].data[0][y * src[i].linesize[0] + x] &= 0x0F;
+	    }
+
+	    start = bench_gettime_ns();
+	    for (i = 0; i < loops * MICRO_FRAMES; i++)
+	    {
+		size = avcodec_encode_video(enc, out, buf_size, &src[i % MICRO_FRAMES]);
+		if (size < 0)
+		    return  -1;
+		total_bytes += size;
+		for (y = 0; y < size; y++)
+		    checksum = checksum * 16777619 ^ out[y];
+	    }
+	    total_ns = bench_gettime_ns() - start;
+	}
+	else
+	{
+	    for (i = 0; i < 2 * MICRO_FRAMES; i++)
+	    {
+		size = avcodec_encode_video(enc, out, buf_size, &src[i % MICRO_FRAMES]);
+		if (size < 0)
+		    return  -1;
+		avcodec_decode_video(dec, &frame, &got_picture, out, size);
+		for (y = 0; got_picture && y < MICRO_HEIGHT; y++)
+		{
+		    if (memcmp(frame.data[0] + y * frame.linesize[0], src[i % MICRO_FRAMES].data[0] + y * src[i % MICRO_FRAMES].linesize[0], MICRO_WIDTH))
+		    {
+			mismatch++;
+			break;
+		    }
+		}
+	    }
+	}
+
+	avcodec_close(dec);
+	avcodec_close(enc);
+	av_free(dec);
+	av_free(enc);
+    }
+
+    printf("msrleenc%s %dx%d, %d threads, %d frames, %.3f ms\n", bpp == 4 ? "4" : "",
+	MICRO_WIDTH, MICRO_HEIGHT, bench_threads, loops * MICRO_FRAMES, total_ns / 1e6);
+    printf("throughput: %.1f fps  %.1f Mpixel/s  %.0f bytes/frame  checksum %08x  round trip %s\n",
+	loops * MICRO_FRAMES / (total_ns / 1e9), (double)loops * MICRO_FRAMES * MICRO_WIDTH * MICRO_HEIGHT / (total_ns / 1e3),
+	(double)total_bytes / (loops * MICRO_FRAMES), checksum, mismatch ? "FAILED" : "ok");
+
+    for (i = 0; i < MICRO_FRAMES; i++)
+	avpicture_free((AVPicture*)&src[i]);
+    av_free(buf);
+    av_free(out);
+    return mismatch ? -1 : 0;
+}
+
+#define TS_STREAMS	16
+#define TS_FRAMES	500
+#define TS_FILE_STREAMS	8
+#define TS_REF_CHECKSUM	0x57860ce5	// 生成码流用原来的逐流标量解码器算出的校验和
+
+// 逐流解码或批量解码nb_streams 个流各nb_frames 帧(每帧32 字节)，每个流的输出单独算校验和再合起来，两种方法的结果必须一样。
+// 返回每秒解码的帧数。
+static double bench_ts_run(uint8_t **data, int nb_streams, int nb_frames, int loops, int batch, unsigned int *checksum)
+{
+    AVCodecContext *actx[TS_STREAMS];
+    int16_t *samples[TS_STREAMS];
+    uint8_t *bufs[TS_STREAMS];
+    int frame_size[TS_STREAMS], consumed[TS_STREAMS];
+    unsigned int cs[TS_STREAMS];
+    int i, s, f, loop;
+    int64_t start, total_ns = 0;
+
+    for (s = 0; s < nb_streams; s++)
+    {
+	samples[s] = av_malloc(AVCODEC_MAX_AUDIO_FRAME_SIZE);
+	if (!samples[s])
+	    return  -1;
+    }
+
+    for (loop = 0; loop < loops; loop++)
+    {
+	for (s = 0; s < nb_streams; s++)
+	{
+	    actx[s] = avcodec_alloc_context();
+	    if (!actx[s] || avcodec_open(actx[s], avcodec_find_decoder(CODEC_ID_TRUESPEECH)) < 0)
+		return  -1;
+	    cs[s] = 2166136261u;
+	}
+
+	start = bench_gettime_ns();
+	if (batch)
+	{
+	    for (f = 0; f < nb_frames; f++)
+	    {
+		for (s = 0; s < nb_streams; s++)
+		    bufs[s] = data[s] + f * 32;
+		if (avcodec_decode_audio_batch(actx, nb_streams, samples, frame_size, consumed, bufs, 32) < 0)
+		    return  -1;
+		for (s = 0; s < nb_streams; s++)
+		    if (consumed[s] != 32)
+			return  -1;
+		for (s = 0; s < nb_streams; s++)
+		    for (i = 0; i < frame_size[s] / 2; i++)
+			cs[s] = cs[s] * 16777619 ^ (uint16_t)samples[s][i];
+	    }
+	}
+	else
+	{
+	    for (s = 0; s < nb_streams; s++)
+	    {
+		for (f = 0; f < nb_frames; f++)
+		{
+		    if (avcodec_decode_audio(actx[s], samples[s], &frame_size[s], data[s] + f * 32, 32) < 0)
+			return  -1;
+		    for (i = 0; i < frame_size[s] / 2; i++)
+			cs[s] = cs[s] * 16777619 ^ (uint16_t)samples[s][i];
+		}
+	    }
+	}
+	total_ns += bench_gettime_ns() - start;
+
+	*checksum = 2166136261u;
+	for (s = 0; s < nb_streams; s++)
+	{
+	    *checksum = *checksum * 16777619 ^ cs[s];
+	    avcodec_close(actx[s]);
+	    av_free(actx[s]);
+	}
+    }
+
+    for (s = 0; s < nb_streams; s++)
+	av_free(samples[s]);
+    return (double)loops * nb_streams * nb_frames / (total_ns / 1e9);
+}
+
+// 取出文件中第一个TrueSpeech 音频流的数据，去掉不满一帧的尾部。返回帧数，没有时返回0。
+static int bench_ts_load_file(const char *filename, uint8_t **data)
+{
+    AVFormatContext *ic;
+    AVPacket pkt;
+    int i, audio_index = -1, size = 0;
+    uint8_t *buf = NULL, *p;
+
+    if (av_open_input_file(&ic, filename, NULL, 0, NULL) < 0)
+	return  -1;
+    for (i = 0; i < ic->nb_streams; i++)
+    {
+	if (ic->streams[i]->actx->codec_id == CODEC_ID_TRUESPEECH && audio_index < 0)
+	    audio_index = i;
+	else
+	    ic->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    while (audio_index >= 0 && av_read_packet(ic, &pkt) >= 0)
+    {
+	if (pkt.stream_index == audio_index && pkt.size > 0)
+	{
+	    p = av_realloc(buf, size + pkt.size);
+	    if (!p)
+	    {
+		av_free_packet(&pkt);
+		break;
+	    }
+	    buf = p;
+	    memcpy(buf + size, pkt.data, pkt.size);
+	    size += pkt.size;
+	}
+	av_free_packet(&pkt);
+	if (url_feof(&ic->pb))
+	    break;
+    }
+    av_close_input_file(ic);
+
+    *data = buf;
+    return size / 32;
+}
+
+// TrueSpeech 解码的正确性和性能测试。生成的码流和文件中的码流(可选)分别用逐流解码和批量解码各跑一遍，
+// 两种方法的校验和必须一样，生成码流的校验和还必须等于原来标量实现的结果，文件的校验和给了-x 时必须等于-x，
+// 不一致时返回-1，可以用作优化的回归检查。文件只有一个流，批量解码时把同一个流复制成TS_FILE_STREAMS 路。
+static int bench_truespeech(int loops, const char *filename)
+{
+    uint8_t *data[TS_STREAMS], *file_streams[TS_FILE_STREAMS], *file_data = NULL;
+    unsigned int cs_single, cs_batch;
+    double fps_single, fps_batch;
+    int s, i, nb_frames, ret = 0;
+
+    // 生成的帧把两点滤波的偏移限制在真实码流的范围内，否则会读到历史之外。
+    for (s = 0; s < TS_STREAMS; s++)
+    {
+	data[s] = av_malloc(TS_FRAMES * 32);
+	if (!data[s])
+	    return  -1;
+	for (i = 0; i < TS_FRAMES * 32; i++)
+	    data[s][i] = bench_rand(256);
+	for (i = 0; i < TS_FRAMES; i++)
+	{
+	    data[s][i * 32 + 7] &= 0x3F;
+	    data[s][i * 32 + 15] &= 0x3F;
+	}
+    }
+
+    fps_single = bench_ts_run(data, TS_STREAMS, TS_FRAMES, loops, 0, &cs_single);
+    fps_batch = bench_ts_run(data, TS_STREAMS, TS_FRAMES, loops, 1, &cs_batch);
+    if (fps_single < 0 || fps_batch < 0)
+	return  -1;
+    printf("truespeech generated: %d streams x %d frames, checksum %08x (expect %08x) %s\n", TS_STREAMS, TS_FRAMES,
+	cs_single, TS_REF_CHECKSUM, cs_single == TS_REF_CHECKSUM && cs_batch == cs_single ? "ok" : "MISMATCH");
+    printf("throughput: single %.0f fps  batch %.0f fps\n", fps_single, fps_batch);
+    if (cs_single != TS_REF_CHECKSUM || cs_batch != cs_single)
+	ret = -1;
+
+    if (filename)
+    {
+	nb_frames = bench_ts_load_file(filename, &file_data);
+	if (nb_frames <= 0)
+	{
+	    fprintf(stderr, "%s: no TrueSpeech stream\n", filename);
+	    return  -1;
+	}
+	for (s = 0; s < TS_FILE_STREAMS; s++)
+	    file_streams[s] = file_data;
+	fps_single = bench_ts_run(file_streams, TS_FILE_STREAMS, nb_frames, loops, 0, &cs_single);
+	fps_batch = bench_ts_run(file_streams, TS_FILE_STREAMS, nb_frames, loops, 1, &cs_batch);
+	if (fps_single < 0 || fps_batch < 0)
+	    return  -1;
+	if (bench_expect_set)
+	    printf("truespeech %s: %d x %d frames, checksum %08x (expect %08x) %s\n", filename, TS_FILE_STREAMS, nb_frames,
+		cs_single, bench_expect, cs_single == bench_expect && cs_batch == cs_single ? "ok" : "MISMATCH");
+	else
+	    printf("truespeech %s: %d x %d frames, checksum %08x %s\n", filename, TS_FILE_STREAMS, nb_frames,
+		cs_single, cs_batch == cs_single ? "ok" : "MISMATCH");
+	printf("throughput: single %.0f fps  batch %.0f fps\n", fps_single, fps_batch);
+	if (cs_batch != cs_single || (bench_expect_set && cs_single != bench_expect))
+	    ret = -1;
+	av_free(file_data);
+    }
+
+    for (s = 0; s < TS_STREAMS; s++)
+	av_free(data[s]);
+    return ret;
+}
+
+#define BENCH_MAX_FILES		64
+#define DEMUX_INFLIGHT_BYTES	(256 * 1024)	// 在途字节上限取得很小，让限流真正起作用
+
+// 解复用服务中的一个任务，只在处理它的工作线程中访问，任务在线程间交接时经过双端队列的锁。
+typedef struct BenchDemuxFile
+{
+    AVDemuxService *svc;
+    const char *filename;
+    int nb_packets;
+    int64_t bytes;
+    unsigned int hash;			// 所有数据包内容按顺序的校验和
+    int status, done;
+} BenchDemuxFile;
+
+static void bench_demux_add(BenchDemuxFile *f, const AVPacket *pkt)
+{
+    int i;
+
+    f->nb_packets++;
+    f->bytes += pkt->size;
+    f->hash = f->hash * 16777619 ^ pkt->stream_index;
+    for (i = 0; i < pkt->size; i++)
+	f->hash = f->hash * 16777619 ^ pkt->data[i];
+}
+
+static int bench_demux_packet(void *opaque, const char *filename, AVFormatContext *ic, AVPacket *pkt)
+{
+    BenchDemuxFile *f = opaque;
+
+    bench_demux_add(f, pkt);
+    av_demux_service_free_packet(f->svc, pkt);
+    return 0;
+}
+
+static void bench_demux_done(void *opaque, const char *filename, int status)
+{
+    BenchDemuxFile *f = opaque;
+
+    f->status = status;
+    f->done++;
+}
+
+// 和解复用服务一样的读法逐个读完文件，作为参考结果。
+static int bench_demux_serial(BenchDemuxFile *f)
+{
+    AVFormatContext *ic;
+    AVPacket pkt;
+
+    f->hash = 2166136261u;
+    if (av_open_input_file(&ic, f->filename, NULL, 0, NULL) < 0)
+	return  -1;
+
+    for (;;)
+    {
+	if (av_read_packet(ic, &pkt) < 0)
+	{
+	    f->status = url_ferror(&ic->pb);
+	    break;
+	}
+	if (pkt.size <= 0)
+	{
+	    av_free_packet(&pkt);
+	    if (url_feof(&ic->pb))
+		break;
+	    continue;
+	}
+	bench_demux_add(f, &pkt);
+	av_free_packet(&pkt);
+    }
+    av_close_input_file(ic);
+    return 0;
+}
+
+// 多文件并行解复用服务的正确性和性能测试。每个文件加入loops 次，打开文件数上限等于线程数，
+// 所以后加的文件要排队，读得快的线程会去偷别的线程的任务。每个任务的包数、字节数和内容校验和必须和逐个读的一样。
+static int bench_demux(int loops, char **files, int nb_files)
+{
+    BenchDemuxFile ref[BENCH_MAX_FILES], *tasks;
+    AVDemuxService *svc;
+    int64_t start, serial_ns, svc_ns, bytes = 0;
+    int i, nb_tasks = nb_files * loops, mismatch = 0;
+
+    memset(ref, 0, sizeof(ref));
+    start = bench_gettime_ns();
+    for (i = 0; i < nb_files; i++)
+    {
+	ref[i].filename = files[i];
+	if (bench_demux_serial(&ref[i]) < 0)
+	{
+	    fprintf(stderr, "%s: cannot open\n", files[i]);
+	    return  -1;
+	}
+    }
+    serial_ns = bench_gettime_ns() - start;
+
+    tasks = av_mallocz(nb_tasks * sizeof(BenchDemuxFile));
+    if (!tasks)
+	return  -1;
+
+    start = bench_gettime_ns();
+    svc = av_demux_service_create(bench_threads, bench_threads, DEMUX_INFLIGHT_BYTES);
+    if (!svc)
+    {
+	av_free(tasks);
+	return  -1;
+    }
+    for (i = 0; i < nb_tasks; i++)
+    {
+	tasks[i].svc = svc;
+	tasks[i].filename = files[i % nb_files];
+	tasks[i].hash = 2166136261u;
+	if (av_demux_service_add(svc, tasks[i].filename, bench_demux_packet, bench_demux_done, &tasks[i]) < 0)
+	    tasks[i].done = -1;
+    }
+    av_demux_service_close(svc);
+    svc_ns = bench_gettime_ns() - start;
+
+    for (i = 0; i < nb_tasks; i++)
+    {
+	BenchDemuxFile *r = &ref[i % nb_files];
+
+	if (tasks[i].done != 1 || tasks[i].status != r->status || tasks[i].nb_packets != r->nb_packets ||
+	    tasks[i].bytes != r->bytes || tasks[i].hash != r->hash)
+	{
+	    printf("demux %s (task %d): %d packets %lld bytes hash %08x status %d, expect %d packets %lld bytes hash %08x status %d\n",
+		tasks[i].filename, i, tasks[i].nb_packets, (long long)tasks[i].bytes, tasks[i].hash, tasks[i].status,
+		r->nb_packets, (long long)r->bytes, r->hash, r->status);
+	    mismatch++;
+	}
+	bytes += tasks[i].bytes;
+    }
+
+    printf("demux: %d files x %d, %d threads, %lld bytes, %s\n", nb_files, loops, bench_threads,
+	(long long)bytes, mismatch ? "MISMATCH" : "ok");
+    printf("throughput: serial %.1f MB/s  service %.1f MB/s\n",
+	serial_ns > 0 ? (double)bytes / loops / (serial_ns / 1e9) / (1024 * 1024) : 0,
+	svc_ns > 0 ? (double)bytes / (svc_ns / 1e9) / (1024 * 1024) : 0);
+
+    av_free(tasks);
+    return mismatch ? -1 : 0;
+}
+
+#define Y2R_MAX_W	321
+#define Y2R_MAX_H	241
+#define Y2R_BENCH_W	1280
+#define Y2R_BENCH_H	720
+
+// 检查的大小：下面几种高度配所有宽度，几种宽度配所有高度。宽度覆盖16/32 个像素一组的边界和奇数行尾。
+static const int y2r_heights[] = { 1, 2, 3, 4, 5, 17, Y2R_MAX_H };
+static const int y2r_widths[] = { 1, 2, 3, 4, 5, 15, 16, 17, 31, 32, 33, 63, 64, 65, 320, Y2R_MAX_W };
+
+static const int y2r_fmts[5] = { PIX_FMT_RGB24, PIX_FMT_BGR24, PIX_FMT_RGBA32, PIX_FMT_RGB565, PIX_FMT_RGB555 };
+static const char *y2r_fmt_names[5] = { "rgb24", "bgr24", "rgba32", "rgb565", "rgb555" };
+
+// DSPContext 的各级实现，CPU 或编译器不支持的级别跳过。
+#define Y2R_LEVELS	4
+static const int y2r_levels[Y2R_LEVELS] = { 0, MM_SSE2, MM_SSE2 | MM_SSSE3, MM_SSE2 | MM_SSSE3 | MM_AVX2 };
+static const char *y2r_level_names[Y2R_LEVELS] = { "c", "sse2", "ssse3", "avx2" };
+
+typedef struct BenchY2R
+{
+    AVPicture src[2];		// YUV420P 和YUVJ420P 的随机图像
+    AVPicture ref, out;
+    int nb_sizes, mismatch;
+} BenchY2R;
+
+// 转换一种大小，用C 实现的结果和某一级实现的结果比较。比较到第h 行(不超过缓存)的整行，
+// 行尾之外和图像下面一行也必须没有被改写。
+static void bench_y2r_check(BenchY2R *b, int level, int w, int h)
+{
+    int f, j, y, rows = h < Y2R_MAX_H ? h + 1 : h;
+
+    for (j = 0; j < 2; j++)
+    {
+	for (f = 0; f < 5; f++)
+	{
+	    memset(b->ref.data[0], 0x5A, rows * b->ref.linesize[0]);
+	    memset(b->out.data[0], 0x5A, rows * b->out.linesize[0]);
+	    dsputil_init(&ff_dsp, 0);
+	    img_convert(&b->ref, y2r_fmts[f], &b->src[j], j ? PIX_FMT_YUVJ420P : PIX_FMT_YUV420P, w, h);
+	    dsputil_init(&ff_dsp, y2r_levels[level]);
+	    img_convert(&b->out, y2r_fmts[f], &b->src[j], j ? PIX_FMT_YUVJ420P : PIX_FMT_YUV420P, w, h);
+
+	    for (y = 0; y < rows; y++)
+	    {
+		if (memcmp(b->ref.data[0] + y * b->ref.linesize[0], b->out.data[0] + y * b->out.linesize[0],
+		    b->ref.linesize[0]))
+		{
+		    if (b->mismatch < 10)
+			printf("yuv2rgb %s %s%s %dx%d: row %d differs\n", y2r_level_names[level],
+			    j ? "yuvj420p->" : "yuv420p->", y2r_fmt_names[f], w, h, y);
+		    b->mismatch++;
+		    break;
+		}
+	    }
+	}
+    }
+    b->nb_sizes++;
+}
+
+// YUV420P/YUVJ420P 到RGB 的DSPContext 行转换：各级SIMD 实现在1x1 到321x241 的一组大小上必须和C 实现的查表结果
+// 逐字节相同，然后测1280x720 的转换速度。不一致时返回-1。
+static int bench_yuv2rgb(int loops)
+{
+    BenchY2R b;
+    AVPicture big_src, big_dst;
+    int max_flags = ff_dsp.mm_flags, levels = 0;
+    int i, j, k, f, l, n;
+    int64_t start, ns;
+
+    memset(&b, 0, sizeof(b));
+    for (j = 0; j < 2; j++)
+    {
+	if (avpicture_alloc(&b.src[j], j ? PIX_FMT_YUVJ420P : PIX_FMT_YUV420P, Y2R_MAX_W, Y2R_MAX_H) < 0)
+	    return  -1;
+	for (k = 0; k < 3; k++)
+	{
+	    n = b.src[j].linesize[k] * (k ? (Y2R_MAX_H + 1) >> 1 : Y2R_MAX_H);
+	    for (i = 0; i < n; i++)
+		b.src[j].data[k][i] = bench_rand(256);
+	}
+    }
+    if (avpicture_alloc(&b.ref, PIX_FMT_RGBA32, Y2R_MAX_W, Y2R_MAX_H) < 0 ||
+	avpicture_alloc(&b.out, PIX_FMT_RGBA32, Y2R_MAX_W, Y2R_MAX_H) < 0)
+	return  -1;
+
+    // 输出缓存按最大的像素格式分配，各格式共用。
+    for (l = 1; l < Y2R_LEVELS; l++)
+    {
+	if ((y2r_levels[l] & max_flags) != y2r_levels[l])
+	    continue;
+	levels++;
+	for (k = 0; k < (int)(sizeof(y2r_heights) / sizeof(y2r_heights[0])); k++)
+	    for (i = 1; i <= Y2R_MAX_W; i++)
+		bench_y2r_check(&b, l, i, y2r_heights[k]);
+	for (k = 0; k < (int)(sizeof(y2r_widths) / sizeof(y2r_widths[0])); k++)
+	    for (i = 1; i <= Y2R_MAX_H; i++)
+		bench_y2r_check(&b, l, y2r_widths[k], i);
+    }
+    printf("yuv2rgb: %d SIMD levels x %d sizes x 10 conversions, %s\n", levels, levels ? b.nb_sizes / levels : 0,
+	b.mismatch ? "MISMATCH" : "ok");
+
+    for (j = 0; j < 2; j++)
+	avpicture_free(&b.src[j]);
+    avpicture_free(&b.ref);
+    avpicture_free(&b.out);
+
+    // 速度：每种格式每一级转换loops * 20 次。
+    if (avpicture_alloc(&big_src, PIX_FMT_YUV420P, Y2R_BENCH_W, Y2R_BENCH_H) < 0 ||
+	avpicture_alloc(&big_dst, PIX_FMT_RGBA32, Y2R_BENCH_W, Y2R_BENCH_H) < 0)
+	return  -1;
+    n = avpicture_get_size(PIX_FMT_YUV420P, Y2R_BENCH_W, Y2R_BENCH_H);
+    for (i = 0; i < n; i++)
+	big_src.data[0][i] = bench_rand(256);	// 三个分量在同一块内存中
+    for (f = 0; f < 5; f++)
+    {
+	printf("throughput %s Mpixel/s:", y2r_fmt_names[f]);
+	for (l = 0; l < Y2R_LEVELS; l++)
+	{
+	    if ((y2r_levels[l] & max_flags) != y2r_levels[l])
+		continue;
+	    dsputil_init(&ff_dsp, y2r_levels[l]);
+	    start = bench_gettime_ns();
+	    for (i = 0; i < loops * 20; i++)
+		img_convert(&big_dst, y2r_fmts[f], &big_src, PIX_FMT_YUV420P, Y2R_BENCH_W, Y2R_BENCH_H);
+	    ns = bench_gettime_ns() - start;
+	    printf("  %s %.1f", y2r_level_names[l], ns > 0 ? (double)Y2R_BENCH_W * Y2R_BENCH_H * loops * 20 / (ns / 1e3) : 0);
+	}
+	printf("\n");
+    }
+    avpicture_free(&big_src);
+    avpicture_free(&big_dst);
+
+    dsputil_init(&ff_dsp, max_flags);
+    return b.mismatch ? -1 : 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: decode_bench [-n loops] [-p yuv420p|rgba32] file\n"
+	"       decode_bench -m msrle|msrle4 [-n loops] [-p yuv420p|rgba32]\n"
+	"       decode_bench -m msrleenc|msrleenc4 [-n loops] [-t threads]\n"
+	"       decode_bench -m truespeech [-n loops] [-x checksum] [file]\n"
+	"       decode_bench -m demux [-n loops] [-t threads] file...\n"
+	"       decode_bench -m yuv2rgb [-n loops]\n"
+	"  -p  要求解码器直接输出的像素格式\n"
+	"  -t  编码或解复用线程数\n"
+	"  -c  只用C 实现，不用CPU 的加速指令\n"
+	"  -x  文件解码应得的校验和(十六进制)，CLOCKTXT_320.avi 是bc472fa5\n");
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    BenchStats st;
+    const char *filename = NULL;
+    const char *micro = NULL;
+    char *files[BENCH_MAX_FILES];
+    int i, loops = 1, force_c = 0, nb_files = 0;
+    int64_t start, total_ns;
+    double total_s;
+
+    for (i = 1; i < argc; i++)
+    {
+	if (!strcmp(argv[i], "-n") && i + 1 < argc)
+	    loops = atoi(argv[++i]);
+	else if (!strcmp(argv[i], "-m") && i + 1 < argc)
+	    micro = argv[++i];
+	else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+	    bench_threads = atoi(argv[++i]);
+	else if (!strcmp(argv[i], "-c"))
+	    force_c = 1;
+	else if (!strcmp(argv[i], "-x") && i + 1 < argc)
+	{
+	    bench_expect = (unsigned int)strtoul(argv[++i], NULL, 16);
+	    bench_expect_set = 1;
+	}
+	else if (!strcmp(argv[i], "-p") && i + 1 < argc)
+	{
+	    i++;
+	    if (!strcmp(argv[i], "yuv420p"))
+		bench_pix_fmt = PIX_FMT_YUV420P;
+	    else if (!strcmp(argv[i], "rgba32"))
+		bench_pix_fmt = PIX_FMT_RGBA32;
+	    else
+		usage();
+	}
+	else if (argv[i][0] == '-')
+	    usage();
+	else if (nb_files < BENCH_MAX_FILES)
+	{
+	    if (!filename)
+		filename = argv[i];
+	    files[nb_files++] = argv[i];
+	}
+	else
+	    usage();
+    }
+    if ((!filename && !micro) || loops <= 0 || loops > BENCH_MAX_LOOPS)
+	usage();
+
+    av_register_all();
+    if (force_c)
+	dsputil_init(&ff_dsp, 0);
+
+    if (micro)
+    {
+	if (!strcmp(micro, "msrle"))
+	    return bench_msrle(loops, 8) < 0;
+	if (!strcmp(micro, "msrle4"))
+	    return bench_msrle(loops, 4) < 0;
+	if (!strcmp(micro, "msrleenc"))
+	    return bench_msrle_enc(loops, 8) < 0;
+	if (!strcmp(micro, "msrleenc4"))
+	    return bench_msrle_enc(loops, 4) < 0;
+	if (!strcmp(micro, "truespeech"))
+	    return bench_truespeech(loops, filename) < 0;
+	if (!strcmp(micro, "demux") && nb_files > 0 && bench_threads > 0)
+	    return bench_demux(loops, files, nb_files) < 0;
+	if (!strcmp(micro, "yuv2rgb"))
+	    return bench_yuv2rgb(loops) < 0;
+	usage();
+    }
+
+    memset(&st, 0, sizeof(st));
+    start = bench_gettime_ns();
+    for (i = 0; i < loops; i++)
+    {
+	if (bench_file(filename, &st) < 0)
+	    return 1;
+    }
+    total_ns = bench_gettime_ns() - start;
+    total_s = total_ns / 1e9;
+
+    printf("file %s, %d loops, %d packets, %lld bytes\n", filename, loops, st.nb_packets, (long long)st.in_bytes);
+    printf("time ms: demux %.3f  decode %.3f  img_convert %.3f  total %.3f\n",
+	st.demux_ns / 1e6, st.decode_ns / 1e6, st.convert_ns / 1e6, total_ns / 1e6);
+    printf("throughput: %.1f MB/s  video %.1f fps  audio %.1f fps\n",
+	total_s > 0 ? st.in_bytes / total_s / (1024 * 1024) : 0,
+	total_s > 0 ? st.nb_video / total_s : 0,
+	total_s > 0 ? st.nb_audio / total_s : 0);
+    samples_report("video", &st.video_lat);
+    samples_report("audio", &st.audio_lat);
+
+    av_free(st.video_lat.v);
+    av_free(st.audio_lat.v);
+    av_packet_pool_free();
+    return 0;
+}
@@ -1,802 +1,1121 @@
-
-#include "./libavformat/avformat.h"
-
-#if defined(CONFIG_WIN32)
-#include <sys/types.h>
-#include <sys/timeb.h>
-#include <windows.h>
-#else
-#include <fcntl.h>
-#include <sys/time.h>
-#endif
-
-#include <time.h>
-
-#include <math.h>
-#include <SDL.h>
-#include <SDL_thread.h>
-
-// SDL 涨main ȡsdl еmain 壬ظ塣
-#ifdef CONFIG_WIN32
-#undef main // We don't want SDL to override our main()
-#endif
-
-// SDL ⡣
-#pragma comment(lib, "SDL.lib")
-
-#define FF_QUIT_EVENT   (SDL_USEREVENT + 2)
-
-#define MAX_VIDEOQ_SIZE (5 * 256 * 1024)
-#define MAX_AUDIOQ_SIZE (5 * 16 * 1024)
-
-#define VIDEO_PICTURE_QUEUE_SIZE 1
-// Ƶݰ/֡ݽṹ
-typedef struct PacketQueue
-{
-    AVPacketList *first_pkt, *last_pkt;
-    int size;
-    int abort_request;
-    SDL_mutex *mutex;
-    SDL_cond *cond;
-} PacketQueue;
-
-// Ƶͼݽṹ
-typedef struct VideoPicture
-{
-    SDL_Overlay *bmp;
-    int width, height; // source height & width
-} VideoPicture;
-// ܿݽṹݽṹһһתãڸӽṹ֮ת
-typedef struct VideoState
-{
-    SDL_Thread *parse_tid;		// Demux ⸴ָ߳
-    SDL_Thread *video_tid;		// video ָ߳
-
-    int abort_request;			// 쳣˳
-
-    AVFormatContext *ic;		// ļʽָ룬iformat ʹ
-
-    int audio_stream;			// ƵʾAVFormatContext AVStream *streams[]
-    int video_stream;			// ƵʾAVFormatContext AVStream *streams[]
-
-    AVStream *audio_st;			// Ƶָ
-    AVStream *video_st;			// Ƶָ
-
-    PacketQueue audioq;			// Ƶ֡/ݰ
-    PacketQueue videoq;			// Ƶ֡/ݰ
-
-    VideoPicture pictq[VIDEO_PICTURE_QUEUE_SIZE];		// Ƶͼ
-    double frame_last_delay;					// Ƶ֡ӳ٣ɼΪʾʱ
-
-    uint8_t audio_buf[(AVCODEC_MAX_AUDIO_FRAME_SIZE * 3) / 2];	// Ƶ
-    unsigned int audio_buf_size;			// ƵݴС
-    int audio_buf_index;				// ƵݴС
-    AVPacket audio_pkt;					// һƵж֡ڱм״̬
-    uint8_t *audio_pkt_data;				// Ƶ׵ַaudio_pkt м״̬
-    int audio_pkt_size;					// ƵݴСaudio_pkt м״̬
-
-    SDL_mutex *video_decoder_mutex;			// ƵݰͬĻָ
-    SDL_mutex *audio_decoder_mutex;			// ƵݰͬĻָ
-
-    char filename[240];					// ýļ
-
-} VideoState;
-
-static AVInputFormat *file_iformat;
-static const char *input_filename;
-static VideoState *cur_stream;
-
-// SDL Ҫʾ档
-static SDL_Surface *screen;
-
-// ȡõǰʱ䣬1/1000000 ΪλΪڸƽֲ̨ɺ꿪ؿƱĴ롣
-int64_t av_gettime(void)
-{
-#if defined(CONFIG_WINCE)
-    return timeGetTime() *int64_t_C(1000);
-#elif defined(CONFIG_WIN32)
-    struct _timeb tb;
-    _ftime(&tb);
-    return ((int64_t)tb.time *int64_t_C(1000) + (int64_t)tb.millitm) *int64_t_C(1000);
-#else
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
-#endif
-}
-// ʼУʼΪ0 ٴ߳ͬʹõĻ
-static void packet_queue_init(PacketQueue *q) // packet queue handling
-{
-    memset(q, 0, sizeof(PacketQueue));
-    q->mutex = SDL_CreateMutex();
-    q->cond = SDL_CreateCond();
-}
-
-// ˢ¶Уͷŵж̬ڴ棬ƵռõڴAVPacketList ṹռõڴ
-static void packet_queue_flush(PacketQueue *q)
-{
-    AVPacketList *pkt, *pkt1;
-
-    // Ƕ̳߳Ҫͬڱͷж̬ڴǰ
-    SDL_LockMutex(q->mutex);
-    for (pkt = q->first_pkt; pkt != NULL; pkt = pkt1)
-    {
-	pkt1 = pkt->next;
-	av_free_packet(&pkt->pkt);		// ͷƵڴ
-	av_freep(&pkt);				// ͷAVPacketList ṹ
-    }
-    q->last_pkt = NULL;
-    q->first_pkt = NULL;
-    q->size = 0;
-    SDL_UnlockMutex(q->mutex);
-}
-
-// ͷŶռԴͷŵж̬ڴ棬ͷĻ
-static void packet_queue_end(PacketQueue *q)
-{
-    packet_queue_flush(q);
-    SDL_DestroyMutex(q->mutex);
-    SDL_DestroyCond(q->cond);
-}
-
-// ƵйҽƵ֡/ݰ
-static int packet_queue_put(PacketQueue *q, AVPacket *pkt)
-{
-    AVPacketList *pkt1;
-
-    // ȷһAVPacketList ṹڴ
-    pkt1 = av_malloc(sizeof(AVPacketList));
-    if (!pkt1)
-	return  -1;
-    pkt1->pkt = *pkt;
-    pkt1->next = NULL;
-
-    SDL_LockMutex(q->mutex);
-
-    if (!q->last_pkt)
-	q->first_pkt = pkt1;
-    else
-	q->last_pkt->next = pkt1;
-    // ӵĩβ
-    q->last_pkt = pkt1;
-    // ͳƻýݴС
-    q->size += pkt1->pkt.size;
-
-    // Ϊź״̬߳ȴ˯߾ͼʱѡ
-    SDL_CondSignal(q->cond);
-
-    SDL_UnlockMutex(q->mutex);
-    return 0;
-}
-
-// 쳣˳״̬
-static void packet_queue_abort(PacketQueue *q)
-{
-    SDL_LockMutex(q->mutex);
-
-    q->abort_request = 1;	// 쳣˳
-
-    SDL_CondSignal(q->cond);
-
-    SDL_UnlockMutex(q->mutex);
-}
-
-// Ӷȡһ֡/ݡ
-/* return < 0 if aborted, 0 if no packet and > 0 if packet.  */
-static int packet_queue_get(PacketQueue *q, AVPacket *pkt, int block)
-{
-    AVPacketList *pkt1;
-    int ret;
-
-    SDL_LockMutex(q->mutex);
-
-    for (;;)
-    {
-	// 쳣˳λʹ뷵ء
-	if (q->abort_request)
-	{
-	    ret = -1; // 쳣
-	    break;
-	}
-
-	pkt1 = q->first_pkt;
-	if (pkt1)
-	{
-	    // ݣȡһݰ
-	    q->first_pkt = pkt1->next;
-	    if (!q->first_pkt)
-		q->last_pkt = NULL;
-	    // ýС
-	    q->size -= pkt1->pkt.size;
-	    *pkt = pkt1->pkt;
-	    // ͷŵAVPacketList ṹ
-	    av_free(pkt1);
-	    ret = 1;
-	    break;
-	}
-	else if (!block)// ǣ1(ģʽ)0(ģʽ)
-	{
-	    ret = 0;	// ģʽûֱӷ0
-	    break;
-	}
-	else
-	{
-	    // ģʽûݾͽ˯״̬ȴ
-	    SDL_CondWait(q->cond, q->mutex);
-	}
-    }
-    SDL_UnlockMutex(q->mutex);
-    return ret;
-}
-
-// SDL ҪOverlay ʾ棬óԡ
-static void alloc_picture(void *opaque)
-{
-    VideoState *is = opaque;
-    VideoPicture *vp;
-
-    vp = &is->pictq[0];
-
-    if (vp->bmp)
-	SDL_FreeYUVOverlay(vp->bmp);
-
-    vp->bmp = SDL_CreateYUVOverlay(is->video_st->actx->width,
-	is->video_st->actx->height,
-	SDL_YV12_OVERLAY,
-	screen);
-
-    vp->width = is->video_st->actx->width;
-    vp->height = is->video_st->actx->height;
-}
-
-static int video_display(VideoState *is, AVFrame *src_frame, double pts)
-{
-    VideoPicture *vp;
-    int dst_pix_fmt;
-    AVPicture pict;
-
-    if (is->videoq.abort_request)
-	return  -1;
-
-    vp = &is->pictq[0];
-
-    /* if the frame is not skipped, then display it */
-    if (vp->bmp)
-    {
-	SDL_Rect rect;
-
-	if (pts)
-	    Sleep((int)(is->frame_last_delay * 1000));
-#if 1
-	/* get a pointer on the bitmap */
-	SDL_LockYUVOverlay(vp->bmp);
-
-	dst_pix_fmt = PIX_FMT_YUV420P;
-	pict.data[0] = vp->bmp->pixels[0];
-	pict.data[1] = vp->bmp->pixels[2];
-	pict.data[2] = vp->bmp->pixels[1];
-
-	pict.linesize[0] = vp->bmp->pitches[0];
-	pict.linesize[1] = vp->bmp->pitches[2];
-	pict.linesize[2] = vp->bmp->pitches[1];
-
-	img_convert(&pict,
-	    dst_pix_fmt,
-	    (AVPicture*)src_frame,
-	    is->video_st->actx->pix_fmt,
-	    is->video_st->actx->width,
-	    is->video_st->actx->height);
-
-	SDL_UnlockYUVOverlay(vp->bmp); /* update the bitmap content */
-
-	rect.x = 0;
-	rect.y = 0;
-	rect.w = is->video_st->actx->width;
-	rect.h = is->video_st->actx->height;
-	SDL_DisplayYUVOverlay(vp->bmp, &rect);
-#endif
-    }
-    return 0;
-}
-// Ƶ̣߳ҪǷ֡SDL ʾѭ(Ӷȡ֡룬ʱӣʾ)ͷƵ֡ / ݰ档
-static int video_thread(void *arg)
-{
-    VideoState *is = arg;
-    AVPacket pkt1, *pkt = &pkt1;
-    int len1, got_picture;
-    double pts = 0;
-    // ֡
-    AVFrame *frame = av_malloc(sizeof(AVFrame));
-    memset(frame, 0, sizeof(AVFrame));
-
-    // SDL ʾ
-    alloc_picture(is);
-
-    for (;;)
-    {
-	// Ӷȡ֡/ݰ
-	if (packet_queue_get(&is->videoq, pkt, 1) < 0)
-	    break;
-
-	// ʵԽ
-	SDL_LockMutex(is->video_decoder_mutex);
-	len1 = avcodec_decode_video(is->video_st->actx, frame, &got_picture, pkt->data, pkt->size);
-	SDL_UnlockMutex(is->video_decoder_mutex);
-
-	// ͬʱ
-	if (pkt->dts != AV_NOPTS_VALUE)
-	    pts = av_q2d(is->video_st->time_base) *pkt->dts;
-
-	// жϵõͼ񣬵ʾͬʾƵͼ
-	if (got_picture)
-	{
-	    if (video_display(is, frame, pts) < 0)
-		goto the_end;
-	}
-	// ͷƵ֡/ݰڴ棬ݰڴav_get_packet()еav_malloc()ġ
-	av_free_packet(pkt);
-    }
-
-the_end:
-    av_free(frame);
-    return 0;
-}
-// һƵ֡ؽѹݴСرעһƵܰƵ֡һֻһƵ֡һҪβܽꡣ
-// while жϰǷȫ꣬ûоͽ뵱ǰе֡޸״̬ͷݰٴӶȡ¼ʼֵٽѭ
-/* decode one audio frame and returns its uncompressed size */
-static int audio_decode_frame(VideoState *is, uint8_t *audio_buf, double *pts_ptr)
-{
-    AVPacket *pkt = &is->audio_pkt;
-    int len1, data_size;
-
-    for (;;)
-    {
-	/* NOTE: the audio packet can contain several frames */
-	// һƵܰƵ֡ν룬VideoState һAVPacket ͱνм״̬
-	// ν뵫ν룬audio_decode_frame ֱӽwhile ѭ
-	while (is->audio_pkt_size > 0)
-	{
-	    // ý뺯룬avcodec_decode_audio()ؽõֽ
-	    SDL_LockMutex(is->audio_decoder_mutex);
-	    len1 = avcodec_decode_audio(is->audio_st->actx, (int16_t*)audio_buf,
-		&data_size, is->audio_pkt_data, is->audio_pkt_size);
-
-	    SDL_UnlockMutex(is->audio_decoder_mutex);
-	    if (len1 < 0)
-	    {
-		/* if error, we skip the frame */
-		// ǰ֡ײѭ
-		is->audio_pkt_size = 0;
-		break;
-	    }
-	    // Ƶ֡׵ַʹС
-	    is->audio_pkt_data += len1;
-	    is->audio_pkt_size -= len1;
-	    if (data_size <= 0) {
-		// ûеõݣ롣
-		// Щ֡һνʱֻһ֡ͷͷأʱҪ֡
-		continue;
-	    }
-	    // ؽݴС
-	    return data_size;
-	}
-
-	// ǳʼʱaudio_pkt ûиֵһѾ꣬ʱҪͷŰڴ档
-	/* free the current packet */
-	if (pkt->data)
-	    av_free_packet(pkt);
-
-	// ȡһݰ
-	/* read next packet */
-	if (packet_queue_get(&is->audioq, pkt, 1) < 0)
-	    return  -1;
-
-	// ʼݰ׵ַʹСһаƵ֡ν
-	is->audio_pkt_data = pkt->data;
-	is->audio_pkt_size = pkt->size;
-    }
-}
-// ƵصÿƵΪʱϵͳ͵ô˺Ƶ档
-// ĿǰñȽϼ򵥵ͬʽƵԼĽǰ߼ɣҪsynchronize_audio()ͬ
-/* prepare a new audio buffer */
-void sdl_audio_callback(void *opaque, Uint8 *stream, int len)
-{
-    VideoState *is = opaque;
-    int audio_size, len1;
-    double pts = 0;
-
-    while (len > 0)
-    {
-	if (is->audio_buf_index >= is->audio_buf_size)
-	{
-	    // ȫͽƵ
-	    audio_size = audio_decode_frame(is, is->audio_buf, &pts);
-	    if (audio_size < 0)
-	    {
-		/* if error, just output silence */
-		is->audio_buf_size = 1024;
-		memset(is->audio_buf, 0, is->audio_buf_size);
-	    }
-	    else
-	    {
-		//              audio_size = synchronize_audio(is, (int16_t*)is->audio_buf, audio_size, pts);
-		is->audio_buf_size = audio_size;
-	    }
-	    is->audio_buf_index = 0;
-	}
-	// ʵݵ棬޸Ľ뻺Ĳһѭ
-	// رע⣺ɽһѭ֪ӦSDL 档
-	len1 = is->audio_buf_size - is->audio_buf_index;
-	if (len1 > len)
-	    len1 = len;
-	memcpy(stream, (uint8_t*)is->audio_buf + is->audio_buf_index, len1);
-	len -= len1;
-	stream += len1;
-	is->audio_buf_index += len1;
-    }
-}
-
-// ģ飬ĹǴӦcodec߳(ǰƵصһ߳)
-/* open a given stream. Return 0 if OK */
-static int stream_component_open(VideoState *is, int stream_index)
-{
-    AVFormatContext *ic = is->ic;
-    AVCodecContext *enc;
-    AVCodec *codec;
-    SDL_AudioSpec wanted_spec, spec;
-
-    if (stream_index < 0 || stream_index >= ic->nb_streams)
-	return  -1;
-    // ҵļʽеõĽָ룬еĲ
-    enc = ic->streams[stream_index]->actx;
-
-    /* prepare audio output */
-    if (enc->codec_type == CODEC_TYPE_AUDIO)
-    {
-	// ʼƵSDL_OpenAudio()õSDL ⡣
-	wanted_spec.freq = enc->sample_rate;
-	wanted_spec.format = AUDIO_S16SYS;
-	/* hack for AC3. XXX: suppress that */
-	if (enc->channels > 2)
-	    enc->channels = 2;
-	wanted_spec.channels = enc->channels;
-	wanted_spec.silence = 0;
-	wanted_spec.samples = 1024; //SDL_AUDIO_BUFFER_SIZE;
-	wanted_spec.callback = sdl_audio_callback; // Ƶ̵߳Ļص
-	wanted_spec.userdata = is;
-	if (SDL_OpenAudio(&wanted_spec, &spec) < 0)
-	{
-	    // wanted_spec Ӧó趨SDL Ƶspec SDL ⷵظӦóֵ֧Ƶͨһµġ
-	    // SDL ֵ֧ĲΧ᷵Ĳ
-	    fprintf(stderr, "SDL_OpenAudio: %s\n", SDL_GetError());
-	    return  -1;
-	}
-    }
-
-    // ձĵcodec_idҵӦĹܺ
-    codec = avcodec_find_decoder(enc->codec_id);
-
-    // Ĺ֮һ,򿪱ʼл
-    if (!codec || avcodec_open(enc, codec) < 0)
-	return  -1;
-
-    switch (enc->codec_type)
-    {
-    case CODEC_TYPE_AUDIO:
-	// VideoState м¼Ƶ
-	is->audio_stream = stream_index;
-	is->audio_st = ic->streams[stream_index];
-	is->audio_buf_size = 0;
-	is->audio_buf_index = 0;
-	// ʼƵ
-	memset(&is->audio_pkt, 0, sizeof(is->audio_pkt));
-	packet_queue_init(&is->audioq);
-	SDL_PauseAudio(0);	// Ƶ̡߳
-	break;
-    case CODEC_TYPE_VIDEO:
-	// VideoState м¼Ƶ
-	is->video_stream = stream_index;
-	is->video_st = ic->streams[stream_index];
-
-	is->frame_last_delay = is->video_st->frame_last_delay;
-	// ʼƵ
-	packet_queue_init(&is->videoq);
-	is->video_tid = SDL_CreateThread(video_thread, is);			// ֱƵ̡߳
-	break;
-    default:
-	break;
-    }
-    return 0;
-}
-// رģ飬ֹ̣ͣ߳ͷŶԴ
-// ͨpacket_queue_abort()abort_request ־λ߳б˱־λȫ˳̡߳
-static void stream_component_close(VideoState *is, int stream_index)
-{
-    AVFormatContext *ic = is->ic;
-    AVCodecContext *enc;
-    // 򵥵У顣
-    if (stream_index < 0 || stream_index >= ic->nb_streams)
-	return;
-    // ҵļʽеõĽָ룬еĲ
-    enc = ic->streams[stream_index]->actx;
-
-    switch (enc->codec_type)
-    {
-	// ֹ̣ͣ߳ͷŶԴ
-    case CODEC_TYPE_AUDIO:
-	packet_queue_abort(&is->audioq);
-	SDL_CloseAudio();
-	packet_queue_end(&is->audioq);
-	break;
-    case CODEC_TYPE_VIDEO:
-	packet_queue_abort(&is->videoq);
-	SDL_WaitThread(is->video_tid, NULL);
-	packet_queue_end(&is->videoq);
-	break;
-    default:
-	break;
-    }
-    // ͷűԴ
-    avcodec_close(enc);
-}
-// ļ̣߳е㲻ʵܣֱʶļʽͼʶýʽ򿪾ı̣߳ƵýҽӵӦС
-static int decode_thread(void *arg)
-{
-    VideoState *is = arg;
-    AVFormatContext *ic;
-    int err, i, ret, video_index, audio_index;
-    AVPacket pkt1, *pkt = &pkt1;
-    AVFormatParameters params, *ap = &params;
-
-    int flags = SDL_HWSURFACE | SDL_ASYNCBLIT | SDL_HWACCEL | SDL_RESIZABLE;
-
-    // ʼָʾûӦ
-    video_index = -1;
-    audio_index = -1;
-
-    is->video_stream = -1;
-    is->audio_stream = -1;
-
-    memset(ap, 0, sizeof(*ap));
-    // úֱʶļʽڴ˺ٵʶýʽ
-    err = av_open_input_file(&ic, is->filename, NULL, 0, ap);
-    if (err < 0)
-    {
-	ret = -1;
-	goto fail;
-    }
-    // ļʽģڸݽṹת
-    is->ic = ic;
-
-    for (i = 0; i < ic->nb_streams; i++)
-    {
-	AVCodecContext *enc = ic->streams[i]->actx;
-	switch (enc->codec_type)
-	{
-	    // ƵʾƵõSDL ⡣
-	case CODEC_TYPE_AUDIO:
-	    if (audio_index < 0)
-		audio_index = i;
-	    break;
-	case CODEC_TYPE_VIDEO:
-	    if (video_index < 0)
-		video_index = i;
-
-	    screen = SDL_SetVideoMode(enc->width, enc->height, 0, flags);
-
-	    SDL_WM_SetCaption("FFplay", "FFplay"); // ޸ΪƵС
-
-//          schedule_refresh(is, 40);
-	    break;
-	default:
-	    break;
-	}
-    }
-    // Ƶ͵úƵƵ̡߳
-    if (audio_index >= 0)
-	stream_component_open(is, audio_index);
-    // Ƶ͵úƵƵ̡߳
-    if (video_index >= 0)
-	stream_component_open(is, video_index);
-    // ûƵûƵô뷵ء
-    if (is->video_stream < 0 && is->audio_stream < 0)
-    {
-	fprintf(stderr, "%s: could not open codecs\n", is->filename);
-	ret = -1;
-	goto fail;
-    }
-
-    for (;;)
-    {
-	if (is->abort_request) {
-	    // 쳣˳λ˳ļ̡߳
-	    break;
-	}
-
-
-	if (is->audioq.size > MAX_AUDIOQ_SIZE || is->videoq.size > MAX_VIDEOQ_SIZE || url_feof(&ic->pb))
-	{
-	    // ΢ʱһ¡
-	    SDL_Delay(10); // if the queue are full, no need to read more,wait 10 ms
-	    continue;
-	}
-	// ýļĶȡһƵݡ
-	ret = av_read_packet(ic, pkt); //av_read_frame(ic, pkt);		
-	if (ret < 0)
-	{
-	    if (url_ferror(&ic->pb) == 0)
-	    {
-		SDL_Delay(100); // wait for user event
-		continue;
-	    }
-	    else
-		break;
-	}
-
-	{
-	    unsigned int *p1 = (unsigned int*)(pkt->data);
-	    unsigned int *p2 = p1 + 1;
-
-	    if ((*p1 == 0x3c8638) && (*p2 == 0x1185148))
-	    {
-		int dbg = 0;
-	    }
-	}
-	// жϰݵֱͣҽӵӦУǲʶֱͣͷŶ
-	if (pkt->stream_index == is->audio_stream)
-	{
-	    packet_queue_put(&is->audioq, pkt);
-	}
-	else if (pkt->stream_index == is->video_stream)
-	{
-	    packet_queue_put(&is->videoq, pkt);
-	}
-	else
-	{
-	    av_free_packet(pkt);
-	}
-    }
-    // 򵥵ʱú߳лݽʾꡣȻһҲԡ
-    while (!is->abort_request)   // wait until the end
-    {
-	SDL_Delay(100);
-    }
-
-    ret = 0;
-
-    // ͷŵڱ߳зĸԴ˭˭ͷŵĳԷԡ
-fail:
-    if (is->audio_stream >= 0)
-	stream_component_close(is, is->audio_stream);
-
-    if (is->video_stream >= 0)
-	stream_component_close(is, is->video_stream);
-
-    if (is->ic)
-    {
-	av_close_input_file(is->ic);
-	is->ic = NULL;
-    }
-
-    if (ret != 0)
-    {
-	SDL_Event event;
-
-	event.type = FF_QUIT_EVENT;
-	event.user.data1 = is;
-	SDL_PushEvent(&event);
-    }
-    return 0;
-}
-
-// ҪǷȫܿݽṹʼزļ̡߳
-static VideoState *stream_open(const char *filename, AVInputFormat *iformat)
-{
-    VideoState *is;
-
-    is = av_mallocz(sizeof(VideoState));
-    if (!is)
-	return NULL;
-    pstrcpy(is->filename, sizeof(is->filename), filename);
-
-    is->audio_decoder_mutex = SDL_CreateMutex();
-    is->video_decoder_mutex = SDL_CreateMutex();
-
-    is->parse_tid = SDL_CreateThread(decode_thread, is);
-    if (!is->parse_tid)
-    {
-	av_free(is);
-	return NULL;
-    }
-    return is;
-}
-// رҪͷԴ
-static void stream_close(VideoState *is)
-{
-    VideoPicture *vp;
-    int i;
-
-    is->abort_request = 1;
-    SDL_WaitThread(is->parse_tid, NULL);
-
-    for (i = 0; i < VIDEO_PICTURE_QUEUE_SIZE; i++)
-    {
-	vp = &is->pictq[i];
-	if (vp->bmp)
-	{
-	    SDL_FreeYUVOverlay(vp->bmp);
-	    vp->bmp = NULL;
-	}
-    }
-
-    SDL_DestroyMutex(is->audio_decoder_mutex);
-    SDL_DestroyMutex(is->video_decoder_mutex);
-
-    free(is);
-}
-
-// ˳ʱõĺرͷһЩԴ
-void do_exit(void)
-{
-    if (cur_stream)
-    {
-	stream_close(cur_stream);
-	cur_stream = NULL;
-    }
-
-    SDL_Quit();
-    exit(0);
-}
-// SDL Ϣ¼ѭ
-void event_loop(void) // handle an event sent by the GUI
-{
-    SDL_Event event;
-
-    for (;;)
-    {
-	SDL_WaitEvent(&event);
-	switch (event.type)
-	{
-	case SDL_KEYDOWN:
-	    switch (event.key.keysym.sym)
-	    {
-	    case SDLK_ESCAPE:
-	    case SDLK_q:
-		do_exit();
-		break;
-	    default:
-		break;
-	    }
-	    break;
-	case SDL_QUIT:
-	case FF_QUIT_EVENT:
-	    do_exit();
-	    break;
-	default:
-	    break;
-	}
-    }
-}
-// ںʼSDL ⣬עSDL Ϣ¼ļ̣߳Ϣѭ
-int main(int argc, char **argv)
-{
-    int flags = SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_TIMER;
-
-    av_register_all();
-
-    input_filename = "D:\\workspace\\ffsrc\\CLOCKTXT_320.avi";
-
-    if (SDL_Init(flags))
-	exit(1);
-
-    SDL_EventState(SDL_ACTIVEEVENT, SDL_IGNORE);
-    SDL_EventState(SDL_MOUSEMOTION, SDL_IGNORE);
-    SDL_EventState(SDL_SYSWMEVENT, SDL_IGNORE);
-    SDL_EventState(SDL_USEREVENT, SDL_IGNORE);
-
-    cur_stream = stream_open(input_filename, file_iformat);
-
-    event_loop();
-
-    return 0;
-}
+
+#include "./libavformat/avformat.h"
+
+#if defined(CONFIG_WIN32)
+#include <sys/types.h>
+#include <sys/timeb.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/time.h>
+#endif
+
+#include <time.h>
+
+#include <math.h>
+#include <SDL.h>
+#include <SDL_thread.h>
+
+// SDL 里面定义了main 函数，所以在这里取消sdl 中的main 定义，避免重复定义。
+#ifdef CONFIG_WIN32
+#undef main // We don't want SDL to override our main()
+#endif
+
+// 导入SDL 库。
+#pragma comment(lib, "SDL.lib")
+
+#define FF_QUIT_EVENT   (SDL_USEREVENT + 2)
+
+#define MAX_VIDEOQ_SIZE (5 * 256 * 1024)
+#define MAX_AUDIOQ_SIZE (5 * 16 * 1024)
+
+#define VIDEO_PICTURE_QUEUE_SIZE 3	// 解码和显示流水线之间的图像队列深度
+#define DR_OVERLAY_COUNT (VIDEO_PICTURE_QUEUE_SIZE + 2)	// 直接渲染的显示表面数：队列中的图像，解码器正在写的一帧和写时复制的新帧
+
+#define VIDEO_SKIP_NONREF_FRAMES 1	// 解码落后超过这么多帧的时间就跳过非参考帧
+#define VIDEO_SKIP_NONKEY_FRAMES 4	// 落后超过这么多帧的时间就只输出关键帧
+
+#define MAX_READ_BATCH	16	// 文件解析线程一次最多批量读取的数据包数
+// 音视频数据包/数据帧队列数据结构定义
+typedef struct PacketQueue
+{
+    AVPacketList *first_pkt, *last_pkt;
+    int size;
+    int abort_request;
+    SDL_mutex *mutex;
+    SDL_cond *cond;
+} PacketQueue;
+
+// 视频图像数据结构定义，frame 引用解码器的帧缓存，解码器改写下一帧时会写时复制，不影响队列中的图像。
+typedef struct VideoPicture
+{
+    AVFrame frame;
+    double pts;
+} VideoPicture;
+// 总控数据结构，把其他核心数据结构整合在一起，起一个中转的作用，便于在各个子结构之间跳转。
+typedef struct VideoState
+{
+    SDL_Thread *parse_tid;		// Demux 解复用线程指针
+    SDL_Thread *video_tid;		// video 解码线程指针
+    SDL_Thread *refresh_tid;		// video 显示线程指针，图像格式转换和显示在这个线程中做
+
+    int abort_request;			// 异常退出请求标记
+
+    AVFormatContext *ic;		// 输入文件格式上下文指针，和iformat 配套使用
+
+    int audio_stream;			// 音频流索引，表示AVFormatContext 中AVStream *streams[]数组索引
+    int video_stream;			// 视频流索引，表示AVFormatContext 中AVStream *streams[]数组索引
+
+    AVStream *audio_st;			// 音频流指针
+    AVStream *video_st;			// 视频流指针
+
+    PacketQueue audioq;			// 音频数据帧/数据包队列
+    PacketQueue videoq;			// 视频数据帧/数据包队列
+
+    VideoPicture pictq[VIDEO_PICTURE_QUEUE_SIZE];		// 解码后视频图像队列数组，环形使用
+    int pictq_size, pictq_rindex, pictq_windex;		// 队列中的图像数，读写位置
+    int pictq_abort;						// 通知解码和显示线程退出
+    SDL_mutex *pictq_mutex;
+    SDL_cond *pictq_cond;
+
+    SDL_Overlay *bmp;						// SDL 显示缓存，只在显示线程中创建、使用和释放
+    int bmp_picture_number;					// bmp 中已转换好的帧序号，-1 表示没有，下一帧只需转换变化区域
+    ImgConvertContext *img_convert_ctx;				// 转换到bmp 用的格式转换上下文，只在显示线程中使用
+    int video_dr;						// 直接渲染，解码器直接写到SDL 显示表面上，不再格式转换
+    SDL_Overlay *dr_overlays[DR_OVERLAY_COUNT];			// 直接渲染用的软件显示表面，由显示线程创建和释放
+    int dr_nb_overlays;						// 创建好的直接渲染显示表面数
+    int dr_nb_used;						// 已交给解码器的显示表面数，只在解码线程中访问
+    int dr_ready;						// 显示线程已决定是否直接渲染，由pictq_mutex 保护
+    int video_thread_done;					// 解码线程已退出，不再写显示表面，由pictq_mutex 保护
+    double frame_last_delay;					// 视频帧延迟，可简单认为是显示间隔时间
+    double frame_timer;						// 显示时间表的起点，即pts 为0 的帧应该显示的时刻(秒)，0 表示还没开始显示，由pictq_mutex 保护
+
+    uint8_t *audio_buf;					// 输出音频缓存，指向解码器输出的音频帧或静音缓存
+    unsigned int audio_buf_size;			// 解码后音频数据大小
+    int audio_buf_index;				// 已输出音频数据大小
+    AVFrame audio_frame;				// 解码器输出的音频帧，下次取帧前有效
+    uint8_t audio_silence[1024];			// 解码出错时输出的静音
+
+    SDL_mutex *video_decoder_mutex;			// 视频数据包队列同步操作而定义的互斥量指针
+    SDL_mutex *audio_decoder_mutex;			// 音频数据包队列同步操作而定义的互斥量指针
+
+    char filename[240];					// 媒体文件名
+
+} VideoState;
+
+static AVInputFormat *file_iformat;
+static const char *input_filename;
+static VideoState *cur_stream;
+
+// SDL 库需要的显示表面。
+static SDL_Surface *screen;
+
+// 取得当前时间，以1/1000000 秒为单位，为便于在各个平台上移植，由宏开关控制编译的代码。
+int64_t av_gettime(void)
+{
+#if defined(CONFIG_WINCE)
+    return timeGetTime() *int64_t_C(1000);
+#elif defined(CONFIG_WIN32)
+    struct _timeb tb;
+    _ftime(&tb);
+    return ((int64_t)tb.time *int64_t_C(1000) + (int64_t)tb.millitm) *int64_t_C(1000);
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
+// 初始化队列，初始化为0 后再创建线程同步使用的互斥和条件。
+static void packet_queue_init(PacketQueue *q) // packet queue handling
+{
+    memset(q, 0, sizeof(PacketQueue));
+    q->mutex = SDL_CreateMutex();
+    q->cond = SDL_CreateCond();
+}
+
+// 刷新队列，释放掉队列中所有动态分配的内存，包括音视频裸数据占用的内存和AVPacketList 结构占用的内存
+static void packet_queue_flush(PacketQueue *q)
+{
+    AVPacketList *pkt, *pkt1;
+
+    // 由于是多线程程序，需要同步，所以在遍历队列释放所有动态分配内存前，加锁。
+    SDL_LockMutex(q->mutex);
+    for (pkt = q->first_pkt; pkt != NULL; pkt = pkt1)
+    {
+	pkt1 = pkt->next;
+	av_free_packet(&pkt->pkt);		// 释放音视频数据内存
+	av_packet_list_free(pkt);		// 释放AVPacketList 结构，回到节点池
+    }
+    q->last_pkt = NULL;
+    q->first_pkt = NULL;
+    q->size = 0;
+    SDL_UnlockMutex(q->mutex);
+}
+
+// 释放队列占用所有资源，首先释放掉所有动态分配的内存，接着释放申请的互斥量和条件量。
+static void packet_queue_end(PacketQueue *q)
+{
+    packet_queue_flush(q);
+    SDL_DestroyMutex(q->mutex);
+    SDL_DestroyCond(q->cond);
+}
+
+// 往音视频队列中挂接音视频数据帧/数据包。
+static int packet_queue_put(PacketQueue *q, AVPacket *pkt)
+{
+    AVPacketList *pkt1;
+
+    // 先从节点池取一个AVPacketList 结构
+    pkt1 = av_packet_list_alloc();
+    if (!pkt1)
+	return  -1;
+    pkt1->pkt = *pkt;
+    pkt1->next = NULL;
+
+    SDL_LockMutex(q->mutex);
+
+    if (!q->last_pkt)
+	q->first_pkt = pkt1;
+    else
+	q->last_pkt->next = pkt1;
+    // 添加到队列末尾
+    q->last_pkt = pkt1;
+    // 统计缓存的媒体数据大小
+    q->size += pkt1->pkt.size;
+
+    // 设置条件量为有信号状态，如果解码线程因等待而睡眠就及时唤醒。
+    SDL_CondSignal(q->cond);
+
+    SDL_UnlockMutex(q->mutex);
+    return 0;
+}
+
+// 批量入队，先在锁外分配并串好所有AVPacketList 节点，再只加一次锁挂到队列末尾。
+static int packet_queue_put_batch(PacketQueue *q, AVPacket *pkts, int nb_pkts)
+{
+    AVPacketList *first = NULL, *last = NULL, *pkt1;
+    int i, size = 0;
+
+    if (nb_pkts <= 0)
+	return 0;
+
+    for (i = 0; i < nb_pkts; i++)
+    {
+	pkt1 = av_packet_list_alloc();
+	if (!pkt1)
+	{
+	    // 分配失败时释放已串好的节点，包数据由调用者释放。
+	    while (first)
+	    {
+		pkt1 = first->next;
+		av_packet_list_free(first);
+		first = pkt1;
+	    }
+	    return  -1;
+	}
+	pkt1->pkt = pkts[i];
+	pkt1->next = NULL;
+
+	if (!last)
+	    first = pkt1;
+	else
+	    last->next = pkt1;
+	last = pkt1;
+	size += pkt1->pkt.size;
+    }
+
+    SDL_LockMutex(q->mutex);
+
+    if (!q->last_pkt)
+	q->first_pkt = first;
+    else
+	q->last_pkt->next = first;
+    q->last_pkt = last;
+    q->size += size;
+
+    SDL_CondSignal(q->cond);
+
+    SDL_UnlockMutex(q->mutex);
+    return 0;
+}
+
+// 设置异常请求退出状态。
+static void packet_queue_abort(PacketQueue *q)
+{
+    SDL_LockMutex(q->mutex);
+
+    q->abort_request = 1;	// 请求异常退出
+
+    SDL_CondSignal(q->cond);
+
+    SDL_UnlockMutex(q->mutex);
+}
+
+// 从队列中取出一帧/包数据。
+/* return < 0 if aborted, 0 if no packet and > 0 if packet.  */
+static int packet_queue_get(PacketQueue *q, AVPacket *pkt, int block)
+{
+    AVPacketList *pkt1;
+    int ret;
+
+    SDL_LockMutex(q->mutex);
+
+    for (;;)
+    {
+	// 如果异常请求退出标记置位，就带错误码返回。
+	if (q->abort_request)
+	{
+	    ret = -1; // 异常
+	    break;
+	}
+
+	pkt1 = q->first_pkt;
+	if (pkt1)
+	{
+	    // 如果队列中有数据，就取第一个数据包
+	    q->first_pkt = pkt1->next;
+	    if (!q->first_pkt)
+		q->last_pkt = NULL;
+	    // 修正缓存的媒体大小
+	    q->size -= pkt1->pkt.size;
+	    *pkt = pkt1->pkt;
+	    // 释放掉AVPacketList 结构，回到节点池
+	    av_packet_list_free(pkt1);
+	    ret = 1;
+	    break;
+	}
+	else if (!block)// 阻塞标记，1(阻塞模式)，0(非阻塞模式)
+	{
+	    ret = 0;	// 非阻塞模式，没东西直接返回0
+	    break;
+	}
+	else
+	{
+	    // 如果是阻塞模式，没数据就进入睡眠状态等待
+	    SDL_CondWait(q->cond, q->mutex);
+	}
+    }
+    SDL_UnlockMutex(q->mutex);
+    return ret;
+}
+
+// 分配SDL 库需要的Overlay 显示表面。
+static void alloc_picture(void *opaque)
+{
+    VideoState *is = opaque;
+
+    if (is->bmp)
+	SDL_FreeYUVOverlay(is->bmp);
+
+    is->bmp = SDL_CreateYUVOverlay(is->video_st->actx->width,
+	is->video_st->actx->height,
+	SDL_YV12_OVERLAY,
+	screen);
+    is->bmp_picture_number = -1;
+}
+
+// 显示线程开始时创建直接渲染用的显示表面。只用软件显示表面：硬件显示表面(比如DirectDraw 的overlay)
+// 每次锁定后像素地址都可能变，也不允许一直锁定，解码器没法在两次显示之间一直往里写。
+// 软件显示表面的锁定什么也不做，像素地址创建后就不变，解码线程不锁定直接写。创建失败或得到硬件显示表面时不用直接渲染。
+static void dr_create_overlays(VideoState *is)
+{
+    SDL_Overlay *bmp;
+    int i;
+
+    for (i = 0; i < DR_OVERLAY_COUNT; i++)
+    {
+	bmp = SDL_CreateYUVOverlay(is->video_st->actx->width, is->video_st->actx->height, SDL_YV12_OVERLAY, screen);
+	if (!bmp)
+	    break;
+	is->dr_overlays[is->dr_nb_overlays++] = bmp;
+	if (bmp->hw_overlay)
+	    break;
+    }
+
+    if (is->dr_nb_overlays < DR_OVERLAY_COUNT || is->dr_overlays[DR_OVERLAY_COUNT - 1]->hw_overlay)
+    {
+	while (is->dr_nb_overlays > 0)
+	    SDL_FreeYUVOverlay(is->dr_overlays[--is->dr_nb_overlays]);
+	is->video_dr = 0;
+    }
+}
+
+// 显示线程退出前调用，等解码线程退出不再写显示表面后释放所有显示表面。
+static void free_overlays(VideoState *is)
+{
+    SDL_LockMutex(is->pictq_mutex);
+    while (!is->video_thread_done)
+	SDL_CondWait(is->pictq_cond, is->pictq_mutex);
+    SDL_UnlockMutex(is->pictq_mutex);
+
+    while (is->dr_nb_overlays > 0)
+	SDL_FreeYUVOverlay(is->dr_overlays[--is->dr_nb_overlays]);
+    if (is->bmp)
+    {
+	SDL_FreeYUVOverlay(is->bmp);
+	is->bmp = NULL;
+    }
+}
+
+// 直接渲染时给解码器分配帧缓存，每个帧缓存就是显示线程事先创建好的一个YV12 显示表面，在解码线程中调用。
+// 帧缓存池会复用归还的帧缓存，只有同时在用的帧缓存都不够时才调用这里，所以DR_OVERLAY_COUNT 个就够了。
+// 池释放帧缓存时不需要回调，显示表面最后由显示线程释放。
+static int dr_alloc_overlay(void *opaque, int pix_fmt, int width, int height,
+    uint8_t *data[4], int linesize[4], void **buf_opaque)
+{
+    VideoState *is = opaque;
+    SDL_Overlay *bmp;
+    int chroma_height = (height + 1) >> 1;
+
+    if (is->dr_nb_used >= is->dr_nb_overlays)
+	return  -1;
+    bmp = is->dr_overlays[is->dr_nb_used++];
+    if (bmp->w != width || bmp->h != height)
+	return  -1;
+
+    // YV12 的分量顺序是Y V U，解码器的YUV420P 是Y U V，交换一下。
+    data[0] = bmp->pixels[0];
+    data[1] = bmp->pixels[2];
+    data[2] = bmp->pixels[1];
+    data[3] = NULL;
+    linesize[0] = bmp->pitches[0];
+    linesize[1] = bmp->pitches[2];
+    linesize[2] = bmp->pitches[1];
+    linesize[3] = 0;
+
+    // 和库内部分配的帧缓存一样初始化成128，增量帧解码器第一帧不完整时也不会显示垃圾数据。
+    memset(data[0], 128, linesize[0] * height);
+    memset(data[1], 128, linesize[1] * chroma_height);
+    memset(data[2], 128, linesize[2] * chroma_height);
+
+    *buf_opaque = bmp;
+    return 0;
+}
+
+// 按显示时间表等到pts 应该显示的时刻，已经晚了就不等，第一帧确定时间表的起点。
+// 以前每帧固定等一个帧间隔，解码或显示慢了会越拖越晚，按时间表等待时落后的时间不会累积。
+static void video_wait_display(VideoState *is, double pts)
+{
+    double now = av_gettime() / 1000000.0;
+    double delay;
+
+    SDL_LockMutex(is->pictq_mutex);
+    if (!is->frame_timer)
+	is->frame_timer = now - pts;
+    delay = is->frame_timer + pts - now;
+    SDL_UnlockMutex(is->pictq_mutex);
+
+    if (delay > 0)
+	Sleep((int)(delay * 1000));
+}
+
+// 解码线程在解码每一包前按这一帧应该显示的时刻选择跳帧策略：落后一点跳过非参考帧，落后多了只输出关键帧，
+// 追上后恢复正常。跳过的帧不输出图像，不进图像队列，也就不做格式转换。
+static enum AVDiscard video_skip_policy(VideoState *is, double pts)
+{
+    double frame_delay = is->frame_last_delay > 0 ? is->frame_last_delay : 0.04;
+    double late = 0;
+
+    SDL_LockMutex(is->pictq_mutex);
+    if (is->frame_timer && pts)
+	late = av_gettime() / 1000000.0 - (is->frame_timer + pts);
+    SDL_UnlockMutex(is->pictq_mutex);
+
+    if (late > VIDEO_SKIP_NONKEY_FRAMES * frame_delay)
+	return AVDISCARD_NONKEY;
+    if (late > VIDEO_SKIP_NONREF_FRAMES * frame_delay)
+	return AVDISCARD_NONREF;
+    return AVDISCARD_DEFAULT;
+}
+
+static int video_display(VideoState *is, AVFrame *src_frame, double pts)
+{
+    SDL_Overlay *bmp = is->bmp;
+    SDL_Overlay *dr_bmp = av_frame_get_buf_opaque(src_frame);	// 直接渲染的帧本身就在显示表面上
+    int dst_pix_fmt;
+    AVPicture pict;
+
+    if (is->videoq.abort_request)
+	return  -1;
+
+    if (dr_bmp)
+    {
+	SDL_Rect rect;
+
+	video_wait_display(is, pts);
+
+	rect.x = 0;
+	rect.y = 0;
+	rect.w = is->video_st->actx->width;
+	rect.h = is->video_st->actx->height;
+
+	SDL_DisplayYUVOverlay(dr_bmp, &rect);
+	return 0;
+    }
+
+    // 格式转换用的显示缓存在第一次要用时才分配，直接渲染中途换回了内部帧缓存(比如帧大小变了)时也是这样。
+    if (!bmp)
+    {
+	alloc_picture(is);
+	bmp = is->bmp;
+    }
+
+    /* if the frame is not skipped, then display it */
+    if (bmp)
+    {
+	SDL_Rect rect;
+
+	video_wait_display(is, pts);
+#if 1
+	/* get a pointer on the bitmap */
+	SDL_LockYUVOverlay(bmp);
+
+	dst_pix_fmt = PIX_FMT_YUV420P;
+	pict.data[0] = bmp->pixels[0];
+	pict.data[1] = bmp->pixels[2];
+	pict.data[2] = bmp->pixels[1];
+
+	pict.linesize[0] = bmp->pitches[0];
+	pict.linesize[1] = bmp->pitches[2];
+	pict.linesize[2] = bmp->pitches[1];
+
+	// 转换上下文在格式和大小不变时一直复用，中间格式的图像不用每帧分配。
+	is->img_convert_ctx = img_convert_ctx_get(is->img_convert_ctx,
+	    dst_pix_fmt,
+	    is->video_st->actx->pix_fmt,
+	    is->video_st->actx->width,
+	    is->video_st->actx->height);
+
+	// 显示缓存中已经是上一帧的图像时，只转换解码器报告的变化区域，没有变化就不用转换。
+	// 不支持的格式转换得不到上下文，显示缓存保持原样。
+	if (is->img_convert_ctx && src_frame->dirty_valid && is->bmp_picture_number >= 0 &&
+	    src_frame->coded_picture_number == is->bmp_picture_number + 1)
+	{
+	    if (src_frame->dirty_w > 0 && src_frame->dirty_h > 0)
+		img_convert_ctx_rect(is->img_convert_ctx, &pict, (AVPicture*)src_frame,
+		    src_frame->dirty_x, src_frame->dirty_y, src_frame->dirty_w, src_frame->dirty_h);
+	}
+	else if (is->img_convert_ctx)
+	{
+	    img_convert_ctx(is->img_convert_ctx, &pict, (AVPicture*)src_frame);
+	}
+	is->bmp_picture_number = src_frame->coded_picture_number;
+
+	SDL_UnlockYUVOverlay(bmp); /* update the bitmap content */
+
+	rect.x = 0;
+	rect.y = 0;
+	rect.w = is->video_st->actx->width;
+	rect.h = is->video_st->actx->height;
+	SDL_DisplayYUVOverlay(bmp, &rect);
+#endif
+    }
+    return 0;
+}
+// 解码得到的图像加一个引用放入图像队列，队列满时等待显示线程取走。
+static int queue_picture(VideoState *is, AVFrame *frame, double pts)
+{
+    VideoPicture *vp;
+
+    SDL_LockMutex(is->pictq_mutex);
+    while (is->pictq_size >= VIDEO_PICTURE_QUEUE_SIZE && !is->pictq_abort)
+	SDL_CondWait(is->pictq_cond, is->pictq_mutex);
+    if (is->pictq_abort)
+    {
+	SDL_UnlockMutex(is->pictq_mutex);
+	return  -1;
+    }
+    SDL_UnlockMutex(is->pictq_mutex);
+
+    // 队列不满时写位置上的图像只有解码线程会访问，不用加锁。
+    vp = &is->pictq[is->pictq_windex];
+    av_frame_ref(&vp->frame, frame);
+    vp->pts = pts;
+
+    SDL_LockMutex(is->pictq_mutex);
+    is->pictq_windex = (is->pictq_windex + 1) % VIDEO_PICTURE_QUEUE_SIZE;
+    is->pictq_size++;
+    SDL_CondSignal(is->pictq_cond);
+    SDL_UnlockMutex(is->pictq_mutex);
+    return 0;
+}
+
+// 视频显示线程，从图像队列取图像，等图像解码完成后做格式转换并按帧间隔显示，然后释放图像引用。
+// 和解码线程组成两级流水线，转换显示第N 帧的同时解码线程已经在解码第N+1 帧。
+static int video_refresh_thread(void *arg)
+{
+    VideoState *is = arg;
+    VideoPicture *vp;
+    int ret = 0;
+
+    // 显示表面都在本线程创建和释放。直接渲染时先创建好解码器用的显示表面，然后通知打开流的线程是否用直接渲染。
+    if (is->video_dr)
+	dr_create_overlays(is);
+    SDL_LockMutex(is->pictq_mutex);
+    is->dr_ready = 1;
+    SDL_CondBroadcast(is->pictq_cond);
+    SDL_UnlockMutex(is->pictq_mutex);
+
+    while (ret >= 0)
+    {
+	SDL_LockMutex(is->pictq_mutex);
+	while (is->pictq_size == 0 && !is->pictq_abort)
+	    SDL_CondWait(is->pictq_cond, is->pictq_mutex);
+	if (is->pictq_abort)
+	{
+	    SDL_UnlockMutex(is->pictq_mutex);
+	    break;
+	}
+	SDL_UnlockMutex(is->pictq_mutex);
+
+	vp = &is->pictq[is->pictq_rindex];
+	av_frame_await_progress(&vp->frame, AV_FRAME_PROGRESS_DONE);
+	ret = video_display(is, &vp->frame, vp->pts);
+	av_frame_unref(&vp->frame);
+
+	SDL_LockMutex(is->pictq_mutex);
+	is->pictq_rindex = (is->pictq_rindex + 1) % VIDEO_PICTURE_QUEUE_SIZE;
+	is->pictq_size--;
+	SDL_CondSignal(is->pictq_cond);
+	SDL_UnlockMutex(is->pictq_mutex);
+    }
+
+    free_overlays(is);
+    return 0;
+}
+
+// 通知解码和显示线程退出，在等待线程结束前调用。
+static void picture_queue_abort(VideoState *is)
+{
+    SDL_LockMutex(is->pictq_mutex);
+    is->pictq_abort = 1;
+    SDL_CondBroadcast(is->pictq_cond);
+    SDL_UnlockMutex(is->pictq_mutex);
+}
+
+// 释放图像队列中还没显示的图像引用，解码和显示线程都已退出后调用。
+static void picture_queue_end(VideoState *is)
+{
+    int i;
+
+    for (i = 0; i < VIDEO_PICTURE_QUEUE_SIZE; i++)
+	av_frame_unref(&is->pictq[i].frame);
+    is->pictq_size = 0;
+
+    SDL_DestroyCond(is->pictq_cond);
+    SDL_DestroyMutex(is->pictq_mutex);
+}
+
+// 视频解码线程，主要功能是分配解码帧缓存后进入解码循环(从队列中取数据帧，解码，计算时钟，送图像队列)，释放视频数据帧 / 数据包缓存。
+static int video_thread(void *arg)
+{
+    VideoState *is = arg;
+    AVPacket pkt1, *pkt = &pkt1;
+    int len1, got_picture;
+    double pts = 0;
+    // 分配解码帧缓存
+    AVFrame *frame = av_malloc(sizeof(AVFrame));
+    memset(frame, 0, sizeof(AVFrame));
+
+    for (;;)
+    {
+	// 从队列中取数据帧/数据包
+	if (packet_queue_get(&is->videoq, pkt, 1) < 0)
+	    break;
+
+	// 计算同步时钟
+	if (pkt->dts != AV_NOPTS_VALUE)
+	    pts = av_q2d(is->video_st->time_base) *pkt->dts;
+
+	// 实质性解码，落后时让解码器跳过不必要的输出。
+	SDL_LockMutex(is->video_decoder_mutex);
+	is->video_st->actx->skip_frame = video_skip_policy(is, pts);
+	len1 = avcodec_decode_video2(is->video_st->actx, frame, &got_picture, pkt);
+	SDL_UnlockMutex(is->video_decoder_mutex);
+
+	// 判断得到图像，送图像队列由显示线程转换和显示，解码线程马上回去解码下一包。
+	if (got_picture)
+	{
+	    if (queue_picture(is, frame, pts) < 0)
+	    {
+		av_free_packet(pkt);
+		goto the_end;
+	    }
+	}
+	// 释放视频数据帧/数据包内存，此数据包内存是在av_get_packet()函数中调用av_malloc()分配的。
+	av_free_packet(pkt);
+    }
+
+the_end:
+    av_free(frame);
+
+    SDL_LockMutex(is->pictq_mutex);
+    is->video_thread_done = 1;
+    SDL_CondBroadcast(is->pictq_cond);
+    SDL_UnlockMutex(is->pictq_mutex);
+    return 0;
+}
+// 解码一个音频帧，返回解压的数据大小，*audio_buf 指向解码后的数据。
+// 一个音频包可能包含多个音频帧，解码器自己保存没解完的数据包，这里只要先取帧，取不到再从队列取一包送进去。
+/* decode one audio frame and returns its uncompressed size */
+static int audio_decode_frame(VideoState *is, uint8_t **audio_buf, double *pts_ptr)
+{
+    AVCodecContext *dec = is->audio_st->actx;
+    AVPacket pkt;
+    int ret;
+
+    for (;;)
+    {
+	SDL_LockMutex(is->audio_decoder_mutex);
+	ret = avcodec_receive_frame(dec, &is->audio_frame);
+	SDL_UnlockMutex(is->audio_decoder_mutex);
+
+	if (ret == 0)
+	{
+	    // 返回解码后的数据大小。
+	    *audio_buf = is->audio_frame.data[0];
+	    return is->audio_frame.linesize[0];
+	}
+	// 解码出错时解码器已丢掉出错的数据包，接着送下一包。
+	if (ret == AVERROR_EOF)
+	    return  -1;
+
+	// 读取下一个数据包，数据包交给解码器后由解码器释放。
+	/* read next packet */
+	if (packet_queue_get(&is->audioq, &pkt, 1) < 0)
+	    return  -1;
+
+	SDL_LockMutex(is->audio_decoder_mutex);
+	ret = avcodec_send_packet(dec, &pkt);
+	SDL_UnlockMutex(is->audio_decoder_mutex);
+	if (ret < 0)
+	    av_free_packet(&pkt);
+    }
+}
+// 音频输出回调函数，每次音频输出缓存为空时，系统就调用此函数填充音频输出缓存。
+// 目前采用比较简单的同步方式，音频按照自己的节拍往前走即可，不需要synchronize_audio()函数同步处理。
+/* prepare a new audio buffer */
+void sdl_audio_callback(void *opaque, Uint8 *stream, int len)
+{
+    VideoState *is = opaque;
+    int audio_size, len1;
+    double pts = 0;
+
+    while (len > 0)
+    {
+	if (is->audio_buf_index >= is->audio_buf_size)
+	{
+	    // 如果解码后的数据已全部输出，就进行音频解码
+	    audio_size = audio_decode_frame(is, &is->audio_buf, &pts);
+	    if (audio_size < 0)
+	    {
+		/* if error, just output silence */
+		is->audio_buf = is->audio_silence;
+		is->audio_buf_size = sizeof(is->audio_silence);
+	    }
+	    else
+	    {
+		//              audio_size = synchronize_audio(is, (int16_t*)is->audio_buf, audio_size, pts);
+		is->audio_buf_size = audio_size;
+	    }
+	    is->audio_buf_index = 0;
+	}
+	// 拷贝适当的数据到输出缓存，并修改解码缓存的参数，进下一轮循环。
+	// 特别注意：由进下一轮循环可知，程序应填满SDL 库给出的输出缓存。
+	len1 = is->audio_buf_size - is->audio_buf_index;
+	if (len1 > len)
+	    len1 = len;
+	memcpy(stream, (uint8_t*)is->audio_buf + is->audio_buf_index, len1);
+	len -= len1;
+	stream += len1;
+	is->audio_buf_index += len1;
+    }
+}
+
+// 打开流模块，核心功能是打开相应codec，启动解码线程(我们把音频回调函数看做一个广义的线程)。
+/* open a given stream. Return 0 if OK */
+static int stream_component_open(VideoState *is, int stream_index)
+{
+    AVFormatContext *ic = is->ic;
+    AVCodecContext *enc;
+    AVCodec *codec;
+    SDL_AudioSpec wanted_spec, spec;
+
+    if (stream_index < 0 || stream_index >= ic->nb_streams)
+	return  -1;
+    // 找到从文件格式分析中得到的解码器上下文指针，便于引用其中的参数。
+    enc = ic->streams[stream_index]->actx;
+
+    /* prepare audio output */
+    if (enc->codec_type == CODEC_TYPE_AUDIO)
+    {
+	// 初始化音频输出参数，并调用SDL_OpenAudio()设置到SDL 库。
+	wanted_spec.freq = enc->sample_rate;
+	wanted_spec.format = AUDIO_S16SYS;
+	/* hack for AC3. XXX: suppress that */
+	if (enc->channels > 2)
+	    enc->channels = 2;
+	wanted_spec.channels = enc->channels;
+	wanted_spec.silence = 0;
+	wanted_spec.samples = 1024; //SDL_AUDIO_BUFFER_SIZE;
+	wanted_spec.callback = sdl_audio_callback; // 音频线程的回调函数
+	wanted_spec.userdata = is;
+	if (SDL_OpenAudio(&wanted_spec, &spec) < 0)
+	{
+	    // wanted_spec 是应用程序设定给SDL 库的音频参数，spec 是SDL 库返回给应用程序它能支持的音频参数，通常是一致的。
+	    // 如果超过SDL 支持的参数范围，会返回最相近的参数。
+	    fprintf(stderr, "SDL_OpenAudio: %s\n", SDL_GetError());
+	    return  -1;
+	}
+    }
+
+    // 依照编解码上下文的codec_id，遍历编解码器链表，找到相应的功能函数。
+    codec = avcodec_find_decoder(enc->codec_id);
+
+    // 让支持的解码器直接输出显示表面的格式，这样可以直接渲染，不必再做格式转换。
+    if (enc->codec_type == CODEC_TYPE_VIDEO)
+	enc->request_pix_fmt = PIX_FMT_YUV420P;
+
+    // 核心功能之一,打开编解码器，初始化具体编解码器的运行环境。
+    if (!codec || avcodec_open(enc, codec) < 0)
+	return  -1;
+
+    switch (enc->codec_type)
+    {
+    case CODEC_TYPE_AUDIO:
+	// 在VideoState 中记录音频流参数。
+	is->audio_stream = stream_index;
+	is->audio_st = ic->streams[stream_index];
+	is->audio_buf_size = 0;
+	is->audio_buf_index = 0;
+	// 初始化音频队列
+	memset(&is->audio_frame, 0, sizeof(is->audio_frame));
+	packet_queue_init(&is->audioq);
+	SDL_PauseAudio(0);	// 启动广义的音频解码线程。
+	break;
+    case CODEC_TYPE_VIDEO:
+	// 在VideoState 中记录视频流参数。
+	is->video_stream = stream_index;
+	is->video_st = ic->streams[stream_index];
+
+	is->frame_last_delay = is->video_st->frame_last_delay;
+	// 初始化视频队列
+	packet_queue_init(&is->videoq);
+	// 初始化图像队列
+	is->pictq_mutex = SDL_CreateMutex();
+	is->pictq_cond = SDL_CreateCond();
+
+	// 解码器输出格式和显示表面一致时尝试直接渲染，帧缓存池的缓存由显示线程创建的SDL 显示表面提供。
+	// 先启动显示线程创建显示表面，等它决定能否直接渲染后再启动解码线程。
+	// 帧大小变化时解码器会自动换回库内部分配的帧缓存，显示时再走格式转换。
+	is->video_dr = enc->pix_fmt == PIX_FMT_YUV420P;
+	is->refresh_tid = SDL_CreateThread(video_refresh_thread, is);		// 启动视频显示线程。
+	SDL_LockMutex(is->pictq_mutex);
+	while (!is->dr_ready)
+	    SDL_CondWait(is->pictq_cond, is->pictq_mutex);
+	SDL_UnlockMutex(is->pictq_mutex);
+	if (is->video_dr)
+	{
+	    enc->frame_pool = av_frame_pool_create_external(enc->pix_fmt, enc->width, enc->height,
+		dr_alloc_overlay, NULL, is);
+	    is->video_dr = enc->frame_pool != NULL;
+	}
+	is->video_tid = SDL_CreateThread(video_thread, is);			// 直接启动视频解码线程。
+	break;
+    default:
+	break;
+    }
+    return 0;
+}
+// 关闭流模块，停止解码线程，释放队列资源。
+// 通过packet_queue_abort()函数置abort_request 标志位，解码线程判别此标志位并安全退出线程。
+static void stream_component_close(VideoState *is, int stream_index)
+{
+    AVFormatContext *ic = is->ic;
+    AVCodecContext *enc;
+    // 简单的流索引参数校验。
+    if (stream_index < 0 || stream_index >= ic->nb_streams)
+	return;
+    // 找到从文件格式分析中得到的解码器上下文指针，便于引用其中的参数。
+    enc = ic->streams[stream_index]->actx;
+
+    switch (enc->codec_type)
+    {
+	// 停止解码线程，释放队列资源。
+    case CODEC_TYPE_AUDIO:
+	packet_queue_abort(&is->audioq);
+	SDL_CloseAudio();
+	packet_queue_end(&is->audioq);
+	break;
+    case CODEC_TYPE_VIDEO:
+	packet_queue_abort(&is->videoq);
+	picture_queue_abort(is);
+	SDL_WaitThread(is->video_tid, NULL);
+	SDL_WaitThread(is->refresh_tid, NULL);
+	packet_queue_end(&is->videoq);
+	picture_queue_end(is);
+	break;
+    default:
+	break;
+    }
+    // 释放编解码器上下文资源
+    avcodec_close(enc);
+}
+// 文件解析线程，函数名有点不名副其实。完成三大功能，直接识别文件格式和间接识别媒体格式，打开具体的编解码器并启动解码线程，分离音视频媒体包并挂接到相应队列。
+static int decode_thread(void *arg)
+{
+    VideoState *is = arg;
+    AVFormatContext *ic;
+    int err, i, ret, video_index, audio_index;
+    AVPacket pkts[MAX_READ_BATCH], audio_pkts[MAX_READ_BATCH], video_pkts[MAX_READ_BATCH];
+    int nb_pkts, nb_audio, nb_video;
+    AVFormatParameters params, *ap = &params;
+
+    int flags = SDL_HWSURFACE | SDL_ASYNCBLIT | SDL_HWACCEL | SDL_RESIZABLE;
+
+    // 初始化基本变量指示没有相应的流。
+    video_index = -1;
+    audio_index = -1;
+
+    is->video_stream = -1;
+    is->audio_stream = -1;
+
+    memset(ap, 0, sizeof(*ap));
+    // 调用函数直接识别文件格式，在此函数中再调用其他函数间接识别媒体格式。
+    err = av_open_input_file(&ic, is->filename, NULL, 0, ap);
+    if (err < 0)
+    {
+	ret = -1;
+	goto fail;
+    }
+    // 保存文件格式上下文，便于各数据结构间跳转。
+    is->ic = ic;
+
+    for (i = 0; i < ic->nb_streams; i++)
+    {
+	AVCodecContext *enc = ic->streams[i]->actx;
+	switch (enc->codec_type)
+	{
+	    // 保存音视频流索引，并把显示视频参数设置到SDL 库。
+	case CODEC_TYPE_AUDIO:
+	    if (audio_index < 0)
+		audio_index = i;
+	    break;
+	case CODEC_TYPE_VIDEO:
+	    if (video_index < 0)
+		video_index = i;
+
+	    screen = SDL_SetVideoMode(enc->width, enc->height, 0, flags);
+
+	    SDL_WM_SetCaption("FFplay", "FFplay"); // 修改是为了适配视频大小
+
+//          schedule_refresh(is, 40);
+	    break;
+	default:
+	    break;
+	}
+    }
+    // 只播放选中的第一路音频流和视频流，其余流交给解复用器直接跳过，不再读取和分配数据包。
+    for (i = 0; i < ic->nb_streams; i++)
+    {
+	if (i != audio_index && i != video_index)
+	    ic->streams[i]->discard = AVDISCARD_ALL;
+    }
+    // 如果有音频流，就调用函数打开音频编解码器并启动音频广义解码线程。
+    if (audio_index >= 0)
+	stream_component_open(is, audio_index);
+    // 如果有视频流，就调用函数打开视频编解码器并启动视频解码线程。
+    if (video_index >= 0)
+	stream_component_open(is, video_index);
+    // 如果既没有音频流，又没有视频流，就设置错误码返回。
+    if (is->video_stream < 0 && is->audio_stream < 0)
+    {
+	fprintf(stderr, "%s: could not open codecs\n", is->filename);
+	ret = -1;
+	goto fail;
+    }
+
+    for (;;)
+    {
+	if (is->abort_request) {
+	    // 如果异常退出请求置位，就退出文件解析线程。
+	    break;
+	}
+
+
+	if (is->audioq.size > MAX_AUDIOQ_SIZE || is->videoq.size > MAX_VIDEOQ_SIZE || url_feof(&ic->pb))
+	{
+	    // 如果队列满，就稍微延时一下。
+	    SDL_Delay(10); // if the queue are full, no need to read more,wait 10 ms
+	    continue;
+	}
+	// 从媒体文件中批量读取完整的音视频数据包，一次调用尽量取出同一缓存窗口内的多个包。
+	ret = av_read_packets(ic, pkts, MAX_READ_BATCH, &nb_pkts);
+	if (ret < 0)
+	{
+	    if (url_ferror(&ic->pb) == 0)
+	    {
+		SDL_Delay(100); // wait for user event
+		continue;
+	    }
+	    else
+		break;
+	}
+	// 判断包数据的类型，按队列分组后每个队列只加一次锁批量挂接，如果是不识别的类型，就直接释放丢弃掉。
+	nb_audio = nb_video = 0;
+	for (i = 0; i < nb_pkts; i++)
+	{
+	    if (pkts[i].stream_index == is->audio_stream)
+		audio_pkts[nb_audio++] = pkts[i];
+	    else if (pkts[i].stream_index == is->video_stream)
+		video_pkts[nb_video++] = pkts[i];
+	    else
+		av_free_packet(&pkts[i]);
+	}
+
+	if (packet_queue_put_batch(&is->audioq, audio_pkts, nb_audio) < 0)
+	{
+	    for (i = 0; i < nb_audio; i++)
+		av_free_packet(&audio_pkts[i]);
+	}
+	if (packet_queue_put_batch(&is->videoq, video_pkts, nb_video) < 0)
+	{
+	    for (i = 0; i < nb_video; i++)
+		av_free_packet(&video_pkts[i]);
+	}
+    }
+    // 简单的延时，让后面的线程有机会把数据解码显示完。当然丢弃掉最后的一点点数据也可以。
+    while (!is->abort_request)   // wait until the end
+    {
+	SDL_Delay(100);
+    }
+
+    ret = 0;
+
+    // 释放掉在本线程中分配的各种资源，体现了谁申请谁释放的程序自封闭性。
+fail:
+    if (is->audio_stream >= 0)
+	stream_component_close(is, is->audio_stream);
+
+    if (is->video_stream >= 0)
+	stream_component_close(is, is->video_stream);
+
+    if (is->ic)
+    {
+	av_close_input_file(is->ic);
+	is->ic = NULL;
+    }
+
+    if (ret != 0)
+    {
+	SDL_Event event;
+
+	event.type = FF_QUIT_EVENT;
+	event.user.data1 = is;
+	SDL_PushEvent(&event);
+    }
+    return 0;
+}
+
+// 打开流。主要功能是分配全局总控数据结构，初始化相关参数，启动文件解析线程。
+static VideoState *stream_open(const char *filename, AVInputFormat *iformat)
+{
+    VideoState *is;
+
+    is = av_mallocz(sizeof(VideoState));
+    if (!is)
+	return NULL;
+    pstrcpy(is->filename, sizeof(is->filename), filename);
+
+    is->audio_decoder_mutex = SDL_CreateMutex();
+    is->video_decoder_mutex = SDL_CreateMutex();
+
+    is->parse_tid = SDL_CreateThread(decode_thread, is);
+    if (!is->parse_tid)
+    {
+	av_free(is);
+	return NULL;
+    }
+    return is;
+}
+// 关闭流。主要功能是释放资源。
+static void stream_close(VideoState *is)
+{
+    is->abort_request = 1;
+    SDL_WaitThread(is->parse_tid, NULL);
+
+    img_convert_ctx_free(is->img_convert_ctx);
+    is->img_convert_ctx = NULL;
+
+    SDL_DestroyMutex(is->audio_decoder_mutex);
+    SDL_DestroyMutex(is->video_decoder_mutex);
+
+    av_free(is);
+}
+
+// 程序退出时调用的函数，关闭释放一些资源。
+void do_exit(void)
+{
+    if (cur_stream)
+    {
+	stream_close(cur_stream);
+	cur_stream = NULL;
+    }
+    av_packet_pool_free();
+
+    SDL_Quit();
+    exit(0);
+}
+// SDL 库的消息事件循环。
+void event_loop(void) // handle an event sent by the GUI
+{
+    SDL_Event event;
+
+    for (;;)
+    {
+	SDL_WaitEvent(&event);
+	switch (event.type)
+	{
+	case SDL_KEYDOWN:
+	    switch (event.key.keysym.sym)
+	    {
+	    case SDLK_ESCAPE:
+	    case SDLK_q:
+		do_exit();
+		break;
+	    default:
+		break;
+	    }
+	    break;
+	case SDL_QUIT:
+	case FF_QUIT_EVENT:
+	    do_exit();
+	    break;
+	default:
+	    break;
+	}
+    }
+}
+// 入口函数，初始化SDL 库，注册SDL 消息事件，启动文件解析线程，进入消息循环。
+int main(int argc, char **argv)
+{
+    int flags = SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_TIMER;
+
+    av_register_all();
+
+    input_filename = "D:\\workspace\\ffsrc\\CLOCKTXT_320.avi";
+
+    if (SDL_Init(flags))
+	exit(1);
+
+    SDL_EventState(SDL_ACTIVEEVENT, SDL_IGNORE);
+    SDL_EventState(SDL_MOUSEMOTION, SDL_IGNORE);
+    SDL_EventState(SDL_SYSWMEVENT, SDL_IGNORE);
+    SDL_EventState(SDL_USEREVENT, SDL_IGNORE);
+
+    cur_stream = stream_open(input_filename, file_iformat);
+
+    event_loop();
+
+    return 0;
+}
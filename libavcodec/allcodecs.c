@@ -1,19 +1,22 @@
-#include "avcodec.h"
-
-extern AVCodec truespeech_decoder;
-extern AVCodec msrle_decoder;
-
-// 򵥵ע/ʼѱӦڲʶ
-void avcodec_register_all(void)
-{
-    static int inited = 0;
-
-    if (inited != 0)
-	return;
-
-    inited = 1;
-    // msrle_decoder ӵͷָfirst_avcodec
-    register_avcodec(&msrle_decoder);
-    // truespeech_decoder ӵͷָfirst_avcodec
-    register_avcodec(&truespeech_decoder);
-}
+#include "avcodec.h"
+
+extern AVCodec truespeech_decoder;
+extern AVCodec msrle_decoder;
+extern AVCodec msrle_encoder;
+
+// 简单的注册/初始化函数，把编解码器用相应的链表串起来便于查找识别。
+void avcodec_register_all(void)
+{
+    static int inited = 0;
+
+    if (inited != 0)
+	return;
+
+    inited = 1;
+    // 把msrle_decoder 解码器串接到解码器链表，链表头指针是first_avcodec。
+    register_avcodec(&msrle_decoder);
+    // 把msrle_encoder 编码器串接到同一个链表，avcodec_find_encoder 按encode 函数区分编码器。
+    register_avcodec(&msrle_encoder);
+    // 把truespeech_decoder 解码器串接到解码器链表，链表头指针是first_avcodec。
+    register_avcodec(&truespeech_decoder);
+}
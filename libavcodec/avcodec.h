@@ -1,189 +1,305 @@
-#ifndef AVCODEC_H
-#define AVCODEC_H
-
-#ifdef __cplusplus
-extern "C"
-{
-#endif
-
-#include "../libavutil/avutil.h"
-
-    // ʹõĺꡢݽṹͺͨЩꡢݽṹͺڴģȫЧ
-
-    // Ͱ汾Ϣйصļ궨
-#define FFMPEG_VERSION_INT      0x000409
-#define FFMPEG_VERSION          "CVS"
-
-#define AV_STRINGIFY(s)         AV_TOSTRING(s)
-#define AV_TOSTRING(s) #s
-
-#define LIBAVCODEC_VERSION_INT  ((51<<16)+(8<<8)+0)
-#define LIBAVCODEC_VERSION      51.8.0
-#define LIBAVCODEC_BUILD        LIBAVCODEC_VERSION_INT
-
-#define LIBAVCODEC_IDENT        "Lavc" AV_STRINGIFY(LIBAVCODEC_VERSION)
-
-#define AV_NOPTS_VALUE          int64_t_C(0x8000000000000000)
-#define AV_TIME_BASE            1000000
-// https://github.com/feixiao/ffmpeg-2.8.11/blob/master/libavcodec/avcodec.h
-// AVCodecID 
-
-// Codec ID 궨壬ffplay ֻ֧codecĶɾˡ
-    enum CodecID
-    {
-	CODEC_ID_TRUESPEECH,
-	CODEC_ID_MSRLE,
-	CODEC_ID_NONE
-    };
-    // Codec Ͷ壬ffplay ֻ֧ƵƵ
-    enum CodecType
-    {
-	CODEC_TYPE_UNKNOWN = -1,
-	CODEC_TYPE_VIDEO,
-	CODEC_TYPE_AUDIO,
-	CODEC_TYPE_DATA
-    };
-
-#define AVCODEC_MAX_AUDIO_FRAME_SIZE 192000 // 1 second of 48khz 32bit audio
-
-#define FF_INPUT_BUFFER_PADDING_SIZE 8
-
-    // AVPicture AVFrame Ҫʾеʹû棬ͨ֡YUV ʽ
-    // ʽYUV,ҲRGB ʽԶ4 data ָʾ
-    typedef struct AVPicture
-    {
-	uint8_t *data[4];
-	int linesize[4];
-    } AVPicture;
-
-    typedef struct AVFrame
-    {
-	uint8_t *data[4];		// ж壬һNULL жǷռ
-	int linesize[4];
-	uint8_t *base[4];		// ж壬һNULL жǷڴ
-    } AVFrame;
-
-    // AVCodecContextṹʾеĵǰCodecʹõģCodecе(ڳʱȷֵ)͹ṹֶΡ
-    // codec priv_data ṹֶΣݽṹת
-    typedef struct AVCodecContext
-    {
-	int bit_rate;
-	int frame_number;		// audio or video frame number
-
-	unsigned char *extradata;	// Codec˽ݣAudioWAVEFORMATEXṹչֽڡ
-	int extradata_size;		// VideoBITMAPINFOHEADERչֽ
-
-	int width, height;		// video only
-
-	enum PixelFormat pix_fmt;	// ظʽ/Ƶͼʽ
-
-	int sample_rate;		// samples per sec  // audio only
-	int channels;
-	int bits_per_sample;
-	int block_align;
-
-	struct AVCodec *codec;		// ָCodec ָ
-	void *priv_data;		// AVCodecṹеpriv_data_size ʹ
-
-	enum CodecType codec_type;	// see CODEC_TYPE_xxx
-	enum CodecID codec_id;		// see CODEC_ID_xxx
-
-	int(*get_buffer)(struct AVCodecContext *c, AVFrame *pic);
-	void(*release_buffer)(struct AVCodecContext *c, AVFrame *pic);
-	int(*reget_buffer)(struct AVCodecContext *c, AVFrame *pic);
-
-	int internal_buffer_count;
-	void *internal_buffer;
-
-	struct AVPaletteControl *palctrl;
-    }AVCodecContext;
-
-    // ʾƵڹܺһýͶӦһAVCodecṹڳʱжʵڲҡ
-    typedef struct AVCodec
-    {
-	const char *name;				// ʾCodec
-	enum CodecType type;				// ʾCodecͣVideo AudioData 
-	enum CodecID id;				// ʾCodecIDCODEC_ID_MSRLECODEC_ID_TRUESPEECH 
-	int priv_data_size;				// ʾCodecӦContextĴС
-
-	// ʾCodecṩĲ
-	int(*init)(AVCodecContext*);
-	int(*encode)(AVCodecContext *, uint8_t *buf, int buf_size, void *data);
-	int(*close)(AVCodecContext*);
-	int(*decode)(AVCodecContext *, void *outdata, int *outdata_size, uint8_t *buf, int buf_size);
-	int capabilities;				// ʾCodecffplayû̫ãɺ
-
-	struct AVCodec *next;				// ڰCodecһڱ
-    }AVCodec;
-
-    // ɫСʹС궨壬ÿɫֽ(R,G,B,)
-    // кܶƵͼɫȽ٣ӱʾÿصɫֵͿõɫֵʵּ򵥵ĴԼ4:1 ѹȡ
-#define AVPALETTE_SIZE 1024
-#define AVPALETTE_COUNT 256
-// ɫݽṹ壬ɫݡ
-    typedef struct AVPaletteControl
-    {
-	// demuxer sets this to 1 to indicate the palette has changed; decoder resets to 0
-	int palette_changed;
-
-	/* 4-byte ARGB palette entries, stored in native byte order; note that
-	 * the individual palette components should be on a 8-bit scale; if
-	 * the palette data comes from a IBM VGA native format, the component
-	 * data is probably 6 bits in size and needs to be scaled */
-	unsigned int palette[AVPALETTE_COUNT];
-
-    } AVPaletteControl;
-
-    // ʹõĺ
-    int avpicture_alloc(AVPicture *picture, int pix_fmt, int width, int height);
-
-    void avpicture_free(AVPicture *picture);
-
-    int avpicture_fill(AVPicture *picture, uint8_t *ptr, int pix_fmt, int width, int height);
-    int avpicture_get_size(int pix_fmt, int width, int height);
-    void avcodec_get_chroma_sub_sample(int pix_fmt, int *h_shift, int *v_shift);
-
-    int img_convert(AVPicture *dst, int dst_pix_fmt, const AVPicture *src, int pix_fmt,
-	int width, int height);
-
-    void avcodec_init(void);
-
-    void register_avcodec(AVCodec *format);
-    AVCodec *avcodec_find_decoder(enum CodecID id);
-
-    AVCodecContext *avcodec_alloc_context(void);
-
-    int avcodec_default_get_buffer(AVCodecContext *s, AVFrame *pic);
-    void avcodec_default_release_buffer(AVCodecContext *s, AVFrame *pic);
-    int avcodec_default_reget_buffer(AVCodecContext *s, AVFrame *pic);
-    void avcodec_align_dimensions(AVCodecContext *s, int *width, int *height);
-    int avcodec_check_dimensions(void *av_log_ctx, unsigned int w, unsigned int h);
-
-    int avcodec_open(AVCodecContext *avctx, AVCodec *codec);
-
-    int avcodec_decode_audio(AVCodecContext *avctx, int16_t *samples, int *frame_size_ptr,
-	uint8_t *buf, int buf_size);
-    int avcodec_decode_video(AVCodecContext *avctx, AVFrame *picture, int *got_picture_ptr,
-	uint8_t *buf, int buf_size);
-
-    int avcodec_close(AVCodecContext *avctx);
-
-    void avcodec_register_all(void);
-
-    void avcodec_default_free_buffers(AVCodecContext *s);
-
-    void *av_malloc(unsigned int size);
-    void *av_mallocz(unsigned int size);
-    void *av_realloc(void *ptr, unsigned int size);
-    void av_free(void *ptr);
-    void av_freep(void *ptr);
-    void *av_fast_realloc(void *ptr, unsigned int *size, unsigned int min_size);
-
-    void img_copy(AVPicture *dst, const AVPicture *src, int pix_fmt, int width, int height);
-
-#ifdef __cplusplus
-}
-
-#endif
-
-#endif
+#ifndef AVCODEC_H
+#define AVCODEC_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "../libavutil/avutil.h"
+
+    // 定义编解码器库使用的宏、数据结构和函数，通常这些宏、数据结构和函数在此模块内相对全局有效。
+
+    // 和版本信息有关的几个宏定义
+#define FFMPEG_VERSION_INT      0x000409
+#define FFMPEG_VERSION          "CVS"
+
+#define AV_STRINGIFY(s)         AV_TOSTRING(s)
+#define AV_TOSTRING(s) #s
+
+#define LIBAVCODEC_VERSION_INT  ((51<<16)+(8<<8)+0)
+#define LIBAVCODEC_VERSION      51.8.0
+#define LIBAVCODEC_BUILD        LIBAVCODEC_VERSION_INT
+
+#define LIBAVCODEC_IDENT        "Lavc" AV_STRINGIFY(LIBAVCODEC_VERSION)
+
+#define AV_NOPTS_VALUE          int64_t_C(0x8000000000000000)
+#define AV_TIME_BASE            1000000
+#define AV_FRAME_PROGRESS_DONE  0x7fffffff	// 帧解码进度的最大值，表示整帧完成
+
+// 送包/取帧解码接口的返回码，接着avformat.h 中的AVERROR_xxx 往下编号。
+#define AVERROR_AGAIN           (-8)	// 需要先取走输出(送包时)或先送入新数据包(取帧时)
+#define AVERROR_EOF             (-9)	// 解码器已排空，不会再有输出
+// https://github.com/feixiao/ffmpeg-2.8.11/blob/master/libavcodec/avcodec.h
+// AVCodecID 
+
+// Codec ID 宏定义，瘦身后的ffplay 只支持这两种codec，其他的都删掉了。
+    enum CodecID
+    {
+	CODEC_ID_TRUESPEECH,
+	CODEC_ID_MSRLE,
+	CODEC_ID_NONE
+    };
+    // Codec 类型定义，瘦身后的ffplay 只支持视频和音频。
+    enum CodecType
+    {
+	CODEC_TYPE_UNKNOWN = -1,
+	CODEC_TYPE_VIDEO,
+	CODEC_TYPE_AUDIO,
+	CODEC_TYPE_DATA
+    };
+    // 丢弃级别定义，数值越大丢弃得越多，ffplay 用来跳过不需要的媒体流，也用作解码器的跳帧策略(AVCodecContext.skip_frame)。
+    enum AVDiscard
+    {
+	AVDISCARD_NONE = -16,	// discard nothing
+	AVDISCARD_DEFAULT = 0,	// discard useless packets like 0 size packets in avi
+	AVDISCARD_NONREF = 8,	// discard all non reference
+	AVDISCARD_NONKEY = 32,	// discard all frames except keyframes
+	AVDISCARD_ALL = 48,	// discard all
+    };
+
+#define AVCODEC_MAX_AUDIO_FRAME_SIZE 192000 // 1 second of 48khz 32bit audio
+
+#define FF_INPUT_BUFFER_PADDING_SIZE 8
+
+    // AVPicture 和AVFrame 主要表示解码过程中的使用缓存，通常帧缓存是YUV 格式，
+    // 输出格式有YUV,也有RGB 格式，所以定义了4 个data 指针来表示分量。
+    typedef struct AVPicture
+    {
+	uint8_t *data[4];
+	int linesize[4];
+    } AVPicture;
+
+    typedef struct AVFrame
+    {
+	uint8_t *data[4];		// 有多重意义，其一用NULL 来判断是否被占用
+	int linesize[4];
+	uint8_t *base[4];		// 有多重意义，其一用NULL 来判断是否分配内存
+	struct AVFrameBuf *buf;		// 引用计数的帧缓存，NULL 表示图像内存不归帧缓存池管理
+	int nb_samples;			// 音频帧每声道的采样数，data[0] 是交错的16 位采样，linesize[0] 是字节数
+
+	int coded_picture_number;	// 帧在码流中的序号，由avcodec_decode_video 填写，跳过不输出的帧也占序号
+	int dirty_valid;		// 为1 时下面的区域有效，为0 表示解码器没有报告，按整帧都变了处理
+	int dirty_x, dirty_y, dirty_w, dirty_h;	// 相对同一解码器上一输出帧变化过的矩形区域，宽或高为0 表示没有变化
+	int key_frame;			// 编码器输出的帧是否是关键帧(不依赖前面的帧就能解码)
+    } AVFrame;
+
+    // 内存分配统计，全局一份，另外每个媒体流一份(AVStream.mem_stats)，字段用原子操作更新。
+    // 分配时计入本线程当前设置的流统计(av_mem_stats_set_current)，释放时从同一个统计中扣除，与释放线程无关。
+    typedef struct AVMemStats
+    {
+	volatile int64_t cur_bytes;	// 当前占用字节数(按请求大小计算)
+	volatile int64_t peak_bytes;	// 占用字节数峰值
+	volatile int64_t nb_allocs;	// 累计分配次数
+	volatile int64_t nb_frees;	// 累计释放次数
+	volatile int64_t large_bytes;	// 当前整页映射(可能是大页)占用的字节数
+	volatile int64_t refs;		// 所有者引用加上未释放的分配数，降为0 时释放统计结构
+    } AVMemStats;
+
+    // AVCodecContext结构表示程序运行的当前Codec使用的上下文，着重于所有Codec共有的属性(并且是在程序运行时才能确定其值)和关联其他结构的字段。
+    // codec 和priv_data 关联其他结构的字段，便于在数据结构间跳转。
+    typedef struct AVCodecContext
+    {
+	int bit_rate;
+	int frame_number;		// audio or video frame number
+
+	unsigned char *extradata;	// Codec的私有数据，对Audio是WAVEFORMATEX结构扩展字节。
+	int extradata_size;		// 对Video是BITMAPINFOHEADER后的扩展字节
+
+	int width, height;		// video only
+
+	enum PixelFormat pix_fmt;	// 输出像素格式/视频图像格式
+	enum PixelFormat request_pix_fmt;	// 希望解码器直接输出的像素格式，打开解码器前设置，解码器不支持时忽略，PIX_FMT_NONE 表示不要求
+	enum AVDiscard skip_frame;	// 跳帧策略，解码每一包前都可以修改。跳过的帧不输出图像，参考帧仍然要解码，下一个输出帧才正确
+
+	int sample_rate;		// samples per sec  // audio only
+	int channels;
+	int bits_per_sample;
+	int block_align;
+
+	struct AVCodec *codec;		// 指向Codec 的指针
+	void *priv_data;		// AVCodec结构中的priv_data_size 配对使用
+
+	enum CodecType codec_type;	// see CODEC_TYPE_xxx
+	enum CodecID codec_id;		// see CODEC_ID_xxx
+
+	int(*get_buffer)(struct AVCodecContext *c, AVFrame *pic);
+	void(*release_buffer)(struct AVCodecContext *c, AVFrame *pic);
+	int(*reget_buffer)(struct AVCodecContext *c, AVFrame *pic);
+
+	struct AVFramePool *frame_pool;	// 帧缓存池，几何参数相同的上下文可以共享
+
+	struct AVPaletteControl *palctrl;	// 初始调色板，打开解码器前由解复用器填好，之后只读
+
+	AVMemStats *mem_stats;		// 解码期间的内存分配计入此统计，通常指向所属流的统计，可为NULL
+
+	struct AVPacket *pkt;		// 当前正在解码的数据包，解码器由此读取包附带的调色板等附加数据，可为NULL
+
+	struct AVDecodeQueue *decode_queue;	// 送包/取帧接口保存的待解码数据包和音频输出缓存，第一次送包时分配
+
+	int gop_size;			// 编码器的关键帧间隔，0 表示只有第一帧是关键帧
+	int thread_count;		// 编码器最多使用的线程数(包括调用线程)
+	AVFrame *coded_frame;		// 编码器最近输出的一帧的信息，由编码器维护
+    }AVCodecContext;
+
+    // 表示音视频编解码器，着重于功能函数，一种媒体类型对应一个AVCodec结构，在程序运行时有多个实例串联成链表便于查找。
+    typedef struct AVCodec
+    {
+	const char *name;				// 标示Codec的名字
+	enum CodecType type;				// 标示Codec的类型，有Video ，Audio，Data 等类型
+	enum CodecID id;				// 标示Codec的ID，有CODEC_ID_MSRLE，CODEC_ID_TRUESPEECH 等
+	int priv_data_size;				// 标示具体的Codec对应的Context的大小
+
+	// 标示Codec对外提供的操作
+	int(*init)(AVCodecContext*);
+	int(*encode)(AVCodecContext *, uint8_t *buf, int buf_size, void *data);
+	int(*close)(AVCodecContext*);
+	int(*decode)(AVCodecContext *, void *outdata, int *outdata_size, uint8_t *buf, int buf_size);
+	// 多个独立的流一起解码，每个上下文一个数据包，consumed 返回每个流消耗的字节数，可以为NULL
+	int(*decode_batch)(AVCodecContext **, int count, int16_t **samples, int *frame_size_ptr, int *consumed,
+	    uint8_t **buf, int buf_size);
+	// 送包/取帧接口的解码器实现，可以为NULL，这时由通用代码保存数据包，每次用decode 解码剩下的部分。
+	// send_packet 收下数据包(连同数据内存)，上一个包还没解完时返回AVERROR_AGAIN；receive_frame 每次输出一帧，
+	// 数据包解到哪里由解码器自己记录，解完后返回AVERROR_AGAIN。输入结束由通用代码处理，空包不送给解码器。
+	int(*send_packet)(AVCodecContext *, struct AVPacket *pkt);
+	int(*receive_frame)(AVCodecContext *, AVFrame *frame);
+	int capabilities;				// 标示Codec的能力，在瘦身后的ffplay中没太大作用，可忽略
+
+	struct AVCodec *next;				// 用于把所有Codec串成一个链表，便于遍历
+    }AVCodec;
+
+    // 调色板大小和大小宏定义，每个调色板四字节(R,G,B,α)。
+    // 有很多的视频图像颜色种类比较少，用索引间接表示每个像素的颜色值，就可以用调色板和索引值实现简单的大约的4:1 压缩比。
+#define AVPALETTE_SIZE 1024
+#define AVPALETTE_COUNT 256
+// 调色板数据结构定义，保存调色板数据。
+    typedef struct AVPaletteControl
+    {
+	// demuxer sets this to 1 to indicate the palette has changed; decoder resets to 0
+	int palette_changed;
+
+	/* 4-byte ARGB palette entries, stored in native byte order; note that
+	 * the individual palette components should be on a 8-bit scale; if
+	 * the palette data comes from a IBM VGA native format, the component
+	 * data is probably 6 bits in size and needs to be scaled */
+	unsigned int palette[AVPALETTE_COUNT];
+
+    } AVPaletteControl;
+
+#define PKT_FLAG_KEY		0x0001
+
+// 代表音视频数据帧，固有的属性是一些标记，时钟信息，和压缩数据首地址，大小等信息。
+// 音视频数据包定义，在瘦身后的ffplay 中，每一个包是一个完整的数据帧。
+// 注意保存音视频数据包的内存是malloc 出来的，用完后应及时用free 归还给系统。
+    typedef struct AVPacket
+    {
+	int64_t pts;		// 表示时间，对视频是显示时间
+	int64_t dts;		// 解码时间，这个不是很重要?
+	int64_t pos;		// byte position in stream, -1 if unknown
+	uint8_t *data;		// 实际保存音视频数据缓存的首地址
+	int size;		// 实际保存音视频数据缓存的大小
+	int stream_index;	// 当前音视频数据包对应的流索引，在本例中用于区别音频还是视频。
+	int flags;		// 数据包的一些标记，比如是否是关键帧等。
+	uint32_t *palette;	// 调色板变化时附带的新调色板(AVPALETTE_COUNT 项)，没有变化时为NULL，随包一起释放
+	int palette_version;	// 调色板版本号，解码器据此判断是否需要更新调色板
+	void(*destruct)(struct AVPacket*);
+    } AVPacket;
+
+    // 编解码库使用的函数声明。
+    int avpicture_alloc(AVPicture *picture, int pix_fmt, int width, int height);
+
+    void avpicture_free(AVPicture *picture);
+
+    int avpicture_fill(AVPicture *picture, uint8_t *ptr, int pix_fmt, int width, int height);
+    int avpicture_get_size(int pix_fmt, int width, int height);
+    void avcodec_get_chroma_sub_sample(int pix_fmt, int *h_shift, int *v_shift);
+
+    int img_convert(AVPicture *dst, int dst_pix_fmt, const AVPicture *src, int pix_fmt,
+	int width, int height);
+    int img_convert_rect(AVPicture *dst, int dst_pix_fmt, const AVPicture *src, int pix_fmt,
+	int width, int height, int x, int y, int w, int h);
+
+    // 格式转换上下文，按(目标格式, 源格式, 宽, 高) 一次确定转换链并保留中间图像，反复转换同样的图像时不再分配内存。
+    typedef struct ImgConvertContext ImgConvertContext;
+
+    ImgConvertContext *img_convert_ctx_get(ImgConvertContext *ctx, int dst_pix_fmt, int src_pix_fmt, int width, int height);
+    int img_convert_ctx(ImgConvertContext *ctx, AVPicture *dst, const AVPicture *src);
+    int img_convert_ctx_rect(ImgConvertContext *ctx, AVPicture *dst, const AVPicture *src, int x, int y, int w, int h);
+    void img_convert_ctx_free(ImgConvertContext *ctx);
+
+    // 由调色板算出每个索引的YUV444 值，和img_convert 经RGB24 转换到YUV444P 的结果完全一样。
+    void ff_build_pal8_yuv_lut(uint8_t *lut_y, uint8_t *lut_u, uint8_t *lut_v, const uint32_t *palette);
+
+    void avcodec_init(void);
+
+    void register_avcodec(AVCodec *format);
+    AVCodec *avcodec_find_decoder(enum CodecID id);
+    AVCodec *avcodec_find_encoder(enum CodecID id);
+
+    AVCodecContext *avcodec_alloc_context(void);
+
+    int avcodec_default_get_buffer(AVCodecContext *s, AVFrame *pic);
+    void avcodec_default_release_buffer(AVCodecContext *s, AVFrame *pic);
+    int avcodec_default_reget_buffer(AVCodecContext *s, AVFrame *pic);
+    void avcodec_align_dimensions(AVCodecContext *s, int *width, int *height);
+    int avcodec_check_dimensions(void *av_log_ctx, unsigned int w, unsigned int h);
+
+    int avcodec_open(AVCodecContext *avctx, AVCodec *codec);
+
+    int avcodec_decode_audio(AVCodecContext *avctx, int16_t *samples, int *frame_size_ptr,
+	uint8_t *buf, int buf_size);
+    int avcodec_decode_audio_batch(AVCodecContext **avctx, int count, int16_t **samples, int *frame_size_ptr,
+	int *consumed, uint8_t **buf, int buf_size);
+    int avcodec_decode_video(AVCodecContext *avctx, AVFrame *picture, int *got_picture_ptr,
+	uint8_t *buf, int buf_size);
+    int avcodec_encode_video(AVCodecContext *avctx, uint8_t *buf, int buf_size, const AVFrame *pict);
+    int avcodec_decode_video2(AVCodecContext *avctx, AVFrame *picture, int *got_picture_ptr,
+	AVPacket *avpkt);
+    int avcodec_send_packet(AVCodecContext *avctx, AVPacket *avpkt);
+    int avcodec_receive_frame(AVCodecContext *avctx, AVFrame *frame);
+
+    int avcodec_close(AVCodecContext *avctx);
+
+    void avcodec_register_all(void);
+
+    void avcodec_default_free_buffers(AVCodecContext *s);
+
+    // 直接渲染时应用程序提供帧缓存内存的回调。alloc 填好各分量地址和单行长度，*buf_opaque 返回应用程序自己的缓存对象，失败返回负数。
+    typedef int(*AVFrameBufAllocCallback)(void *opaque, int pix_fmt, int width, int height,
+	uint8_t *data[4], int linesize[4], void **buf_opaque);
+    typedef void(*AVFrameBufFreeCallback)(void *opaque, void *buf_opaque);
+
+    struct AVFramePool *av_frame_pool_create(int pix_fmt, int width, int height);
+    struct AVFramePool *av_frame_pool_create_external(int pix_fmt, int width, int height,
+	AVFrameBufAllocCallback alloc_buf, AVFrameBufFreeCallback free_buf, void *opaque);
+    struct AVFramePool *av_frame_pool_ref(struct AVFramePool *pool);
+    void av_frame_pool_unref(struct AVFramePool **pool);
+    int av_frame_ref(AVFrame *dst, const AVFrame *src);
+    void av_frame_unref(AVFrame *frame);
+    void *av_frame_get_buf_opaque(const AVFrame *frame);
+    void av_frame_report_progress(AVFrame *frame, int progress);
+    void av_frame_await_progress(const AVFrame *frame, int progress);
+
+    void *av_malloc(unsigned int size);
+    void *av_malloc_large(unsigned int size);
+    void *av_mallocz(unsigned int size);
+    void *av_realloc(void *ptr, unsigned int size);
+    void av_free(void *ptr);
+    void av_freep(void *ptr);
+    void *av_fast_realloc(void *ptr, unsigned int *size, unsigned int min_size);
+
+    AVMemStats *av_mem_stats_alloc(void);
+    void av_mem_stats_release(AVMemStats *stats);
+    AVMemStats *av_mem_stats_set_current(AVMemStats *stats);
+    AVMemStats *av_mem_stats_get_current(void);
+    const AVMemStats *av_mem_stats_get_global(void);
+    void av_mem_charge_to(void *ptr, AVMemStats *stats);
+
+    void img_copy(AVPicture *dst, const AVPicture *src, int pix_fmt, int width, int height);
+
+#ifdef __cplusplus
+}
+
+#endif
+
+#endif
@@ -1,21 +1,1059 @@
-#include "avcodec.h"
-#include "dsputil.h"
-
-// dsp Ż޷ʹõĲұʵʼ
-
-uint8_t cropTbl[256 + 2 * MAX_NEG_CROP] = { 0, };
-
-void dsputil_static_init(void)
-{
-    int i;
-    // ʼ޷ұĽǣǰMAX_NEG_CROP Ϊ0ŵ256 ֱΪ0 255
-    // MAX_NEG_CROP Ϊ255òȽʵ޷㡣
-    for (i = 0; i < 256; i++)
-	cropTbl[i + MAX_NEG_CROP] = i;
-
-    for (i = 0; i < MAX_NEG_CROP; i++)
-    {
-	cropTbl[i] = 0;
-	cropTbl[i + MAX_NEG_CROP + 256] = 255;
-    }
-}
+#include "avcodec.h"
+#include "dsputil.h"
+
+#ifdef HAVE_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+// SSE2 是编译目标的基本指令集，不用加属性；gcc 给SSSE3、AVX2 实现的函数加target 属性单独打开对应的指令集，vc 不需要。
+#define DSP_SSE2
+#if defined(__GNUC__) && defined(HAVE_AVX2)
+#define DSP_SSSE3	__attribute__((target("ssse3")))
+#define DSP_AVX2	__attribute__((target("avx2")))
+#else
+#define DSP_SSSE3
+#define DSP_AVX2
+#endif
+
+// 定义dsp 优化限幅运算使用的查找表，实现其初始化函数。
+// 实现运行时的CPU 指令集检测和DSPContext 各个函数的C 实现和SIMD 实现。
+
+#define xglue(x, y) x ## y
+#define glue(x, y) xglue(x, y)
+
+uint8_t cropTbl[256 + 2 * MAX_NEG_CROP] = { 0, };
+
+void dsputil_static_init(void)
+{
+    int i;
+    // 初始化限幅运算查找表，最后的结果是：前MAX_NEG_CROP 个数组项为0，接着的256 个数组项分别为0 到255，
+    // 后面MAX_NEG_CROP 个数组项为255。用查表代替比较实现限幅运算。
+    for (i = 0; i < 256; i++)
+	cropTbl[i + MAX_NEG_CROP] = i;
+
+    for (i = 0; i < MAX_NEG_CROP; i++)
+    {
+	cropTbl[i] = 0;
+	cropTbl[i + MAX_NEG_CROP + 256] = 255;
+    }
+}
+
+// 用cpuid 检测CPU 支持的指令集，非x86 平台返回0，全部用C 实现。
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+
+#ifdef CONFIG_WIN32
+#include <intrin.h>
+#define dsp_cpuid(leaf, r)	__cpuidex(r, leaf, 0)
+#define dsp_xgetbv()		((int)_xgetbv(0))
+#else
+#include <cpuid.h>
+#define dsp_cpuid(leaf, r)	__cpuid_count(leaf, 0, (r)[0], (r)[1], (r)[2], (r)[3])
+
+static inline int dsp_xgetbv(void)
+{
+    int eax, edx;
+
+    // xgetbv 的机器码，老版本的汇编器不认识这条指令。
+    __asm__ volatile(".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+    return eax;
+}
+#endif
+
+int mm_support(void)
+{
+    int regs[4], max_leaf, flags = 0;
+
+    dsp_cpuid(0, regs);
+    max_leaf = regs[0];
+    if (max_leaf < 1)
+	return 0;
+
+    dsp_cpuid(1, regs);
+    if (regs[3] & (1 << 26))
+	flags |= MM_SSE2;
+    if (regs[2] & (1 << 9))
+	flags |= MM_SSSE3;
+
+    // AVX2 还要求操作系统保存ymm 寄存器：AVX 和OSXSAVE 置位，并且XCR0 的xmm/ymm 两位都是1。
+    if (max_leaf >= 7 && (regs[2] & (1 << 27)) && (regs[2] & (1 << 28)) && (dsp_xgetbv() & 6) == 6)
+    {
+	dsp_cpuid(7, regs);
+	if (regs[1] & (1 << 5))
+	    flags |= MM_AVX2;
+    }
+
+    return flags;
+}
+
+#else
+
+int mm_support(void)
+{
+    return 0;
+}
+
+#endif
+
+////////////////////////////
+// C 实现
+
+static void copy_plane_c(uint8_t *dst, int dst_wrap, const uint8_t *src, int src_wrap, int width, int height)
+{
+    for (; height > 0; height--)
+    {
+	memcpy(dst, src, width);
+	dst += dst_wrap;
+	src += src_wrap;
+    }
+}
+
+static void fill_block_c(uint8_t *dst, int value, int len)
+{
+    memset(dst, value, len);
+}
+
+// 一次比较8 字节，遇到不同的8 字节再逐字节找。
+static int match_len_c(const uint8_t *a, const uint8_t *b, int n)
+{
+    uint64_t va, vb;
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+	memcpy(&va, a + i, 8);
+	memcpy(&vb, b + i, 8);
+	if (va != vb)
+	    break;
+    }
+    while (i < n && a[i] == b[i])
+	i++;
+    return i;
+}
+
+static void pal8_to_rgba32_row_c(uint32_t *dst, const uint8_t *src, const uint32_t *palette, int width)
+{
+    int i;
+
+    for (i = 0; i + 4 <= width; i += 4)
+    {
+	dst[i] = palette[src[i]];
+	dst[i + 1] = palette[src[i + 1]];
+	dst[i + 2] = palette[src[i + 2]];
+	dst[i + 3] = palette[src[i + 3]];
+    }
+    for (; i < width; i++)
+	dst[i] = palette[src[i]];
+}
+
+// 四个像素的lut_uv 相加，U 和V 各自在16 位内求和，不会互相进位。
+static void pal8_to_yuv420p_row_c(uint8_t *lum1, uint8_t *lum2, uint8_t *cb, uint8_t *cr,
+    const uint8_t *src1, const uint8_t *src2, const uint8_t *lut_y, const uint32_t *lut_uv, int width)
+{
+    int i;
+    uint32_t uv;
+
+    for (i = 0; i < width; i++)
+	lum1[i] = lut_y[src1[i]];
+    if (lum2)
+    {
+	for (i = 0; i < width; i++)
+	    lum2[i] = lut_y[src2[i]];
+    }
+
+    for (i = 0; i + 1 < width; i += 2)
+    {
+	uv = lut_uv[src1[i]] + lut_uv[src1[i + 1]] + lut_uv[src2[i]] + lut_uv[src2[i + 1]] + 0x00020002;
+	cb[i >> 1] = (uv >> 2) & 0xff;
+	cr[i >> 1] = uv >> 18;
+    }
+    if (i < width)
+    {
+	uv = 2 * (lut_uv[src1[i]] + lut_uv[src2[i]]) + 0x00020002;
+	cb[i >> 1] = (uv >> 2) & 0xff;
+	cr[i >> 1] = uv >> 18;
+    }
+}
+
+// 滤波历史用滑动窗口，buf[pos .. pos + 7] 是最近的8 个值，从旧到新，新值接着往后写，写满了再把最后8 个搬回开头。
+typedef struct DSPHistoryC
+{
+    int16_t buf[8 + 64];
+    int pos;
+} DSPHistoryC;
+
+static inline void hist_load_c(DSPHistoryC *h, const int16_t *src)
+{
+    int k;
+
+    for (k = 0; k < 8; k++)
+	h->buf[7 - k] = src[k];
+    h->pos = 0;
+}
+
+static inline void hist_store_c(const DSPHistoryC *h, int16_t *dst)
+{
+    int k;
+
+    for (k = 0; k < 8; k++)
+	dst[k] = h->buf[h->pos + 7 - k];
+}
+
+static inline int hist_dot_c(const DSPHistoryC *h, const int16_t *coefs)
+{
+    const int16_t *p = h->buf + h->pos + 7;
+    int k, sum = 0;
+
+    for (k = 0; k < 8; k++)
+	sum += p[-k] * coefs[k];
+    return sum;
+}
+
+static inline void hist_push_c(DSPHistoryC *h, int v)
+{
+    if (h->pos == 64)
+    {
+	memcpy(h->buf, h->buf + 64, 8 * sizeof(int16_t));
+	h->pos = 0;
+    }
+    h->buf[h->pos + 8] = v;
+    h->pos++;
+}
+
+#define SUFFIX	_c
+#define HISTORY	DSPHistoryC
+#include "dsputil_template.h"
+
+////////////////////////////
+// SSE2 实现
+
+#ifdef HAVE_SSE2
+
+// 历史放在一个寄存器里，pmaddwd 一次算完8 个乘积，移位也在寄存器里做。
+typedef __m128i DSPHistorySSE2;
+
+static inline void hist_load_sse2(DSPHistorySSE2 *h, const int16_t *src)
+{
+    *h = _mm_loadu_si128((const __m128i*)src);
+}
+
+static inline void hist_store_sse2(const DSPHistorySSE2 *h, int16_t *dst)
+{
+    _mm_storeu_si128((__m128i*)dst, *h);
+}
+
+static inline int hist_dot_sse2(const DSPHistorySSE2 *h, const int16_t *coefs)
+{
+    __m128i s = _mm_madd_epi16(*h, _mm_loadu_si128((const __m128i*)coefs));
+
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+}
+
+static inline void hist_push_sse2(DSPHistorySSE2 *h, int v)
+{
+    *h = _mm_insert_epi16(_mm_slli_si128(*h, 2), v, 0);
+}
+
+#define SUFFIX	_sse2
+#define HISTORY	DSPHistorySSE2
+#include "dsputil_template.h"
+
+// YUV420P 到RGB，和imgconvert 中YUV_TO_RGB1_CCIR/YUV_TO_RGB2_CCIR(jpeg 时YUV_TO_RGB1/YUV_TO_RGB2) 的定点算法相同：
+// (y - y_off) * y_mul + 色度加数，全部用32 位整数精确计算，右移10 位后用饱和打包代替cropTbl 限幅，结果和查表完全一样。
+// 每次算上下两行各16 个像素，8 个色度样本只算一次；行尾不足16 个像素时拷到临时数组里算，不读写数组外的数据。
+static const int16_t yuv2rgb_coefs[2][6] =
+{
+    // y_off, y_mul, cr->r, cb->g, cr->g, cb->b
+    { 16, 1192, 1634, -401, -832, 2066 },	// CCIR 601 范围
+    { 0, 1024, 1436, -352, -731, 1815 },	// jpeg 全范围
+};
+
+typedef struct YUV2RGBContext
+{
+    __m128i y_off, y_mul;
+    __m128i r_coef, g_coef, b_coef;	// 和(cr, cb) 交错的16 位数据做pmaddwd
+    __m128i half;
+} YUV2RGBContext;
+
+static void yuv2rgb_init_sse2(YUV2RGBContext *c, int jpeg)
+{
+    const int16_t *k = yuv2rgb_coefs[jpeg != 0];
+
+    c->y_off = _mm_set1_epi16(k[0]);
+    c->y_mul = _mm_set1_epi16(k[1]);
+    c->r_coef = _mm_set_epi16(0, k[2], 0, k[2], 0, k[2], 0, k[2]);
+    c->g_coef = _mm_set_epi16(k[3], k[4], k[3], k[4], k[3], k[4], k[3], k[4]);
+    c->b_coef = _mm_set_epi16(k[5], 0, k[5], 0, k[5], 0, k[5], 0);
+    c->half = _mm_set1_epi32(1 << 9);
+}
+
+// 8 个色度样本算出16 个像素的r/g/b 加数，每个色度样本对应相邻的两个像素，add[k][i] 是第4i 到4i + 3 个像素。
+static inline void yuv2rgb_chroma_sse2(const YUV2RGBContext *c, const uint8_t *cb, const uint8_t *cr, __m128i add[3][4])
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i c128 = _mm_set1_epi16(128);
+    __m128i u = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)cb), zero), c128);
+    __m128i v = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)cr), zero), c128);
+    __m128i vu_lo = _mm_unpacklo_epi16(v, u), vu_hi = _mm_unpackhi_epi16(v, u);
+    const __m128i *coef[3];
+    __m128i lo, hi;
+    int k;
+
+    coef[0] = &c->r_coef;
+    coef[1] = &c->g_coef;
+    coef[2] = &c->b_coef;
+    for (k = 0; k < 3; k++)
+    {
+	lo = _mm_add_epi32(_mm_madd_epi16(vu_lo, *coef[k]), c->half);
+	hi = _mm_add_epi32(_mm_madd_epi16(vu_hi, *coef[k]), c->half);
+	add[k][0] = _mm_shuffle_epi32(lo, 0x50);
+	add[k][1] = _mm_shuffle_epi32(lo, 0xFA);
+	add[k][2] = _mm_shuffle_epi32(hi, 0x50);
+	add[k][3] = _mm_shuffle_epi32(hi, 0xFA);
+    }
+}
+
+// 16 个亮度样本加上色度加数，得到16 个像素的r/g/b 分量(每个分量16 个字节)。
+static inline void yuv2rgb_luma_sse2(const YUV2RGBContext *c, const uint8_t *y, __m128i add[3][4], __m128i rgb[3])
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i p = _mm_loadu_si128((const __m128i*)y);
+    __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(p, zero), c->y_off);
+    __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(p, zero), c->y_off);
+    __m128i ml, mh, y32[4], s[4];
+    int k, i;
+
+    // 16 位乘法的低半和高半交错起来就是32 位的乘积。
+    ml = _mm_mullo_epi16(lo, c->y_mul);
+    mh = _mm_mulhi_epi16(lo, c->y_mul);
+    y32[0] = _mm_unpacklo_epi16(ml, mh);
+    y32[1] = _mm_unpackhi_epi16(ml, mh);
+    ml = _mm_mullo_epi16(hi, c->y_mul);
+    mh = _mm_mulhi_epi16(hi, c->y_mul);
+    y32[2] = _mm_unpacklo_epi16(ml, mh);
+    y32[3] = _mm_unpackhi_epi16(ml, mh);
+
+    for (k = 0; k < 3; k++)
+    {
+	for (i = 0; i < 4; i++)
+	    s[i] = _mm_srai_epi32(_mm_add_epi32(y32[i], add[k][i]), 10);
+	rgb[k] = _mm_packus_epi16(_mm_packs_epi32(s[0], s[1]), _mm_packs_epi32(s[2], s[3]));
+    }
+}
+
+// 各个RGB 格式写16 个像素，像素格式和imgconvert.c 中对应的RGB_OUT 一样。
+static inline void yuv2rgb_store_rgba32(uint8_t *d, const __m128i *rgb)
+{
+    __m128i a = _mm_set1_epi8(-1);
+    __m128i bg = _mm_unpacklo_epi8(rgb[2], rgb[1]), ra = _mm_unpacklo_epi8(rgb[0], a);
+
+    _mm_storeu_si128((__m128i*)d, _mm_unpacklo_epi16(bg, ra));
+    _mm_storeu_si128((__m128i*)(d + 16), _mm_unpackhi_epi16(bg, ra));
+    bg = _mm_unpackhi_epi8(rgb[2], rgb[1]);
+    ra = _mm_unpackhi_epi8(rgb[0], a);
+    _mm_storeu_si128((__m128i*)(d + 32), _mm_unpacklo_epi16(bg, ra));
+    _mm_storeu_si128((__m128i*)(d + 48), _mm_unpackhi_epi16(bg, ra));
+}
+
+// 24 位像素先拼成32 位，再每个像素写4 个字节，第4 个字节由下一个像素覆盖，最后一个像素只写3 个字节。
+static inline void yuv2rgb_store_24(uint8_t *d, __m128i c0, __m128i c1, __m128i c2)
+{
+    uint32_t px[16];
+    __m128i zero = _mm_setzero_si128();
+    __m128i c01 = _mm_unpacklo_epi8(c0, c1), c2z = _mm_unpacklo_epi8(c2, zero);
+    int i;
+
+    _mm_storeu_si128((__m128i*)px, _mm_unpacklo_epi16(c01, c2z));
+    _mm_storeu_si128((__m128i*)(px + 4), _mm_unpackhi_epi16(c01, c2z));
+    c01 = _mm_unpackhi_epi8(c0, c1);
+    c2z = _mm_unpackhi_epi8(c2, zero);
+    _mm_storeu_si128((__m128i*)(px + 8), _mm_unpacklo_epi16(c01, c2z));
+    _mm_storeu_si128((__m128i*)(px + 12), _mm_unpackhi_epi16(c01, c2z));
+
+    for (i = 0; i < 15; i++)
+	memcpy(d + 3 * i, px + i, 4);
+    memcpy(d + 45, px + 15, 3);
+}
+
+static inline void yuv2rgb_store_rgb24(uint8_t *d, const __m128i *rgb)
+{
+    yuv2rgb_store_24(d, rgb[0], rgb[1], rgb[2]);
+}
+
+static inline void yuv2rgb_store_bgr24(uint8_t *d, const __m128i *rgb)
+{
+    yuv2rgb_store_24(d, rgb[2], rgb[1], rgb[0]);
+}
+
+// 16 位像素：r/g/b 各自保留高位后移到对应的位置，rgb555 的最高位是alpha，RGB_OUT 写的是不透明。
+static inline void yuv2rgb_store_16(uint8_t *d, const __m128i *rgb, int g_mask, int r_shift, int g_shift, int alpha)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i rmask = _mm_set1_epi16(0xF8), gmask = _mm_set1_epi16(g_mask), a = _mm_set1_epi16(alpha);
+    __m128i r, g, b;
+
+    r = _mm_slli_epi16(_mm_and_si128(_mm_unpacklo_epi8(rgb[0], zero), rmask), r_shift);
+    g = _mm_slli_epi16(_mm_and_si128(_mm_unpacklo_epi8(rgb[1], zero), gmask), g_shift);
+    b = _mm_srli_epi16(_mm_unpacklo_epi8(rgb[2], zero), 3);
+    _mm_storeu_si128((__m128i*)d, _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a)));
+
+    r = _mm_slli_epi16(_mm_and_si128(_mm_unpackhi_epi8(rgb[0], zero), rmask), r_shift);
+    g = _mm_slli_epi16(_mm_and_si128(_mm_unpackhi_epi8(rgb[1], zero), gmask), g_shift);
+    b = _mm_srli_epi16(_mm_unpackhi_epi8(rgb[2], zero), 3);
+    _mm_storeu_si128((__m128i*)(d + 16), _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a)));
+}
+
+static inline void yuv2rgb_store_rgb565(uint8_t *d, const __m128i *rgb)
+{
+    yuv2rgb_store_16(d, rgb, 0xFC, 8, 3, 0);
+}
+
+static inline void yuv2rgb_store_rgb555(uint8_t *d, const __m128i *rgb)
+{
+    yuv2rgb_store_16(d, rgb, 0xF8, 7, 2, 0x8000);
+}
+
+#ifdef HAVE_SSSE3
+
+// 24 位像素用pshufb 从三个分量里各取对应的字节，或起来就是连续的3 x 16 个字节，不用逐个像素写。
+// yuv2rgb_shuf24[o][k] 取第k 个分量放到第o 个16 字节里，-1 的位置填0。
+static const int8_t yuv2rgb_shuf24[3][3][16] =
+{
+    { { 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5 },
+      { -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1 },
+      { -1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1 } },
+    { { -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1 },
+      { 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10 },
+      { -1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1 } },
+    { { -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1 },
+      { -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1 },
+      { 10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15 } },
+};
+
+DSP_SSSE3 static inline void yuv2rgb_store_24_ssse3(uint8_t *d, __m128i c0, __m128i c1, __m128i c2)
+{
+    __m128i v;
+    int o;
+
+    for (o = 0; o < 3; o++)
+    {
+	v = _mm_shuffle_epi8(c0, _mm_loadu_si128((const __m128i*)yuv2rgb_shuf24[o][0]));
+	v = _mm_or_si128(v, _mm_shuffle_epi8(c1, _mm_loadu_si128((const __m128i*)yuv2rgb_shuf24[o][1])));
+	v = _mm_or_si128(v, _mm_shuffle_epi8(c2, _mm_loadu_si128((const __m128i*)yuv2rgb_shuf24[o][2])));
+	_mm_storeu_si128((__m128i*)(d + 16 * o), v);
+    }
+}
+
+DSP_SSSE3 static inline void yuv2rgb_store_rgb24_ssse3(uint8_t *d, const __m128i *rgb)
+{
+    yuv2rgb_store_24_ssse3(d, rgb[0], rgb[1], rgb[2]);
+}
+
+DSP_SSSE3 static inline void yuv2rgb_store_bgr24_ssse3(uint8_t *d, const __m128i *rgb)
+{
+    yuv2rgb_store_24_ssse3(d, rgb[2], rgb[1], rgb[0]);
+}
+
+#endif
+
+// 按像素格式生成一行转换函数，ext 是实现的后缀，store 写16 个像素，attr 是函数的指令集属性。
+// 行尾不足16 个像素时把输入拷到补零的临时数组，转换后只拷回有效的部分。
+#define YUV2RGB_ROW_SSE2(name, ext, store, bpp, attr)\
+attr static void glue(glue(glue(yuv420p_to_, name), _row_), ext)(uint8_t *d1, uint8_t *d2, const uint8_t *y1,\
+    const uint8_t *y2, const uint8_t *cb, const uint8_t *cr, int width, int jpeg)\
+{\
+    YUV2RGBContext c;\
+    __m128i add[3][4], rgb[3];\
+    uint8_t ty1[16], ty2[16], tcb[8], tcr[8], out[16 * (bpp)];\
+    int x, rest;\
+\
+    yuv2rgb_init_sse2(&c, jpeg);\
+    for (x = 0; x + 16 <= width; x += 16)\
+    {\
+	yuv2rgb_chroma_sse2(&c, cb + (x >> 1), cr + (x >> 1), add);\
+	yuv2rgb_luma_sse2(&c, y1 + x, add, rgb);\
+	store(d1 + x * (bpp), rgb);\
+	if (d2)\
+	{\
+	    yuv2rgb_luma_sse2(&c, y2 + x, add, rgb);\
+	    store(d2 + x * (bpp), rgb);\
+	}\
+    }\
+\
+    rest = width - x;\
+    if (rest <= 0)\
+	return;\
+    memset(tcb, 128, 8);\
+    memset(tcr, 128, 8);\
+    memset(ty1, 0, 16);\
+    memcpy(tcb, cb + (x >> 1), (rest + 1) >> 1);\
+    memcpy(tcr, cr + (x >> 1), (rest + 1) >> 1);\
+    memcpy(ty1, y1 + x, rest);\
+    yuv2rgb_chroma_sse2(&c, tcb, tcr, add);\
+    yuv2rgb_luma_sse2(&c, ty1, add, rgb);\
+    store(out, rgb);\
+    memcpy(d1 + x * (bpp), out, rest * (bpp));\
+    if (d2)\
+    {\
+	memset(ty2, 0, 16);\
+	memcpy(ty2, y2 + x, rest);\
+	yuv2rgb_luma_sse2(&c, ty2, add, rgb);\
+	store(out, rgb);\
+	memcpy(d2 + x * (bpp), out, rest * (bpp));\
+    }\
+}
+
+YUV2RGB_ROW_SSE2(rgb24, sse2, yuv2rgb_store_rgb24, 3, DSP_SSE2)
+YUV2RGB_ROW_SSE2(bgr24, sse2, yuv2rgb_store_bgr24, 3, DSP_SSE2)
+YUV2RGB_ROW_SSE2(rgba32, sse2, yuv2rgb_store_rgba32, 4, DSP_SSE2)
+YUV2RGB_ROW_SSE2(rgb565, sse2, yuv2rgb_store_rgb565, 2, DSP_SSE2)
+YUV2RGB_ROW_SSE2(rgb555, sse2, yuv2rgb_store_rgb555, 2, DSP_SSE2)
+#ifdef HAVE_SSSE3
+YUV2RGB_ROW_SSE2(rgb24, ssse3, yuv2rgb_store_rgb24_ssse3, 3, DSP_SSSE3)
+YUV2RGB_ROW_SSE2(bgr24, ssse3, yuv2rgb_store_bgr24_ssse3, 3, DSP_SSSE3)
+#endif
+
+// 逐行拷贝，不用每行调用一次memcpy。宽度不小于16 时每行最后16 个字节单独拷，和前面的部分重叠。
+static void copy_plane_sse2(uint8_t *dst, int dst_wrap, const uint8_t *src, int src_wrap, int width, int height)
+{
+    __m128i a, b, c, d;
+    int x;
+
+    if (width < 16)
+    {
+	copy_plane_c(dst, dst_wrap, src, src_wrap, width, height);
+	return;
+    }
+    for (; height > 0; height--)
+    {
+	for (x = 0; x + 64 <= width; x += 64)
+	{
+	    a = _mm_loadu_si128((const __m128i*)(src + x));
+	    b = _mm_loadu_si128((const __m128i*)(src + x + 16));
+	    c = _mm_loadu_si128((const __m128i*)(src + x + 32));
+	    d = _mm_loadu_si128((const __m128i*)(src + x + 48));
+	    _mm_storeu_si128((__m128i*)(dst + x), a);
+	    _mm_storeu_si128((__m128i*)(dst + x + 16), b);
+	    _mm_storeu_si128((__m128i*)(dst + x + 32), c);
+	    _mm_storeu_si128((__m128i*)(dst + x + 48), d);
+	}
+	for (; x + 16 <= width; x += 16)
+	    _mm_storeu_si128((__m128i*)(dst + x), _mm_loadu_si128((const __m128i*)(src + x)));
+	if (x < width)
+	    _mm_storeu_si128((__m128i*)(dst + width - 16), _mm_loadu_si128((const __m128i*)(src + width - 16)));
+	dst += dst_wrap;
+	src += src_wrap;
+    }
+}
+
+// 一次比较16 字节，有不同的字节时在这16 字节里逐字节找。
+static int match_len_sse2(const uint8_t *a, const uint8_t *b, int n)
+{
+    int i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+	__m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(a + i)), _mm_loadu_si128((const __m128i*)(b + i)));
+	if (_mm_movemask_epi8(eq) != 0xFFFF)
+	    break;
+    }
+    while (i < n && a[i] == b[i])
+	i++;
+    return i;
+}
+
+// 8 路滤波：8 个流的同一个采样放在一个寄存器的8 个int16 通道里，一条依赖链同时完成8 个流的递推。
+#define LANES_EXTEND_LO(x)	_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)
+#define LANES_EXTEND_HI(x)	_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16)
+
+// 8 项系数相邻两项交错排列，pmaddwd 一次算出每个流两项乘积的和。cl 是前4 个流，ch 是后4 个流。
+static void lanes8_coefs(const int16_t *coefs, __m128i *cl, __m128i *ch)
+{
+    __m128i a, b;
+    int p;
+
+    for (p = 0; p < 4; p++)
+    {
+	a = _mm_loadu_si128((const __m128i*)(coefs + 2 * p * 8));
+	b = _mm_loadu_si128((const __m128i*)(coefs + (2 * p + 1) * 8));
+	cl[p] = _mm_unpacklo_epi16(a, b);
+	ch[p] = _mm_unpackhi_epi16(a, b);
+    }
+}
+
+// newest 指向历史窗口中最新的一项，前面依次是更旧的值。
+static inline void lanes8_dot(const int16_t *newest, const __m128i *cl, const __m128i *ch, __m128i *lo, __m128i *hi)
+{
+    __m128i a, b, sl = _mm_setzero_si128(), sh = _mm_setzero_si128();
+    int p;
+
+    for (p = 0; p < 4; p++)
+    {
+	a = _mm_loadu_si128((const __m128i*)(newest - 2 * p * 8));
+	b = _mm_loadu_si128((const __m128i*)(newest - (2 * p + 1) * 8));
+	sl = _mm_add_epi32(sl, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), cl[p]));
+	sh = _mm_add_epi32(sh, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), ch[p]));
+    }
+    *lo = sl;
+    *hi = sh;
+}
+
+// 32 位结果限幅到[-0x7FFE, 0x7FFE]：先饱和到int16，再在int16 上限幅。
+static inline __m128i lanes8_clip(__m128i lo, __m128i hi)
+{
+    __m128i v = _mm_packs_epi32(lo, hi);
+
+    v = _mm_max_epi16(v, _mm_set1_epi16(-0x7FFE));
+    return _mm_min_epi16(v, _mm_set1_epi16(0x7FFE));
+}
+
+// 32 位结果截断成int16，和赋值给int16_t 变量一样。
+static inline __m128i lanes8_trunc(__m128i lo, __m128i hi)
+{
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+    return _mm_packs_epi32(lo, hi);
+}
+
+// 8 路合成滤波，和synth_filter8 一样。
+static void synth_filter8_x8_sse2(int16_t *out, const int16_t *coefs, int16_t *hist, int len)
+{
+    __m128i cl[4], ch[4], v, lo, hi, dl, dh;
+    int i;
+
+    lanes8_coefs(coefs, cl, ch);
+    for (i = 0; i < len; i++)
+    {
+	v = _mm_loadu_si128((const __m128i*)(out + i * 8));
+	lanes8_dot(hist + (i + 7) * 8, cl, ch, &dl, &dh);
+	lo = _mm_add_epi32(_mm_add_epi32(dl, _mm_slli_epi32(LANES_EXTEND_LO(v), 12)), _mm_set1_epi32(0x800));
+	hi = _mm_add_epi32(_mm_add_epi32(dh, _mm_slli_epi32(LANES_EXTEND_HI(v), 12)), _mm_set1_epi32(0x800));
+	v = lanes8_clip(_mm_srai_epi32(lo, 12), _mm_srai_epi32(hi, 12));
+	_mm_storeu_si128((__m128i*)(out + i * 8), v);
+	_mm_storeu_si128((__m128i*)(hist + (i + 8) * 8), v);
+    }
+}
+
+// 8 路逆滤波，和inverse_filter8 一样。
+static void inverse_filter8_x8_sse2(int16_t *out, const int16_t *coefs, int16_t *hist, int len)
+{
+    __m128i cl[4], ch[4], v, lo, hi, dl, dh;
+    int i;
+
+    lanes8_coefs(coefs, cl, ch);
+    for (i = 0; i < len; i++)
+    {
+	v = _mm_loadu_si128((const __m128i*)(out + i * 8));
+	lanes8_dot(hist + (i + 7) * 8, cl, ch, &dl, &dh);
+	_mm_storeu_si128((__m128i*)(hist + (i + 8) * 8), v);
+	lo = _mm_srai_epi32(_mm_sub_epi32(_mm_slli_epi32(LANES_EXTEND_LO(v), 12), dl), 12);
+	hi = _mm_srai_epi32(_mm_sub_epi32(_mm_slli_epi32(LANES_EXTEND_HI(v), 12), dh), 12);
+	_mm_storeu_si128((__m128i*)(out + i * 8), lanes8_trunc(lo, hi));
+    }
+}
+
+// 8 路后置滤波，和post_filter8 一样。
+static void post_filter8_x8_sse2(int16_t *out, const int16_t *coefs, int16_t *hist, int len, const int16_t *gain)
+{
+    __m128i cl[4], ch[4], v, cur, last, lo, hi, dl, dh;
+    __m128i zero = _mm_setzero_si128(), g = _mm_loadu_si128((const __m128i*)gain);
+    int i;
+
+    lanes8_coefs(coefs, cl, ch);
+    for (i = 0; i < len; i++)
+    {
+	v = _mm_loadu_si128((const __m128i*)(out + i * 8));
+	last = _mm_loadu_si128((const __m128i*)(hist + (i + 7) * 8));
+	lanes8_dot(hist + (i + 7) * 8, cl, ch, &dl, &dh);
+	lo = _mm_add_epi32(_mm_slli_epi32(LANES_EXTEND_LO(v), 12), dl);
+	hi = _mm_add_epi32(_mm_slli_epi32(LANES_EXTEND_HI(v), 12), dh);
+	cur = lanes8_clip(_mm_srai_epi32(_mm_add_epi32(lo, _mm_set1_epi32(0x800)), 12),
+	    _mm_srai_epi32(_mm_add_epi32(hi, _mm_set1_epi32(0x800)), 12));
+	_mm_storeu_si128((__m128i*)(hist + (i + 8) * 8), cur);
+
+	// last * gain 都在int16 范围内，和0 交错后用pmaddwd 得到32 位乘积。
+	lo = _mm_add_epi32(lo, _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(last, zero), _mm_unpacklo_epi16(g, zero)), 4));
+	hi = _mm_add_epi32(hi, _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(last, zero), _mm_unpackhi_epi16(g, zero)), 4));
+	lo = _mm_sub_epi32(lo, _mm_srai_epi32(lo, 3));
+	hi = _mm_sub_epi32(hi, _mm_srai_epi32(hi, 3));
+	v = lanes8_clip(_mm_srai_epi32(_mm_add_epi32(lo, _mm_set1_epi32(0x800)), 12),
+	    _mm_srai_epi32(_mm_add_epi32(hi, _mm_set1_epi32(0x800)), 12));
+	_mm_storeu_si128((__m128i*)(out + i * 8), v);
+    }
+}
+
+#ifdef HAVE_AVX2
+
+typedef struct YUV2RGBContextAVX2
+{
+    __m256i y_off, y_mul;
+    __m256i r_coef, g_coef, b_coef;
+    __m256i half;
+} YUV2RGBContextAVX2;
+
+DSP_AVX2 static void yuv2rgb_init_avx2(YUV2RGBContextAVX2 *c, int jpeg)
+{
+    const int16_t *k = yuv2rgb_coefs[jpeg != 0];
+
+    c->y_off = _mm256_set1_epi16(k[0]);
+    c->y_mul = _mm256_set1_epi16(k[1]);
+    c->r_coef = _mm256_set1_epi32((uint16_t)k[2]);
+    c->g_coef = _mm256_set1_epi32((int)((uint32_t)(uint16_t)k[3] << 16 | (uint16_t)k[4]));
+    c->b_coef = _mm256_set1_epi32((int)((uint32_t)(uint16_t)k[5] << 16));
+    c->half = _mm256_set1_epi32(1 << 9);
+}
+
+// 和SSE2 实现的算法相同，一次算32 个像素。AVX2 的解包和打包都在两个128 位通道内各自进行，
+// 16 个色度样本和32 个亮度样本在两个通道里的排列正好对应：add[k][i] 的低通道是第4i 到4i + 3 个像素，高通道再加16。
+DSP_AVX2 static inline void yuv2rgb_chroma_avx2(const YUV2RGBContextAVX2 *c, const uint8_t *cb, const uint8_t *cr,
+    __m256i add[3][4])
+{
+    __m256i c128 = _mm256_set1_epi16(128);
+    __m256i u = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)cb)), c128);
+    __m256i v = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)cr)), c128);
+    __m256i vu_lo = _mm256_unpacklo_epi16(v, u), vu_hi = _mm256_unpackhi_epi16(v, u);
+    const __m256i *coef[3];
+    __m256i lo, hi;
+    int k;
+
+    coef[0] = &c->r_coef;
+    coef[1] = &c->g_coef;
+    coef[2] = &c->b_coef;
+    for (k = 0; k < 3; k++)
+    {
+	lo = _mm256_add_epi32(_mm256_madd_epi16(vu_lo, *coef[k]), c->half);
+	hi = _mm256_add_epi32(_mm256_madd_epi16(vu_hi, *coef[k]), c->half);
+	add[k][0] = _mm256_shuffle_epi32(lo, 0x50);
+	add[k][1] = _mm256_shuffle_epi32(lo, 0xFA);
+	add[k][2] = _mm256_shuffle_epi32(hi, 0x50);
+	add[k][3] = _mm256_shuffle_epi32(hi, 0xFA);
+    }
+}
+
+// 32 个亮度样本加上色度加数，rgb[k] 是32 个像素的一个分量，按像素顺序排列。
+DSP_AVX2 static inline void yuv2rgb_luma_avx2(const YUV2RGBContextAVX2 *c, const uint8_t *y, __m256i add[3][4],
+    __m256i rgb[3])
+{
+    __m256i zero = _mm256_setzero_si256();
+    __m256i p = _mm256_loadu_si256((const __m256i*)y);
+    __m256i lo = _mm256_sub_epi16(_mm256_unpacklo_epi8(p, zero), c->y_off);
+    __m256i hi = _mm256_sub_epi16(_mm256_unpackhi_epi8(p, zero), c->y_off);
+    __m256i ml, mh, y32[4], s[4];
+    int k, i;
+
+    ml = _mm256_mullo_epi16(lo, c->y_mul);
+    mh = _mm256_mulhi_epi16(lo, c->y_mul);
+    y32[0] = _mm256_unpacklo_epi16(ml, mh);
+    y32[1] = _mm256_unpackhi_epi16(ml, mh);
+    ml = _mm256_mullo_epi16(hi, c->y_mul);
+    mh = _mm256_mulhi_epi16(hi, c->y_mul);
+    y32[2] = _mm256_unpacklo_epi16(ml, mh);
+    y32[3] = _mm256_unpackhi_epi16(ml, mh);
+
+    for (k = 0; k < 3; k++)
+    {
+	for (i = 0; i < 4; i++)
+	    s[i] = _mm256_srai_epi32(_mm256_add_epi32(y32[i], add[k][i]), 10);
+	rgb[k] = _mm256_packus_epi16(_mm256_packs_epi32(s[0], s[1]), _mm256_packs_epi32(s[2], s[3]));
+    }
+}
+
+// 通道内交错后，低通道是像素0-3/4-7/8-11/12-15，高通道是16 个像素之后的对应像素，用vperm2i128 排回顺序。
+DSP_AVX2 static inline void yuv2rgb_store_rgba32_avx2(uint8_t *d, const __m256i *rgb)
+{
+    __m256i a = _mm256_set1_epi8(-1);
+    __m256i bg = _mm256_unpacklo_epi8(rgb[2], rgb[1]), ra = _mm256_unpacklo_epi8(rgb[0], a);
+    __m256i q0 = _mm256_unpacklo_epi16(bg, ra), q1 = _mm256_unpackhi_epi16(bg, ra), q2, q3;
+
+    bg = _mm256_unpackhi_epi8(rgb[2], rgb[1]);
+    ra = _mm256_unpackhi_epi8(rgb[0], a);
+    q2 = _mm256_unpacklo_epi16(bg, ra);
+    q3 = _mm256_unpackhi_epi16(bg, ra);
+    _mm256_storeu_si256((__m256i*)d, _mm256_permute2x128_si256(q0, q1, 0x20));
+    _mm256_storeu_si256((__m256i*)(d + 32), _mm256_permute2x128_si256(q2, q3, 0x20));
+    _mm256_storeu_si256((__m256i*)(d + 64), _mm256_permute2x128_si256(q0, q1, 0x31));
+    _mm256_storeu_si256((__m256i*)(d + 96), _mm256_permute2x128_si256(q2, q3, 0x31));
+}
+
+// 24 位像素拆成两组16 个像素，用SSSE3 实现的写法(支持AVX2 的CPU 都支持SSSE3)。
+DSP_AVX2 static inline void yuv2rgb_store_24_avx2(uint8_t *d, __m256i c0, __m256i c1, __m256i c2)
+{
+    yuv2rgb_store_24_ssse3(d, _mm256_castsi256_si128(c0), _mm256_castsi256_si128(c1), _mm256_castsi256_si128(c2));
+    yuv2rgb_store_24_ssse3(d + 48, _mm256_extracti128_si256(c0, 1), _mm256_extracti128_si256(c1, 1),
+	_mm256_extracti128_si256(c2, 1));
+}
+
+DSP_AVX2 static inline void yuv2rgb_store_rgb24_avx2(uint8_t *d, const __m256i *rgb)
+{
+    yuv2rgb_store_24_avx2(d, rgb[0], rgb[1], rgb[2]);
+}
+
+DSP_AVX2 static inline void yuv2rgb_store_bgr24_avx2(uint8_t *d, const __m256i *rgb)
+{
+    yuv2rgb_store_24_avx2(d, rgb[2], rgb[1], rgb[0]);
+}
+
+DSP_AVX2 static inline void yuv2rgb_store_16_avx2(uint8_t *d, const __m256i *rgb, int g_mask, int r_shift, int g_shift,
+    int alpha)
+{
+    __m256i zero = _mm256_setzero_si256();
+    __m256i rmask = _mm256_set1_epi16(0xF8), gmask = _mm256_set1_epi16(g_mask), a = _mm256_set1_epi16(alpha);
+    __m128i rs = _mm_cvtsi32_si128(r_shift), gs = _mm_cvtsi32_si128(g_shift);
+    __m256i r, g, b, lo, hi;
+
+    r = _mm256_sll_epi16(_mm256_and_si256(_mm256_unpacklo_epi8(rgb[0], zero), rmask), rs);
+    g = _mm256_sll_epi16(_mm256_and_si256(_mm256_unpacklo_epi8(rgb[1], zero), gmask), gs);
+    b = _mm256_srli_epi16(_mm256_unpacklo_epi8(rgb[2], zero), 3);
+    lo = _mm256_or_si256(_mm256_or_si256(r, g), _mm256_or_si256(b, a));
+
+    r = _mm256_sll_epi16(_mm256_and_si256(_mm256_unpackhi_epi8(rgb[0], zero), rmask), rs);
+    g = _mm256_sll_epi16(_mm256_and_si256(_mm256_unpackhi_epi8(rgb[1], zero), gmask), gs);
+    b = _mm256_srli_epi16(_mm256_unpackhi_epi8(rgb[2], zero), 3);
+    hi = _mm256_or_si256(_mm256_or_si256(r, g), _mm256_or_si256(b, a));
+
+    _mm256_storeu_si256((__m256i*)d, _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256((__m256i*)(d + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+DSP_AVX2 static inline void yuv2rgb_store_rgb565_avx2(uint8_t *d, const __m256i *rgb)
+{
+    yuv2rgb_store_16_avx2(d, rgb, 0xFC, 8, 3, 0);
+}
+
+DSP_AVX2 static inline void yuv2rgb_store_rgb555_avx2(uint8_t *d, const __m256i *rgb)
+{
+    yuv2rgb_store_16_avx2(d, rgb, 0xF8, 7, 2, 0x8000);
+}
+
+// 和YUV2RGB_ROW_SSE2 一样，一次32 个像素，行尾不足32 个像素时经临时数组转换。
+#define YUV2RGB_ROW_AVX2(name, bpp)\
+DSP_AVX2 static void glue(glue(yuv420p_to_, name), _row_avx2)(uint8_t *d1, uint8_t *d2, const uint8_t *y1,\
+    const uint8_t *y2, const uint8_t *cb, const uint8_t *cr, int width, int jpeg)\
+{\
+    YUV2RGBContextAVX2 c;\
+    __m256i add[3][4], rgb[3];\
+    uint8_t ty1[32], ty2[32], tcb[16], tcr[16], out[32 * (bpp)];\
+    int x, rest;\
+\
+    yuv2rgb_init_avx2(&c, jpeg);\
+    for (x = 0; x + 32 <= width; x += 32)\
+    {\
+	yuv2rgb_chroma_avx2(&c, cb + (x >> 1), cr + (x >> 1), add);\
+	yuv2rgb_luma_avx2(&c, y1 + x, add, rgb);\
+	glue(glue(yuv2rgb_store_, name), _avx2)(d1 + x * (bpp), rgb);\
+	if (d2)\
+	{\
+	    yuv2rgb_luma_avx2(&c, y2 + x, add, rgb);\
+	    glue(glue(yuv2rgb_store_, name), _avx2)(d2 + x * (bpp), rgb);\
+	}\
+    }\
+\
+    rest = width - x;\
+    if (rest <= 0)\
+	return;\
+    memset(tcb, 128, 16);\
+    memset(tcr, 128, 16);\
+    memset(ty1, 0, 32);\
+    memcpy(tcb, cb + (x >> 1), (rest + 1) >> 1);\
+    memcpy(tcr, cr + (x >> 1), (rest + 1) >> 1);\
+    memcpy(ty1, y1 + x, rest);\
+    yuv2rgb_chroma_avx2(&c, tcb, tcr, add);\
+    yuv2rgb_luma_avx2(&c, ty1, add, rgb);\
+    glue(glue(yuv2rgb_store_, name), _avx2)(out, rgb);\
+    memcpy(d1 + x * (bpp), out, rest * (bpp));\
+    if (d2)\
+    {\
+	memset(ty2, 0, 32);\
+	memcpy(ty2, y2 + x, rest);\
+	yuv2rgb_luma_avx2(&c, ty2, add, rgb);\
+	glue(glue(yuv2rgb_store_, name), _avx2)(out, rgb);\
+	memcpy(d2 + x * (bpp), out, rest * (bpp));\
+    }\
+}
+
+YUV2RGB_ROW_AVX2(rgb24, 3)
+YUV2RGB_ROW_AVX2(bgr24, 3)
+YUV2RGB_ROW_AVX2(rgba32, 4)
+YUV2RGB_ROW_AVX2(rgb565, 2)
+YUV2RGB_ROW_AVX2(rgb555, 2)
+
+// 调色板展开用vpgatherdd 一次取8 个像素的调色板项。
+DSP_AVX2 static void pal8_to_rgba32_row_avx2(uint32_t *dst, const uint8_t *src, const uint32_t *palette, int width)
+{
+    __m256i idx;
+    int i;
+
+    for (i = 0; i + 8 <= width; i += 8)
+    {
+	idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + i)));
+	_mm256_storeu_si256((__m256i*)(dst + i), _mm256_i32gather_epi32((const int*)palette, idx, 4));
+    }
+    for (; i < width; i++)
+	dst[i] = palette[src[i]];
+}
+
+// 8 个索引扩展成32 位后从表中收集，scale 是表项的字节数。
+DSP_AVX2 static inline __m256i pal8_gather_avx2(const void *table, const uint8_t *src, int scale)
+{
+    __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)src));
+
+    return scale == 4 ? _mm256_i32gather_epi32((const int*)table, idx, 4) : _mm256_i32gather_epi32((const int*)table, idx, 1);
+}
+
+// 亮度按32 位从lut_y 收集后取低字节，所以lut_y 后面要有PAL8_LUT_Y_PADDING 个可读的字节。一次32 个像素。
+DSP_AVX2 static inline void pal8_to_y_row_avx2(uint8_t *lum, const uint8_t *src, const uint8_t *lut_y, int width)
+{
+    __m256i mask = _mm256_set1_epi32(0xff), g[4], p;
+    int i, k;
+
+    for (i = 0; i + 32 <= width; i += 32)
+    {
+	for (k = 0; k < 4; k++)
+	    g[k] = _mm256_and_si256(pal8_gather_avx2(lut_y, src + i + 8 * k, 1), mask);
+	// 通道内打包后4 字节一组的顺序是0,2,4,6,1,3,5,7，排回原来的顺序。
+	p = _mm256_packus_epi16(_mm256_packus_epi32(g[0], g[1]), _mm256_packus_epi32(g[2], g[3]));
+	_mm256_storeu_si256((__m256i*)(lum + i), _mm256_permutevar8x32_epi32(p, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)));
+    }
+    for (; i < width; i++)
+	lum[i] = lut_y[src[i]];
+}
+
+// 和pal8_to_yuv420p_row_c 相同，色度每次16 列：上下两行的lut_uv 先按列相加，再用vphaddd 把相邻两列相加。
+DSP_AVX2 static void pal8_to_yuv420p_row_avx2(uint8_t *lum1, uint8_t *lum2, uint8_t *cb, uint8_t *cr,
+    const uint8_t *src1, const uint8_t *src2, const uint8_t *lut_y, const uint32_t *lut_uv, int width)
+{
+    __m256i s, t, v, u, w, mask = _mm256_set1_epi32(0xff);
+    __m128i lo;
+    uint32_t uv;
+    int i;
+
+    pal8_to_y_row_avx2(lum1, src1, lut_y, width);
+    if (lum2)
+	pal8_to_y_row_avx2(lum2, src2, lut_y, width);
+
+    for (i = 0; i + 16 <= width; i += 16)
+    {
+	s = _mm256_add_epi32(pal8_gather_avx2(lut_uv, src1 + i, 4), pal8_gather_avx2(lut_uv, src2 + i, 4));
+	t = _mm256_add_epi32(pal8_gather_avx2(lut_uv, src1 + i + 8, 4), pal8_gather_avx2(lut_uv, src2 + i + 8, 4));
+	// vphaddd 在通道内相加，结果的色度顺序是0,1,4,5,2,3,6,7。
+	v = _mm256_permutevar8x32_epi32(_mm256_hadd_epi32(s, t), _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7));
+	v = _mm256_add_epi32(v, _mm256_set1_epi32(0x00020002));
+	u = _mm256_and_si256(_mm256_srli_epi32(v, 2), mask);
+	w = _mm256_srli_epi32(v, 18);
+	v = _mm256_packus_epi16(_mm256_packus_epi32(u, w), _mm256_setzero_si256());
+	lo = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 4, 1, 5, 2, 3, 6, 7)));
+	_mm_storel_epi64((__m128i*)(cb + (i >> 1)), lo);
+	_mm_storel_epi64((__m128i*)(cr + (i >> 1)), _mm_unpackhi_epi64(lo, lo));
+    }
+
+    for (; i + 1 < width; i += 2)
+    {
+	uv = lut_uv[src1[i]] + lut_uv[src1[i + 1]] + lut_uv[src2[i]] + lut_uv[src2[i + 1]] + 0x00020002;
+	cb[i >> 1] = (uv >> 2) & 0xff;
+	cr[i >> 1] = uv >> 18;
+    }
+    if (i < width)
+    {
+	uv = 2 * (lut_uv[src1[i]] + lut_uv[src2[i]]) + 0x00020002;
+	cb[i >> 1] = (uv >> 2) & 0xff;
+	cr[i >> 1] = uv >> 18;
+    }
+}
+
+#endif
+
+#endif
+
+// 没有调用avcodec_init 时也能直接使用的C 实现。
+DSPContext ff_dsp =
+{
+    0,
+    copy_plane_c,
+    fill_block_c,
+    match_len_c,
+    pal8_to_rgba32_row_c,
+    pal8_to_yuv420p_row_c,
+    synth_filter8_c,
+    inverse_filter8_c,
+    post_filter8_c,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+};
+
+// 按mm_flags 填充DSPContext，先全部设成C 实现，再用CPU 支持的指令集实现替换。
+// mm_flags 一般是mm_support() 的返回值，传0 强制全部使用C 实现，便于对比测试。
+void dsputil_init(DSPContext *c, int mm_flags)
+{
+#ifndef HAVE_SSE2
+    mm_flags = 0;	// 没有编译SIMD 实现
+#endif
+#ifndef HAVE_AVX2
+    mm_flags &= ~(MM_SSSE3 | MM_AVX2);	// 编译器不支持SSSE3 和AVX2
+#endif
+    c->mm_flags = mm_flags;
+
+    c->copy_plane = copy_plane_c;
+    c->fill_block = fill_block_c;
+    c->match_len = match_len_c;
+    c->pal8_to_rgba32_row = pal8_to_rgba32_row_c;
+    c->pal8_to_yuv420p_row = pal8_to_yuv420p_row_c;
+    c->synth_filter8 = synth_filter8_c;
+    c->inverse_filter8 = inverse_filter8_c;
+    c->post_filter8 = post_filter8_c;
+    c->synth_filter8_x8 = NULL;
+    c->inverse_filter8_x8 = NULL;
+    c->post_filter8_x8 = NULL;
+    c->yuv420p_to_rgb24_row = NULL;
+    c->yuv420p_to_bgr24_row = NULL;
+    c->yuv420p_to_rgba32_row = NULL;
+    c->yuv420p_to_rgb565_row = NULL;
+    c->yuv420p_to_rgb555_row = NULL;
+
+#ifdef HAVE_SSE2
+    if (mm_flags & MM_SSE2)
+    {
+	c->copy_plane = copy_plane_sse2;
+	c->match_len = match_len_sse2;
+	c->synth_filter8 = synth_filter8_sse2;
+	c->inverse_filter8 = inverse_filter8_sse2;
+	c->post_filter8 = post_filter8_sse2;
+	c->synth_filter8_x8 = synth_filter8_x8_sse2;
+	c->inverse_filter8_x8 = inverse_filter8_x8_sse2;
+	c->post_filter8_x8 = post_filter8_x8_sse2;
+	c->yuv420p_to_rgb24_row = yuv420p_to_rgb24_row_sse2;
+	c->yuv420p_to_bgr24_row = yuv420p_to_bgr24_row_sse2;
+	c->yuv420p_to_rgba32_row = yuv420p_to_rgba32_row_sse2;
+	c->yuv420p_to_rgb565_row = yuv420p_to_rgb565_row_sse2;
+	c->yuv420p_to_rgb555_row = yuv420p_to_rgb555_row_sse2;
+    }
+#endif
+#ifdef HAVE_SSSE3
+    if (mm_flags & MM_SSSE3)
+    {
+	c->yuv420p_to_rgb24_row = yuv420p_to_rgb24_row_ssse3;
+	c->yuv420p_to_bgr24_row = yuv420p_to_bgr24_row_ssse3;
+    }
+#endif
+#ifdef HAVE_AVX2
+    if (mm_flags & MM_AVX2)
+    {
+	c->pal8_to_rgba32_row = pal8_to_rgba32_row_avx2;
+	c->pal8_to_yuv420p_row = pal8_to_yuv420p_row_avx2;
+	c->yuv420p_to_rgb24_row = yuv420p_to_rgb24_row_avx2;
+	c->yuv420p_to_bgr24_row = yuv420p_to_bgr24_row_avx2;
+	c->yuv420p_to_rgba32_row = yuv420p_to_rgba32_row_avx2;
+	c->yuv420p_to_rgb565_row = yuv420p_to_rgb565_row_avx2;
+	c->yuv420p_to_rgb555_row = yuv420p_to_rgb555_row_avx2;
+    }
+#endif
+}
@@ -1,11 +1,83 @@
-#ifndef DSPUTIL_H
-#define DSPUTIL_H
-
-// dsp Ż޷ʹõĲұʼ
-#define MAX_NEG_CROP 1024
-
-extern uint8_t cropTbl[256 + 2 * MAX_NEG_CROP];
-
-void dsputil_static_init(void);
-
-#endif
+#ifndef DSPUTIL_H
+#define DSPUTIL_H
+
+// 定义dsp 优化限幅运算使用的查找表及其初始化函数。
+#define MAX_NEG_CROP 1024
+
+extern uint8_t cropTbl[256 + 2 * MAX_NEG_CROP];
+
+void dsputil_static_init(void);
+
+// CPU 支持的加速指令集，mm_support 运行时检测，dsputil_init 据此选择各个函数的实现。
+#define MM_SSE2		0x0010
+#define MM_SSSE3	0x0080
+#define MM_AVX2		0x8000
+
+// pal8_to_yuv420p_row 的lut_y 数组后面要多分配的字节数，AVX2 实现按32 位从表中读取。
+#define PAL8_LUT_Y_PADDING	4
+
+// 可以用CPU 加速指令优化的基本运算，每个函数指针在dsputil_init 中映射到C 实现或某个指令集的实现，
+// 各实现的结果完全一样。用到这些运算的地方通过全局的ff_dsp 调用，不再各自判断指令集：msrle 解码的行程填充
+// 和调色板展开，msrleenc 的行程查找，TrueSpeech 的三级滤波，imgconvert 的平面拷贝、PAL8 和YUV420P 到RGB 的转换。
+// imgconvert 的其他转换(rgb24_to_yuv420p、色度的缩小放大等)不经过这里。
+// 目前的实现：copy_plane、match_len 和各个滤波有SSE2 实现；两个调色板函数有AVX2 实现；YUV420P 到RGB
+// 的行转换有SSE2 和AVX2 实现，rgb24/bgr24 另有SSSE3 实现。fill_block 只用memset，C 库的memset 处理短行程
+// 比自己写的SSE2 版本快。其他情况都用C 实现。
+typedef struct DSPContext
+{
+    int mm_flags;			// 实际选用的指令集
+
+    // 拷贝一个平面的width x height 个字节。
+    void (*copy_plane)(uint8_t *dst, int dst_wrap, const uint8_t *src, int src_wrap, int width, int height);
+
+    // RLE 行程填充，把len 个字节都写成value。
+    void (*fill_block)(uint8_t *dst, int value, int len);
+
+    // RLE 编码找行程和不变像素：从头比较两段数据，返回相同字节的个数，最多n 个。两段可以重叠。
+    int (*match_len)(const uint8_t *a, const uint8_t *b, int n);
+
+    // 调色板展开：一行width 个索引经调色板写成32 位像素。
+    void (*pal8_to_rgba32_row)(uint32_t *dst, const uint8_t *src, const uint32_t *palette, int width);
+
+    // 颜色转换的一行：上下两行索引src1/src2 经查找表写两行亮度和一行2x2 平均的色度，lum2 为NULL 时只写一行亮度。
+    // lut_uv 低16 位U，高16 位V；width 为奇数时最后一列色度用该列的两个像素补齐。
+    // lut_y 有AVPALETTE_COUNT + PAL8_LUT_Y_PADDING 项，多出的几项不用初始化。
+    void (*pal8_to_yuv420p_row)(uint8_t *lum1, uint8_t *lum2, uint8_t *cb, uint8_t *cr,
+	const uint8_t *src1, const uint8_t *src2, const uint8_t *lut_y, const uint32_t *lut_uv, int width);
+
+    // 8 阶Q12 定点滤波。hist 是最近的8 个值，第0 项最新，调用后更新；out 原地滤波len 个采样。
+    // synth: out = clip((hist . coefs + (out << 12) + 0x800) >> 12)，把输出移进历史。
+    void (*synth_filter8)(int16_t *out, const int16_t *coefs, int16_t *hist, int len);
+    // inverse: 把输入移进历史，out = ((out << 12) - hist . coefs) >> 12。
+    void (*inverse_filter8)(int16_t *out, const int16_t *coefs, int16_t *hist, int len);
+    // post: 和synth 一样更新历史，输出再加上前一个合成值乘gain 的倾斜补偿，并乘7/8。
+    void (*post_filter8)(int16_t *out, const int16_t *coefs, int16_t *hist, int len, int gain);
+
+    // 上面三个滤波的8 路版本，8 个流交错存放，数组每8 项是8 个流的同一个值：out 有len x 8 项，coefs 有8 x 8 项，
+    // gain 有8 项。hist 是(8 + len) x 8 的窗口，前8 行是历史，从旧到新；新移进历史的值依次写在后面，
+    // 调用者把最后8 行移回开头。为NULL 表示没有加速实现，各个流逐个用单路的函数。
+    void (*synth_filter8_x8)(int16_t *out, const int16_t *coefs, int16_t *hist, int len);
+    void (*inverse_filter8_x8)(int16_t *out, const int16_t *coefs, int16_t *hist, int len);
+    void (*post_filter8_x8)(int16_t *out, const int16_t *coefs, int16_t *hist, int len, const int16_t *gain);
+
+    // YUV420P(jpeg 为1 时是YUVJ420P) 到RGB 的一行转换：上下两行亮度y1/y2 共用一行色度，写两行width 个像素，
+    // d2 为NULL 时只写一行；width 为奇数时最后一个像素用下一个色度样本，和imgconvert 中查表的实现一样。
+    // 为NULL 表示没有加速实现，用imgconvert 中查表的C 实现。有加速实现时结果和查表完全一样。
+    void (*yuv420p_to_rgb24_row)(uint8_t *d1, uint8_t *d2, const uint8_t *y1, const uint8_t *y2,
+	const uint8_t *cb, const uint8_t *cr, int width, int jpeg);
+    void (*yuv420p_to_bgr24_row)(uint8_t *d1, uint8_t *d2, const uint8_t *y1, const uint8_t *y2,
+	const uint8_t *cb, const uint8_t *cr, int width, int jpeg);
+    void (*yuv420p_to_rgba32_row)(uint8_t *d1, uint8_t *d2, const uint8_t *y1, const uint8_t *y2,
+	const uint8_t *cb, const uint8_t *cr, int width, int jpeg);
+    void (*yuv420p_to_rgb565_row)(uint8_t *d1, uint8_t *d2, const uint8_t *y1, const uint8_t *y2,
+	const uint8_t *cb, const uint8_t *cr, int width, int jpeg);
+    void (*yuv420p_to_rgb555_row)(uint8_t *d1, uint8_t *d2, const uint8_t *y1, const uint8_t *y2,
+	const uint8_t *cb, const uint8_t *cr, int width, int jpeg);
+} DSPContext;
+
+extern DSPContext ff_dsp;
+
+int mm_support(void);
+void dsputil_init(DSPContext *c, int mm_flags);
+
+#endif
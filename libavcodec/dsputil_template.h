@@ -0,0 +1,56 @@
+// 8 阶Q12 定点滤波的模板，dsputil.c 按不同的历史实现(SUFFIX, HISTORY 和glue(hist_xxx, SUFFIX))包含多次。
+// 历史的点积和原来逐项相加一样按32 位回绕，各个实现的结果完全一样。
+
+static void glue(synth_filter8, SUFFIX)(int16_t *out, const int16_t *coefs, int16_t *hist, int len)
+{
+    HISTORY h;
+    int i, sum;
+
+    glue(hist_load, SUFFIX)(&h, hist);
+    for (i = 0; i < len; i++)
+    {
+	sum = (glue(hist_dot, SUFFIX)(&h, coefs) + (out[i] << 12) + 0x800) >> 12;
+	out[i] = clip(sum, -0x7FFE, 0x7FFE);
+	glue(hist_push, SUFFIX)(&h, out[i]);
+    }
+    glue(hist_store, SUFFIX)(&h, hist);
+}
+
+static void glue(inverse_filter8, SUFFIX)(int16_t *out, const int16_t *coefs, int16_t *hist, int len)
+{
+    HISTORY h;
+    int i, sum;
+
+    glue(hist_load, SUFFIX)(&h, hist);
+    for (i = 0; i < len; i++)
+    {
+	sum = glue(hist_dot, SUFFIX)(&h, coefs);
+	glue(hist_push, SUFFIX)(&h, out[i]);
+	out[i] = ((out[i] << 12) - sum) >> 12;
+    }
+    glue(hist_store, SUFFIX)(&h, hist);
+}
+
+// last 是移进新值之前最新的历史值。
+static void glue(post_filter8, SUFFIX)(int16_t *out, const int16_t *coefs, int16_t *hist, int len, int gain)
+{
+    HISTORY h;
+    int i, sum, cur, last = hist[0];
+
+    glue(hist_load, SUFFIX)(&h, hist);
+    for (i = 0; i < len; i++)
+    {
+	sum = (out[i] << 12) + glue(hist_dot, SUFFIX)(&h, coefs);
+	cur = clip((sum + 0x800) >> 12, -0x7FFE, 0x7FFE);
+	glue(hist_push, SUFFIX)(&h, cur);
+
+	sum = ((last * gain) >> 4) + sum;
+	sum = sum - (sum >> 3);
+	out[i] = clip((sum + 0x800) >> 12, -0x7FFE, 0x7FFE);
+	last = cur;
+    }
+    glue(hist_store, SUFFIX)(&h, hist);
+}
+
+#undef SUFFIX
+#undef HISTORY
@@ -1,300 +1,663 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-
-#include "../libavutil/common.h"
-#include "avcodec.h"
-#include "dsputil.h"
-
-// ļʵ΢г̳ѹ㷨
-
-#define FF_BUFFER_HINTS_VALID    0x01 // Buffer hints value is meaningful (if 0 ignore)
-#define FF_BUFFER_HINTS_READABLE 0x02 // Codec will read from buffer
-#define FF_BUFFER_HINTS_PRESERVE 0x04 // User must not alter buffer content
-#define FF_BUFFER_HINTS_REUSABLE 0x08 // Codec will reuse the buffer (update)
-
-typedef struct MsrleContext
-{
-    AVCodecContext *avctx;
-    AVFrame frame;
-
-    unsigned char *buf;
-    int size;
-
-} MsrleContext;
-
-#define FETCH_NEXT_STREAM_BYTE() \
-	if (stream_ptr >= s->size) \
-	{ \
-		return; \
-	} \
-	stream_byte = s->buf[stream_ptr++];
-
-static void msrle_decode_pal4(MsrleContext *s)
-{
-    int stream_ptr = 0;
-    unsigned char rle_code;
-    unsigned char extra_byte, odd_pixel;
-    unsigned char stream_byte;
-    int pixel_ptr = 0;
-    int row_dec = s->frame.linesize[0];
-    int row_ptr = (s->avctx->height - 1) *row_dec;
-    int frame_size = row_dec * s->avctx->height;
-    int i;
-
-    // make the palette available
-    memcpy(s->frame.data[1], s->avctx->palctrl->palette, AVPALETTE_SIZE);
-    if (s->avctx->palctrl->palette_changed)
-    {
-	//      s->frame.palette_has_changed = 1;
-	s->avctx->palctrl->palette_changed = 0;
-    }
-
-    while (row_ptr >= 0)
-    {
-	FETCH_NEXT_STREAM_BYTE();
-	rle_code = stream_byte;
-	if (rle_code == 0)
-	{
-	    // fetch the next byte to see how to handle escape code
-	    FETCH_NEXT_STREAM_BYTE();
-	    if (stream_byte == 0)
-	    {
-		// line is done, goto the next one
-		row_ptr -= row_dec;
-		pixel_ptr = 0;
-	    }
-	    else if (stream_byte == 1)
-	    {
-		// decode is done
-		return;
-	    }
-	    else if (stream_byte == 2)
-	    {
-		// reposition frame decode coordinates
-		FETCH_NEXT_STREAM_BYTE();
-		pixel_ptr += stream_byte;
-		FETCH_NEXT_STREAM_BYTE();
-		row_ptr -= stream_byte * row_dec;
-	    }
-	    else
-	    {
-		// copy pixels from encoded stream
-		odd_pixel = stream_byte & 1;
-		rle_code = (stream_byte + 1) / 2;
-		extra_byte = rle_code & 0x01;
-		if ((row_ptr + pixel_ptr + stream_byte > frame_size) || (row_ptr < 0))
-		{
-		    return;
-		}
-
-		for (i = 0; i < rle_code; i++)
-		{
-		    if (pixel_ptr >= s->avctx->width)
-			break;
-		    FETCH_NEXT_STREAM_BYTE();
-		    s->frame.data[0][row_ptr + pixel_ptr] = stream_byte >> 4;
-		    pixel_ptr++;
-		    if (i + 1 == rle_code && odd_pixel)
-			break;
-		    if (pixel_ptr >= s->avctx->width)
-			break;
-		    s->frame.data[0][row_ptr + pixel_ptr] = stream_byte & 0x0F;
-		    pixel_ptr++;
-		}
-
-		// if the RLE code is odd, skip a byte in the stream
-		if (extra_byte)
-		    stream_ptr++;
-	    }
-	}
-	else
-	{
-	    // decode a run of data
-	    if ((row_ptr + pixel_ptr + stream_byte > frame_size) || (row_ptr < 0))
-	    {
-		return;
-	    }
-	    FETCH_NEXT_STREAM_BYTE();
-	    for (i = 0; i < rle_code; i++)
-	    {
-		if (pixel_ptr >= s->avctx->width)
-		    break;
-		if ((i & 1) == 0)
-		    s->frame.data[0][row_ptr + pixel_ptr] = stream_byte >> 4;
-		else
-		    s->frame.data[0][row_ptr + pixel_ptr] = stream_byte & 0x0F;
-		pixel_ptr++;
-	    }
-	}
-    }
-
-    // one last sanity check on the way out
-    if (stream_ptr < s->size)
-    {
-	// error
-    }
-}
-
-static void msrle_decode_pal8(MsrleContext *s)
-{
-    int stream_ptr = 0;
-    unsigned char rle_code;
-    unsigned char extra_byte;
-    unsigned char stream_byte;
-    int pixel_ptr = 0;
-    int row_dec = s->frame.linesize[0];
-    int row_ptr = (s->avctx->height - 1) *row_dec;
-    int frame_size = row_dec * s->avctx->height;
-
-    // make the palette available
-    memcpy(s->frame.data[1], s->avctx->palctrl->palette, AVPALETTE_SIZE);
-    if (s->avctx->palctrl->palette_changed)
-    {
-	//      s->frame.palette_has_changed = 1;
-	s->avctx->palctrl->palette_changed = 0;
-    }
-
-    while (row_ptr >= 0)
-    {
-	FETCH_NEXT_STREAM_BYTE();
-	rle_code = stream_byte;
-	if (rle_code == 0)
-	{
-	    // fetch the next byte to see how to handle escape code
-	    FETCH_NEXT_STREAM_BYTE();
-	    if (stream_byte == 0)
-	    {
-		// line is done, goto the next one
-		row_ptr -= row_dec;
-		pixel_ptr = 0;
-	    }
-	    else if (stream_byte == 1)
-	    {
-		// decode is done
-		return;
-	    }
-	    else if (stream_byte == 2)
-	    {
-		// reposition frame decode coordinates
-		FETCH_NEXT_STREAM_BYTE();
-		pixel_ptr += stream_byte;
-		FETCH_NEXT_STREAM_BYTE();
-		row_ptr -= stream_byte * row_dec;
-	    }
-	    else
-	    {
-		// copy pixels from encoded stream
-		if ((row_ptr + pixel_ptr + stream_byte > frame_size) || (row_ptr < 0))
-		{
-		    return;
-		}
-
-		rle_code = stream_byte;
-		extra_byte = stream_byte & 0x01;
-		if (stream_ptr + rle_code + extra_byte > s->size)
-		{
-		    return;
-		}
-
-		while (rle_code--)
-		{
-		    FETCH_NEXT_STREAM_BYTE();
-		    s->frame.data[0][row_ptr + pixel_ptr] = stream_byte;
-		    pixel_ptr++;
-		}
-
-		// if the RLE code is odd, skip a byte in the stream
-		if (extra_byte)
-		    stream_ptr++;
-	    }
-	}
-	else
-	{
-	    // decode a run of data
-	    if ((row_ptr + pixel_ptr + stream_byte > frame_size) || (row_ptr < 0))
-	    {
-		return;
-	    }
-
-	    FETCH_NEXT_STREAM_BYTE();
-
-	    while (rle_code--)
-	    {
-		s->frame.data[0][row_ptr + pixel_ptr] = stream_byte;
-		pixel_ptr++;
-	    }
-	}
-    }
-
-    // one last sanity check on the way out
-    if (stream_ptr < s->size)
-    {
-	// error
-    }
-}
-
-static int msrle_decode_init(AVCodecContext *avctx)
-{
-    MsrleContext *s = (MsrleContext*)avctx->priv_data;
-
-    s->avctx = avctx;
-
-    avctx->pix_fmt = PIX_FMT_PAL8;
-
-    s->frame.data[0] = NULL;
-
-    return 0;
-}
-
-static int msrle_decode_frame(AVCodecContext *avctx, void *data, int *data_size, uint8_t *buf, int buf_size)
-{
-    MsrleContext *s = (MsrleContext*)avctx->priv_data;
-
-    s->buf = buf;
-    s->size = buf_size;
-
-    if (avctx->reget_buffer(avctx, &s->frame))
-	return  -1;
-
-    switch (avctx->bits_per_sample)
-    {
-    case 8:
-	msrle_decode_pal8(s);
-	break;
-    case 4:
-	msrle_decode_pal4(s);
-	break;
-    default:
-	break;
-    }
-
-    *data_size = sizeof(AVFrame);
-    *(AVFrame*)data = s->frame;
-
-    // report that the buffer was completely consumed
-    return buf_size;
-}
-
-static int msrle_decode_end(AVCodecContext *avctx)
-{
-    MsrleContext *s = (MsrleContext*)avctx->priv_data;
-
-    // release the last frame
-    if (s->frame.data[0])
-	avctx->release_buffer(avctx, &s->frame);
-
-    return 0;
-}
-
-AVCodec msrle_decoder =
-{
-	"msrle",
-	CODEC_TYPE_VIDEO,
-	CODEC_ID_MSRLE,
-	sizeof(MsrleContext),
-	msrle_decode_init,
-	NULL,
-	msrle_decode_end,
-	msrle_decode_frame
-};
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "../libavutil/common.h"
+#include "avcodec.h"
+#include "dsputil.h"
+
+// 此文件实现微软行程长度压缩算法解码器
+
+#define FF_BUFFER_HINTS_VALID    0x01 // Buffer hints value is meaningful (if 0 ignore)
+#define FF_BUFFER_HINTS_READABLE 0x02 // Codec will read from buffer
+#define FF_BUFFER_HINTS_PRESERVE 0x04 // User must not alter buffer content
+#define FF_BUFFER_HINTS_REUSABLE 0x08 // Codec will reuse the buffer (update)
+
+#define MSRLE_MAX_PENDING	64	// 最多积攒的跳过帧数，满了就解码一次，不再积攒
+
+typedef struct MsrleContext
+{
+    AVCodecContext *avctx;
+    AVFrame frame;
+
+    unsigned char *buf;
+    int size;
+
+    unsigned int palette[AVPALETTE_COUNT];	// 解码器自己保存的当前调色板
+    int palette_version;			// 当前调色板版本号，来自数据包附带的调色板
+    uint8_t *palette_dst;			// 上次写入调色板的帧缓存地址，换了缓存要重新写入
+    int palette_dst_version;			// 写入palette_dst 时的调色板版本号
+
+    // 上一输出帧之后写过的区域，行用行首偏移表示，列是[dirty_left, dirty_right)，输出时换算成AVFrame 的变化区域。
+    // 跳过不输出的帧写过的区域累计到下一个输出帧。
+    int dirty_top, dirty_bottom;
+    int dirty_left, dirty_right;
+    int dirty_full;				// 第一帧或调色板变了，整帧都算变化
+
+    // RLE 展开的目标图像。输出PAL8 时就是帧缓存；直接输出YUV420P 或RGBA32 时是解码器自己的索引图像，
+    // 解码完再把变化区域经调色板查找表写到帧缓存，增量帧只改动的像素需要上一帧的索引值来算色度。
+    uint8_t *pixels;
+    int linesize;
+    uint8_t *index_buf;
+    uint8_t lut_y[AVPALETTE_COUNT + PAL8_LUT_Y_PADDING];
+    uint32_t lut_uv[AVPALETTE_COUNT];		// 低16 位U，高16 位V，四个像素的色度一次加法就求和
+
+    uint16_t nibble_pairs[256];			// 4 位图像一个字节展开成的两个像素，高半字节在前
+
+    // 输出PAL8 时跳过的帧先不解码，数据包存在这里，等下一个要输出的帧reget_buffer 之后再依次解码。
+    // 上一帧还被显示队列引用时reget_buffer 要复制整帧，这样连续跳过多帧也只复制一次。
+    uint8_t *pending;
+    unsigned int pending_size, pending_alloc;
+    int pending_sizes[MSRLE_MAX_PENDING];
+    int nb_pending;
+
+} MsrleContext;
+
+#define FETCH_NEXT_STREAM_BYTE() \
+	if (stream_ptr >= s->size) \
+	{ \
+		return; \
+	} \
+	stream_byte = s->buf[stream_ptr++];
+
+static void msrle_build_lut(MsrleContext *s)
+{
+    uint8_t lut_u[AVPALETTE_COUNT], lut_v[AVPALETTE_COUNT];
+    int i;
+
+    ff_build_pal8_yuv_lut(s->lut_y, lut_u, lut_v, s->palette);
+    for (i = 0; i < AVPALETTE_COUNT; i++)
+	s->lut_uv[i] = lut_u[i] | (lut_v[i] << 16);
+}
+
+// 新调色板由数据包附带，解复用线程不再直接改写解码器的调色板，解码可以和解复用并行或超前。
+static void msrle_read_palette(MsrleContext *s)
+{
+    AVPacket *pkt = s->avctx->pkt;
+
+    if (pkt && pkt->palette && pkt->palette_version != s->palette_version)
+    {
+	memcpy(s->palette, pkt->palette, AVPALETTE_SIZE);
+	s->palette_version = pkt->palette_version;
+	s->dirty_full = 1;
+	if (s->avctx->pix_fmt == PIX_FMT_YUV420P)
+	    msrle_build_lut(s);
+    }
+}
+
+// 调色板只在版本变化或帧缓存换了地址时才写入帧缓存，不再每帧复制1024 字节。
+static void msrle_update_palette(MsrleContext *s)
+{
+    msrle_read_palette(s);
+
+    if (s->avctx->pix_fmt != PIX_FMT_PAL8)
+	return;
+
+    if (s->frame.data[1] != s->palette_dst || s->palette_dst_version != s->palette_version)
+    {
+	memcpy(s->frame.data[1], s->palette, AVPALETTE_SIZE);
+	s->palette_dst = s->frame.data[1];
+	s->palette_dst_version = s->palette_version;
+    }
+}
+
+// 记录一次写入影响的区域，row_ptr 是行首偏移，写入列[x, x + len)。
+// 8 位原样像素可以越过行尾写到相邻的行，这时按涉及的各行整行处理。
+static inline void msrle_mark_dirty(MsrleContext *s, int row_ptr, int x, int len)
+{
+    int row_dec;
+
+    if (x + len > s->avctx->width)
+    {
+	row_dec = s->linesize;
+	if (row_ptr + x / row_dec * row_dec < s->dirty_top)
+	    s->dirty_top = row_ptr + x / row_dec * row_dec;
+	if (row_ptr + (x + len - 1) / row_dec * row_dec > s->dirty_bottom)
+	    s->dirty_bottom = row_ptr + (x + len - 1) / row_dec * row_dec;
+	s->dirty_left = 0;
+	s->dirty_right = s->avctx->width;
+	return;
+    }
+
+    if (row_ptr < s->dirty_top)
+	s->dirty_top = row_ptr;
+    if (row_ptr > s->dirty_bottom)
+	s->dirty_bottom = row_ptr;
+    if (x < s->dirty_left)
+	s->dirty_left = x;
+    if (x + len > s->dirty_right)
+	s->dirty_right = x + len;
+}
+
+static void msrle_reset_dirty(MsrleContext *s)
+{
+    s->dirty_top = INT_MAX;
+    s->dirty_bottom = -1;
+    s->dirty_left = s->avctx->width;
+    s->dirty_right = 0;
+}
+
+// 把写过的区域换算成输出帧的变化区域。
+static void msrle_set_dirty_rect(MsrleContext *s)
+{
+    AVFrame *f = &s->frame;
+    int row_dec = s->linesize;
+    int bottom;
+
+    f->dirty_valid = 1;
+    if (s->dirty_full)
+    {
+	f->dirty_x = 0;
+	f->dirty_y = 0;
+	f->dirty_w = s->avctx->width;
+	f->dirty_h = s->avctx->height;
+	s->dirty_full = 0;
+    }
+    else if (s->dirty_bottom < s->dirty_top || s->dirty_right <= s->dirty_left)
+    {
+	f->dirty_x = f->dirty_y = 0;
+	f->dirty_w = f->dirty_h = 0;
+    }
+    else
+    {
+	bottom = s->dirty_bottom / row_dec;
+	if (bottom >= s->avctx->height)
+	    bottom = s->avctx->height - 1;
+	f->dirty_x = s->dirty_left;
+	f->dirty_y = s->dirty_top / row_dec;
+	f->dirty_w = s->dirty_right - s->dirty_left;
+	f->dirty_h = bottom - f->dirty_y + 1;
+    }
+}
+
+// 用两个像素的图案填充一段4 位图像的行程，len 为奇数时最后一个像素是图案的第一个像素。
+static inline void msrle_fill_pairs(uint8_t *dst, uint16_t pair, int len)
+{
+    uint64_t v8 = pair * uint64_t_C(0x0001000100010001);
+
+    for (; len >= 8; len -= 8, dst += 8)
+	memcpy(dst, &v8, 8);
+    for (; len >= 2; len -= 2, dst += 2)
+	memcpy(dst, &pair, 2);
+    if (len)
+	memcpy(dst, &pair, 1);
+}
+
+// 整个行程或整段原样像素都在行内、数据也够时走快速路径：一次检查，按字节查表一次写两个像素。
+// 跨过行尾或数据不够的情况照旧逐个像素处理，行尾截断后码流的位置也和原来一样。
+static void msrle_decode_pal4(MsrleContext *s)
+{
+    int stream_ptr = 0;
+    unsigned char rle_code;
+    unsigned char extra_byte, odd_pixel;
+    unsigned char stream_byte;
+    int pixel_ptr = 0;
+    int row_dec = s->linesize;
+    int row_ptr = (s->avctx->height - 1) *row_dec;
+    int frame_size = row_dec * s->avctx->height;
+    int width = s->avctx->width;
+    int start_ptr;
+    int i, pairs;
+    uint8_t *dst;
+    const uint8_t *src;
+
+    while (row_ptr >= 0)
+    {
+	FETCH_NEXT_STREAM_BYTE();
+	rle_code = stream_byte;
+	if (rle_code == 0)
+	{
+	    // fetch the next byte to see how to handle escape code
+	    FETCH_NEXT_STREAM_BYTE();
+	    if (stream_byte == 0)
+	    {
+		// line is done, goto the next one
+		row_ptr -= row_dec;
+		pixel_ptr = 0;
+	    }
+	    else if (stream_byte == 1)
+	    {
+		// decode is done
+		return;
+	    }
+	    else if (stream_byte == 2)
+	    {
+		// reposition frame decode coordinates
+		FETCH_NEXT_STREAM_BYTE();
+		pixel_ptr += stream_byte;
+		FETCH_NEXT_STREAM_BYTE();
+		row_ptr -= stream_byte * row_dec;
+	    }
+	    else
+	    {
+		// copy pixels from encoded stream
+		odd_pixel = stream_byte & 1;
+		rle_code = (stream_byte + 1) / 2;
+		extra_byte = rle_code & 0x01;
+		if ((row_ptr + pixel_ptr + stream_byte > frame_size) || (row_ptr < 0))
+		{
+		    return;
+		}
+
+		if (pixel_ptr + stream_byte <= width && stream_ptr + rle_code <= s->size)
+		{
+		    dst = s->pixels + row_ptr + pixel_ptr;
+		    src = s->buf + stream_ptr;
+		    pairs = stream_byte >> 1;
+		    for (i = 0; i < pairs; i++)
+			memcpy(dst + 2 * i, &s->nibble_pairs[src[i]], 2);
+		    if (odd_pixel)
+			dst[2 * pairs] = src[pairs] >> 4;
+		    msrle_mark_dirty(s, row_ptr, pixel_ptr, stream_byte);
+		    pixel_ptr += stream_byte;
+		    stream_ptr += rle_code + extra_byte;
+		    continue;
+		}
+
+		start_ptr = pixel_ptr;
+		for (i = 0; i < rle_code; i++)
+		{
+		    if (pixel_ptr >= s->avctx->width)
+			break;
+		    FETCH_NEXT_STREAM_BYTE();
+		    s->pixels[row_ptr + pixel_ptr] = stream_byte >> 4;
+		    pixel_ptr++;
+		    if (i + 1 == rle_code && odd_pixel)
+			break;
+		    if (pixel_ptr >= s->avctx->width)
+			break;
+		    s->pixels[row_ptr + pixel_ptr] = stream_byte & 0x0F;
+		    pixel_ptr++;
+		}
+		if (pixel_ptr > start_ptr)
+		    msrle_mark_dirty(s, row_ptr, start_ptr, pixel_ptr - start_ptr);
+
+		// if the RLE code is odd, skip a byte in the stream
+		if (extra_byte)
+		    stream_ptr++;
+	    }
+	}
+	else
+	{
+	    // decode a run of data
+	    if ((row_ptr + pixel_ptr + stream_byte > frame_size) || (row_ptr < 0))
+	    {
+		return;
+	    }
+	    FETCH_NEXT_STREAM_BYTE();
+	    if (pixel_ptr + rle_code <= width)
+	    {
+		msrle_fill_pairs(s->pixels + row_ptr + pixel_ptr, s->nibble_pairs[stream_byte], rle_code);
+		msrle_mark_dirty(s, row_ptr, pixel_ptr, rle_code);
+		pixel_ptr += rle_code;
+		continue;
+	    }
+
+	    start_ptr = pixel_ptr;
+	    for (i = 0; i < rle_code; i++)
+	    {
+		if (pixel_ptr >= s->avctx->width)
+		    break;
+		if ((i & 1) == 0)
+		    s->pixels[row_ptr + pixel_ptr] = stream_byte >> 4;
+		else
+		    s->pixels[row_ptr + pixel_ptr] = stream_byte & 0x0F;
+		pixel_ptr++;
+	    }
+	    if (pixel_ptr > start_ptr)
+		msrle_mark_dirty(s, row_ptr, start_ptr, pixel_ptr - start_ptr);
+	}
+    }
+
+    // one last sanity check on the way out
+    if (stream_ptr < s->size)
+    {
+	// error
+    }
+}
+
+// 用同一个字节填充一段像素。短行程不调用memset，用8 字节的广播写入，首尾两次写入可以重叠但不越出行程，
+// 超过16 字节的行程交给DSPContext 的fill_block。
+static inline void msrle_fill(uint8_t *dst, unsigned char value, int len)
+{
+    uint64_t v8;
+    uint32_t v4;
+    uint16_t v2;
+
+    if (len >= 8)
+    {
+	if (len > 16)
+	{
+	    ff_dsp.fill_block(dst, value, len);
+	    return;
+	}
+	v8 = value * uint64_t_C(0x0101010101010101);
+	memcpy(dst, &v8, 8);
+	memcpy(dst + len - 8, &v8, 8);
+    }
+    else if (len >= 4)
+    {
+	v4 = value * 0x01010101u;
+	memcpy(dst, &v4, 4);
+	memcpy(dst + len - 4, &v4, 4);
+    }
+    else if (len >= 2)
+    {
+	v2 = (uint16_t)(value * 0x0101u);
+	memcpy(dst, &v2, 2);
+	memcpy(dst + len - 2, &v2, 2);
+    }
+    else if (len == 1)
+    {
+	dst[0] = value;
+    }
+}
+
+// 每个操作码只做一次越界检查，行程用msrle_fill 填充，原样像素用一次memcpy 拷贝。
+// 越界检查和以前逐字节解码完全一样，原样像素可以越过行尾写到上一行，和原来的行为保持一致。
+static void msrle_decode_pal8(MsrleContext *s)
+{
+    const unsigned char *buf = s->buf;
+    uint8_t *dst = s->pixels;
+    int size = s->size;
+    int stream_ptr = 0;
+    int rle_code;
+    int stream_byte;
+    int pixel_ptr = 0;
+    int row_dec = s->linesize;
+    int row_ptr = (s->avctx->height - 1) *row_dec;
+    int frame_size = row_dec * s->avctx->height;
+
+    while (row_ptr >= 0)
+    {
+	if (stream_ptr + 2 > size)
+	{
+	    // 只剩一个字节时原来的代码取完操作码后才发现数据不够，结果一样是直接结束。
+	    return;
+	}
+	rle_code = buf[stream_ptr];
+	stream_byte = buf[stream_ptr + 1];
+	stream_ptr += 2;
+
+	if (rle_code)
+	{
+	    // decode a run of data
+	    if (row_ptr + pixel_ptr + rle_code > frame_size)
+		return;
+
+	    msrle_fill(dst + row_ptr + pixel_ptr, stream_byte, rle_code);
+	    msrle_mark_dirty(s, row_ptr, pixel_ptr, rle_code);
+	    pixel_ptr += rle_code;
+	}
+	else if (stream_byte == 0)
+	{
+	    // line is done, goto the next one
+	    row_ptr -= row_dec;
+	    pixel_ptr = 0;
+	}
+	else if (stream_byte == 1)
+	{
+	    // decode is done
+	    return;
+	}
+	else if (stream_byte == 2)
+	{
+	    // reposition frame decode coordinates
+	    if (stream_ptr + 2 > size)
+		return;
+	    pixel_ptr += buf[stream_ptr];
+	    row_ptr -= buf[stream_ptr + 1] * row_dec;
+	    stream_ptr += 2;
+	}
+	else
+	{
+	    // copy pixels from encoded stream, if the RLE code is odd, skip a byte in the stream
+	    if (row_ptr + pixel_ptr + stream_byte > frame_size)
+		return;
+	    if (stream_ptr + stream_byte + (stream_byte & 0x01) > size)
+		return;
+
+	    memcpy(dst + row_ptr + pixel_ptr, buf + stream_ptr, stream_byte);
+	    msrle_mark_dirty(s, row_ptr, pixel_ptr, stream_byte);
+	    pixel_ptr += stream_byte;
+	    stream_ptr += stream_byte + (stream_byte & 0x01);
+	}
+    }
+}
+
+// 把索引图像中[x, x + w) x [y, y + h) 的区域经查找表写到输出帧。
+// YUV420P 的区域先扩展到偶数边界，色度取2x2 四个像素的YUV444 值求平均，和img_convert 转换的结果完全一样；
+// 宽高为奇数时最后一列/行的色度用现有的像素补齐。返回时x, y, w, h 是实际写过的区域。
+static void msrle_output_rect(MsrleContext *s, int *px, int *py, int *pw, int *ph)
+{
+    AVFrame *f = &s->frame;
+    int width = s->avctx->width, height = s->avctx->height;
+    int x = *px, y = *py, x_end = *px + *pw, y_end = *py + *ph;
+    int j;
+    const uint8_t *s1, *s2;
+    uint8_t *lum;
+
+    if (s->avctx->pix_fmt == PIX_FMT_RGBA32)
+    {
+	for (j = y; j < y_end; j++)
+	    ff_dsp.pal8_to_rgba32_row((uint32_t*)(f->data[0] + j * f->linesize[0]) + x,
+		s->index_buf + j * s->linesize + x, s->palette, x_end - x);
+	return;
+    }
+
+    x &= ~1;
+    y &= ~1;
+    x_end = (x_end + 1) & ~1;
+    y_end = (y_end + 1) & ~1;
+    if (x_end > width)
+	x_end = width;
+    if (y_end > height)
+	y_end = height;
+
+    for (j = y; j < y_end; j += 2)
+    {
+	s1 = s->index_buf + j * s->linesize + x;
+	s2 = j + 1 < height ? s1 + s->linesize : s1;
+	lum = f->data[0] + j * f->linesize[0] + x;
+
+	ff_dsp.pal8_to_yuv420p_row(lum, j + 1 < height ? lum + f->linesize[0] : NULL,
+	    f->data[1] + (j >> 1) * f->linesize[1] + (x >> 1), f->data[2] + (j >> 1) * f->linesize[2] + (x >> 1),
+	    s1, s2, s->lut_y, s->lut_uv, x_end - x);
+    }
+
+    *px = x;
+    *py = y;
+    *pw = x_end - x;
+    *ph = y_end - y;
+}
+
+static int msrle_decode_init(AVCodecContext *avctx)
+{
+    MsrleContext *s = (MsrleContext*)avctx->priv_data;
+    uint8_t pair[2];
+    int i;
+
+    s->avctx = avctx;
+
+    avctx->pix_fmt = PIX_FMT_PAL8;
+
+    s->frame.data[0] = NULL;
+    s->index_buf = NULL;
+
+    // 初始调色板来自文件头，之后的变化随数据包传入。
+    if (avctx->palctrl)
+    {
+	memcpy(s->palette, avctx->palctrl->palette, AVPALETTE_SIZE);
+	avctx->palctrl->palette_changed = 0;
+    }
+    s->palette_version = 0;
+    s->palette_dst = NULL;
+    s->dirty_full = 1;
+    msrle_reset_dirty(s);
+
+    for (i = 0; i < 256; i++)
+    {
+	pair[0] = i >> 4;
+	pair[1] = i & 0x0F;
+	memcpy(&s->nibble_pairs[i], pair, 2);
+    }
+
+    // 调用者要求时直接输出YUV420P 或RGBA32，省掉显示前PAL8 经RGB24 再到YUV 的两遍转换和中间图像。
+    if (avctx->request_pix_fmt == PIX_FMT_YUV420P || avctx->request_pix_fmt == PIX_FMT_RGBA32)
+    {
+	if (avctx->width <= 0 || avctx->height <= 0)
+	    return  -1;
+	s->linesize = (avctx->width + 15) & ~15;
+	s->index_buf = av_mallocz(s->linesize * avctx->height);
+	if (!s->index_buf)
+	    return  -1;
+	avctx->pix_fmt = avctx->request_pix_fmt;
+	if (avctx->pix_fmt == PIX_FMT_YUV420P)
+	    msrle_build_lut(s);
+    }
+
+    return 0;
+}
+
+static void msrle_decode_rle(MsrleContext *s, uint8_t *buf, int buf_size)
+{
+    s->buf = buf;
+    s->size = buf_size;
+
+    switch (s->avctx->bits_per_sample)
+    {
+    case 8:
+	msrle_decode_pal8(s);
+	break;
+    case 4:
+	msrle_decode_pal4(s);
+	break;
+    default:
+	break;
+    }
+}
+
+// 保存一个跳过的帧的数据包，以后再解码。
+static int msrle_defer_frame(MsrleContext *s, uint8_t *buf, int buf_size)
+{
+    uint8_t *pending;
+
+    if (s->nb_pending >= MSRLE_MAX_PENDING || buf_size > INT_MAX - (int)s->pending_size)
+	return  -1;
+
+    pending = av_fast_realloc(s->pending, &s->pending_alloc, s->pending_size + buf_size);
+    if (!pending)
+    {
+	s->pending_alloc = s->pending_size;
+	return  -1;
+    }
+    s->pending = pending;
+
+    memcpy(s->pending + s->pending_size, buf, buf_size);
+    s->pending_size += buf_size;
+    s->pending_sizes[s->nb_pending++] = buf_size;
+    return 0;
+}
+
+static void msrle_decode_pending(MsrleContext *s)
+{
+    uint8_t *buf = s->pending;
+    int i;
+
+    for (i = 0; i < s->nb_pending; i++)
+    {
+	msrle_decode_rle(s, buf, s->pending_sizes[i]);
+	buf += s->pending_sizes[i];
+    }
+    s->nb_pending = 0;
+    s->pending_size = 0;
+}
+
+static int msrle_decode_frame(AVCodecContext *avctx, void *data, int *data_size, uint8_t *buf, int buf_size)
+{
+    MsrleContext *s = (MsrleContext*)avctx->priv_data;
+    int skip;
+
+    // 每一帧都是后面增量帧的参考，只有"只要关键帧"时才跳过非关键帧，跳过的帧不输出，但以后的帧要在它的基础上解码。
+    skip = avctx->skip_frame >= AVDISCARD_NONKEY && !(avctx->pkt && (avctx->pkt->flags & PKT_FLAG_KEY));
+
+    // 输出PAL8 时参考图像就是帧缓存，跳过的帧不碰帧缓存，只保存数据包，积攒满了才解码一次。
+    if (skip && !s->index_buf)
+    {
+	msrle_read_palette(s);
+	if (msrle_defer_frame(s, buf, buf_size) == 0)
+	{
+	    *data_size = 0;
+	    return buf_size;
+	}
+    }
+
+    // 增量帧在上一帧的图像上修改，上一帧还被显示队列引用时reget_buffer 会先等它解码完成再复制一份。
+    // 直接输出时参考图像是内部的索引图像，跳过的帧不用碰帧缓存，也不做查找表转换。
+    if ((!s->index_buf || !skip) && avctx->reget_buffer(avctx, &s->frame))
+	return  -1;
+
+    // make the palette available
+    msrle_update_palette(s);
+
+    if (s->index_buf)
+    {
+	s->pixels = s->index_buf;
+    }
+    else
+    {
+	s->pixels = s->frame.data[0];
+	s->linesize = s->frame.linesize[0];
+    }
+
+    // 先按顺序补上前面跳过的帧。
+    if (s->nb_pending)
+	msrle_decode_pending(s);
+    msrle_decode_rle(s, buf, buf_size);
+
+    if (skip)
+    {
+	*data_size = 0;
+	return buf_size;
+    }
+
+    // 图像是从下往上解码的，行进度没有意义，整帧解完后一次报告完成。
+    msrle_set_dirty_rect(s);
+    if (s->index_buf && s->frame.dirty_w > 0 && s->frame.dirty_h > 0)
+	msrle_output_rect(s, &s->frame.dirty_x, &s->frame.dirty_y, &s->frame.dirty_w, &s->frame.dirty_h);
+    msrle_reset_dirty(s);
+    av_frame_report_progress(&s->frame, AV_FRAME_PROGRESS_DONE);
+
+    *data_size = sizeof(AVFrame);
+    *(AVFrame*)data = s->frame;
+
+    // report that the buffer was completely consumed
+    return buf_size;
+}
+
+static int msrle_decode_end(AVCodecContext *avctx)
+{
+    MsrleContext *s = (MsrleContext*)avctx->priv_data;
+
+    // release the last frame
+    if (s->frame.data[0])
+	avctx->release_buffer(avctx, &s->frame);
+
+    av_freep(&s->index_buf);
+    av_freep(&s->pending);
+
+    return 0;
+}
+
+AVCodec msrle_decoder =
+{
+	"msrle",
+	CODEC_TYPE_VIDEO,
+	CODEC_ID_MSRLE,
+	sizeof(MsrleContext),
+	msrle_decode_init,
+	NULL,
+	msrle_decode_end,
+	msrle_decode_frame
+};
@@ -0,0 +1,452 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../libavutil/common.h"
+#include "../libavutil/avthread.h"
+#include "avcodec.h"
+#include "dsputil.h"
+
+// 此文件实现微软行程长度压缩算法编码器，输出8 位(RLE8)或4 位(RLE4)码流，msrle_decode_frame 解码后和输入完全一样。
+// 输入是PAL8 图像，4 位编码时索引必须小于16。只编码索引，调色板由容器保存。
+// 非关键帧和上一帧比较，没变的像素用跳过像素(转义码2)，整行没变的连续几行合成一次跳行。
+// 行之间没有依赖，图像分成几个行带由多个线程同时编码。每个行带按从下往上的顺序把自己的行连同行间的跳行
+// 写到自己的输出缓存，并更新自己那几行的上一帧图像，调用线程最后只按顺序拼接各行带的输出。
+
+#define FFMIN(a,b) ((a) > (b) ? (b) : (a))
+
+#define MSRLE_MAX_THREADS	16
+#define MSRLE_MIN_RUN		3	// 短于此长度的相同像素并入原样像素
+#define MSRLE_MIN_SKIP		8	// 不变像素至少这么长才单独用跳过，跳过一次要4 字节
+
+typedef struct MsrleEncWorker
+{
+    struct MsrleEncContext *s;
+    int band;
+    AVThread thread;
+} MsrleEncWorker;
+
+// 一个行带的编码结果。行带开头(图像中靠下的一端)和结尾的连续不变行不在buf 中，拼接时和相邻行带的合成一次跳行。
+typedef struct MsrleEncBand
+{
+    uint8_t *buf;			// 指向row_buf 中这个行带的几行
+    int size;				// 除去开头和结尾的不变行，编码后的字节数，0 表示整个行带都没变
+    int lead_skip;			// 开头的不变行数
+    int trail_skip;			// 结尾的不变行数
+} MsrleEncBand;
+
+typedef struct MsrleEncContext
+{
+    AVCodecContext *avctx;
+    AVFrame coded_frame;
+
+    uint8_t *prev;			// 上一帧的索引图像，每行width 字节，解码器在这个图像上做增量
+    int have_prev;
+    int frames_since_key;
+
+    // 当前帧，编码期间只读。prev_rows 为NULL 表示关键帧。
+    const uint8_t *cur;
+    int cur_linesize;
+    const uint8_t *prev_rows;
+
+    uint8_t *row_buf;			// 输出缓存，每行row_max 字节，行带连续使用自己那几行的空间
+    int row_max;
+    MsrleEncBand bands[MSRLE_MAX_THREADS + 1];
+
+    // 工作线程，线程i 编码第i + 1 个行带，调用线程编码第0 个。
+    MsrleEncWorker workers[MSRLE_MAX_THREADS];
+    int nb_workers;
+    AVMutex lock;
+    AVCond cond;			// 有新的一帧或要退出
+    AVCond done_cond;			// 所有行带都编码完了
+    int job;				// 帧序号，工作线程据此发现新任务
+    int nb_pending;			// 还没编码完的工作线程数
+    int quit;
+} MsrleEncContext;
+
+// 输出一段原样像素，太长的分段，不到3 个像素的改用长度为1 或2 的行程。
+static uint8_t *msrle_put_literal(MsrleEncContext *s, uint8_t *dst, const uint8_t *src, int n)
+{
+    int bpp = s->avctx->bits_per_sample;
+    int k, i, bytes;
+
+    while (n > 0)
+    {
+	k = FFMIN(n, 254);
+	if (k < MSRLE_MIN_RUN)
+	{
+	    if (bpp == 4)
+	    {
+		// 4 位行程的值字节高低半字节交替输出，两个像素正好是一个长度为2 的行程。
+		*dst++ = k;
+		*dst++ = ((src[0] & 0x0F) << 4) | (k == 2 ? src[1] & 0x0F : src[0] & 0x0F);
+	    }
+	    else
+	    {
+		for (i = 0; i < k; i++)
+		{
+		    *dst++ = 1;
+		    *dst++ = src[i];
+		}
+	    }
+	}
+	else
+	{
+	    *dst++ = 0;
+	    *dst++ = k;
+	    if (bpp == 4)
+	    {
+		bytes = (k + 1) / 2;
+		for (i = 0; i + 1 < k; i += 2)
+		    *dst++ = ((src[i] & 0x0F) << 4) | (src[i + 1] & 0x0F);
+		if (k & 1)
+		    *dst++ = (src[k - 1] & 0x0F) << 4;
+	    }
+	    else
+	    {
+		bytes = k;
+		memcpy(dst, src, k);
+		dst += k;
+	    }
+	    // 原样像素的字节数为奇数时补一个字节
+	    if (bytes & 1)
+		*dst++ = 0;
+	}
+	src += k;
+	n -= k;
+    }
+    return dst;
+}
+
+// 编码一行中[x, end) 这一段像素，相同像素组成行程，其余的作为原样像素。
+// 4 位图像的行程是两个像素交替的图案，所以比较的是相隔两个像素的值。
+static uint8_t *msrle_encode_span(MsrleEncContext *s, uint8_t *dst, const uint8_t *src, int x, int end)
+{
+    int period = s->avctx->bits_per_sample == 4 ? 2 : 1;
+    int lit = x, run;
+
+    while (x < end)
+    {
+	if (end - x > period)
+	    run = period + ff_dsp.match_len(src + x + period, src + x, FFMIN(end - x, 255) - period);
+	else
+	    run = end - x;
+
+	if (run >= MSRLE_MIN_RUN)
+	{
+	    dst = msrle_put_literal(s, dst, src + lit, x - lit);
+	    *dst++ = run;
+	    if (period == 2)
+		*dst++ = ((src[x] & 0x0F) << 4) | (src[x + 1] & 0x0F);
+	    else
+		*dst++ = src[x];
+	    x += run;
+	    lit = x;
+	}
+	else
+	{
+	    x++;
+	}
+    }
+    return msrle_put_literal(s, dst, src + lit, x - lit);
+}
+
+// 编码一行到start，不含行尾标记。返回字节数，0 表示非关键帧中这一行完全没变。
+// 行尾的不变像素直接用行尾标记跳过，中间的长段不变像素用跳过像素。
+static int msrle_encode_row(MsrleEncContext *s, int y, uint8_t *start)
+{
+    int width = s->avctx->width;
+    const uint8_t *src = s->cur + y * s->cur_linesize;
+    const uint8_t *ref = s->prev_rows ? s->prev_rows + y * width : NULL;
+    uint8_t *dst = start;
+    int x = 0, end, m, n;
+
+    while (x < width)
+    {
+	if (ref)
+	{
+	    m = ff_dsp.match_len(src + x, ref + x, width - x);
+	    if (x + m == width)
+		break;
+	    if (m >= MSRLE_MIN_SKIP)
+	    {
+		x += m;
+		for (; m > 0; m -= n)
+		{
+		    n = FFMIN(m, 255);
+		    *dst++ = 0;
+		    *dst++ = 2;
+		    *dst++ = n;
+		    *dst++ = 0;
+		}
+		continue;
+	    }
+
+	    // 变化的一段到下一段足够长的不变像素或行尾的不变像素为止，中间短的不变像素一起编码。
+	    for (end = x; end < width; end += m + 1)
+	    {
+		m = ff_dsp.match_len(src + end, ref + end, width - end);
+		if (m >= MSRLE_MIN_SKIP || end + m == width)
+		    break;
+	    }
+	}
+	else
+	{
+	    end = width;
+	}
+
+	dst = msrle_encode_span(s, dst, src, x, end);
+	x = end;
+    }
+
+    return dst - start;
+}
+
+// 连续n 个不变行合成跳行(转义码2，水平位移0)，每次最多255 行。
+static uint8_t *msrle_put_skip_rows(uint8_t *dst, int n)
+{
+    int k;
+
+    for (; n > 0; n -= k)
+    {
+	k = FFMIN(n, 255);
+	*dst++ = 0;
+	*dst++ = 2;
+	*dst++ = 0;
+	*dst++ = k;
+    }
+    return dst;
+}
+
+// 编码一个行带，从下往上和码流中的顺序一样。每行编码完就把它写进上一帧图像，只有这个行带会读这几行。
+static void msrle_encode_band(MsrleEncContext *s, int band)
+{
+    MsrleEncBand *b = &s->bands[band];
+    int width = s->avctx->width, height = s->avctx->height;
+    int nb_bands = s->nb_workers + 1;
+    int y0 = band * height / nb_bands, y1 = (band + 1) * height / nb_bands;
+    int y, n, skip = 0, changed = 0;
+    uint8_t *dst;
+
+    b->buf = s->row_buf + y0 * s->row_max;
+    dst = b->buf;
+
+    for (y = y1 - 1; y >= y0; y--)
+    {
+	// 前面积攒的跳行最多占4 字节每行，先空出来，这一行有变化时再填上。
+	n = msrle_encode_row(s, y, dst + (changed ? (skip + 254) / 255 * 4 : 0));
+	memcpy(s->prev + y * width, s->cur + y * s->cur_linesize, width);
+	if (n == 0)
+	{
+	    skip++;
+	    continue;
+	}
+
+	if (changed)
+	    dst = msrle_put_skip_rows(dst, skip);
+	else
+	    b->lead_skip = skip;
+	changed = 1;
+	skip = 0;
+	dst += n;
+	// line is done
+	*dst++ = 0;
+	*dst++ = 0;
+    }
+
+    if (!changed)
+	b->lead_skip = skip;
+    b->trail_skip = changed ? skip : 0;
+    b->size = dst - b->buf;
+}
+
+static void *msrle_encode_worker(void *arg)
+{
+    MsrleEncWorker *w = arg;
+    MsrleEncContext *s = w->s;
+    int job = 0;
+
+    for (;;)
+    {
+	av_mutex_lock(&s->lock);
+	while (!s->quit && s->job == job)
+	    av_cond_wait(&s->cond, &s->lock);
+	if (s->quit)
+	{
+	    av_mutex_unlock(&s->lock);
+	    break;
+	}
+	job = s->job;
+	av_mutex_unlock(&s->lock);
+
+	msrle_encode_band(s, w->band);
+
+	av_mutex_lock(&s->lock);
+	if (--s->nb_pending == 0)
+	    av_cond_signal(&s->done_cond);
+	av_mutex_unlock(&s->lock);
+    }
+
+    return NULL;
+}
+
+static void msrle_encode_stop_workers(MsrleEncContext *s)
+{
+    int i;
+
+    av_mutex_lock(&s->lock);
+    s->quit = 1;
+    av_cond_broadcast(&s->cond);
+    av_mutex_unlock(&s->lock);
+
+    for (i = 0; i < s->nb_workers; i++)
+	av_thread_join(s->workers[i].thread);
+    s->nb_workers = 0;
+}
+
+static int msrle_encode_init(AVCodecContext *avctx)
+{
+    MsrleEncContext *s = (MsrleEncContext*)avctx->priv_data;
+    int i, nb_threads;
+
+    s->avctx = avctx;
+
+    if (avctx->bits_per_sample != 4 && avctx->bits_per_sample != 8)
+	return  -1;
+    if (avctx->width <= 0 || avctx->height <= 0 || avcodec_check_dimensions(avctx, avctx->width, avctx->height))
+	return  -1;
+    avctx->pix_fmt = PIX_FMT_PAL8;
+
+    // 一行最坏每个像素2 字节：短行程和原样像素都不超过这个数，跳过像素至少8 个像素才用4 字节。
+    // 另外加上行前的跳行(每个不变行最多4 字节)和行尾标记。
+    s->row_max = avctx->width * 2 + 4 + 4 + 2;
+    s->row_buf = av_malloc(s->row_max * avctx->height);
+    s->prev = av_malloc(avctx->width * avctx->height);
+    if (!s->row_buf || !s->prev)
+	goto fail;
+    s->have_prev = 0;
+
+    av_mutex_init(&s->lock);
+    av_cond_init(&s->cond);
+    av_cond_init(&s->done_cond);
+    s->job = 0;
+    s->quit = 0;
+    s->nb_workers = 0;
+
+    // 每个行带至少16 行，小图像线程再多也没用。
+    nb_threads = FFMIN(avctx->thread_count, MSRLE_MAX_THREADS + 1);
+    nb_threads = FFMIN(nb_threads, avctx->height / 16);
+    for (i = 0; i + 1 < nb_threads; i++)
+    {
+	s->workers[i].s = s;
+	s->workers[i].band = i + 1;
+	if (av_thread_create(&s->workers[i].thread, msrle_encode_worker, &s->workers[i]) < 0)
+	    break;
+	s->nb_workers++;
+    }
+
+    avctx->coded_frame = &s->coded_frame;
+    return 0;
+
+fail:
+    av_freep(&s->row_buf);
+    av_freep(&s->prev);
+    return  -1;
+}
+
+static int msrle_encode_frame(AVCodecContext *avctx, uint8_t *buf, int buf_size, void *data)
+{
+    MsrleEncContext *s = (MsrleEncContext*)avctx->priv_data;
+    const AVFrame *pict = data;
+    uint8_t *dst = buf, *end = buf + buf_size;
+    int key, i, skip_rows;
+    MsrleEncBand *b;
+
+    key = !s->have_prev || (avctx->gop_size > 0 && s->frames_since_key >= avctx->gop_size);
+
+    s->cur = pict->data[0];
+    s->cur_linesize = pict->linesize[0];
+    s->prev_rows = key ? NULL : s->prev;
+
+    // 分行带并行编码，调用线程也编码一个行带。
+    if (s->nb_workers)
+    {
+	av_mutex_lock(&s->lock);
+	s->job++;
+	s->nb_pending = s->nb_workers;
+	av_cond_broadcast(&s->cond);
+	av_mutex_unlock(&s->lock);
+    }
+    msrle_encode_band(s, 0);
+    if (s->nb_workers)
+    {
+	av_mutex_lock(&s->lock);
+	while (s->nb_pending > 0)
+	    av_cond_wait(&s->done_cond, &s->lock);
+	av_mutex_unlock(&s->lock);
+    }
+
+    // 图像从下往上存放，从最后一个行带开始拼接，行带交界处连续没变的行合成一次跳行。
+    // 上一帧图像已经由各行带更新，输出缓存不够时这一帧作废，下一帧只能编成关键帧。
+    skip_rows = 0;
+    for (i = s->nb_workers; i >= 0; i--)
+    {
+	b = &s->bands[i];
+	skip_rows += b->lead_skip;
+	if (b->size == 0)
+	    continue;
+	if (end - dst < (skip_rows + 254) / 255 * 4 + b->size + 2)
+	{
+	    s->have_prev = 0;
+	    return  -1;
+	}
+	dst = msrle_put_skip_rows(dst, skip_rows);
+	memcpy(dst, b->buf, b->size);
+	dst += b->size;
+	skip_rows = b->trail_skip;
+    }
+    if (end - dst < 2)
+    {
+	s->have_prev = 0;
+	return  -1;
+    }
+    // 剩下的行都没变，直接结束
+    *dst++ = 0;
+    *dst++ = 1;
+
+    s->have_prev = 1;
+    s->frames_since_key = key ? 1 : s->frames_since_key + 1;
+
+    s->coded_frame.key_frame = key;
+    s->coded_frame.coded_picture_number = avctx->frame_number;
+
+    return dst - buf;
+}
+
+static int msrle_encode_end(AVCodecContext *avctx)
+{
+    MsrleEncContext *s = (MsrleEncContext*)avctx->priv_data;
+
+    msrle_encode_stop_workers(s);
+    av_cond_destroy(&s->done_cond);
+    av_cond_destroy(&s->cond);
+    av_mutex_destroy(&s->lock);
+
+    av_freep(&s->row_buf);
+    av_freep(&s->prev);
+    avctx->coded_frame = NULL;
+
+    return 0;
+}
+
+AVCodec msrle_encoder =
+{
+	"msrle",
+	CODEC_TYPE_VIDEO,
+	CODEC_ID_MSRLE,
+	sizeof(MsrleEncContext),
+	msrle_encode_init,
+	msrle_encode_frame,
+	msrle_encode_end,
+	NULL
+};
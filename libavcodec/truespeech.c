@@ -1,377 +1,523 @@
-#include "avcodec.h"
-
-#include "truespeech_data.h"
-
-// TrueSpeech decoder context
-// ļʵtrue speed Ƶ
-typedef struct TSContext
-{
-    // input data
-    int16_t vector[8];   // input vector: 5/5/4/4/4/3/3/3
-    int offset1[2];      // 8-bit value, used in one copying offset
-    int offset2[4];      // 7-bit value, encodes offsets for copying and for two-point filter
-    int pulseoff[4];     // 4-bit offset of pulse values block
-    int pulsepos[4];     // 27-bit variable, encodes 7 pulse positions
-    int pulseval[4];     // 7x2-bit pulse values
-    int flag;            // 1-bit flag, shows how to choose filters
-    // temporary data
-    int filtbuf[146];    // some big vector used for storing filters
-    int prevfilt[8];     // filter from previous frame
-    int16_t tmp1[8];     // coefficients for adding to out
-    int16_t tmp2[8];     // coefficients for adding to out
-    int16_t tmp3[8];     // coefficients for adding to out
-    int16_t cvector[8];  // correlated input vector
-    int filtval;         // gain value for one function
-    int16_t newvec[60];  // tmp vector
-    int16_t filters[32]; // filters for every subframe
-} TSContext;
-
-#if !defined(LE_32)
-#define LE_32(x)  ((((uint8_t*)(x))[3] << 24)| (((uint8_t*)(x))[2] << 16) | \
-                   (((uint8_t*)(x))[1] << 8) | ((uint8_t*)(x))[0])
-#endif
-
-static int truespeech_decode_init(AVCodecContext *avctx)
-{
-    return 0; //  TSContext *c = avctx->priv_data;
-}
-
-static void truespeech_read_frame(TSContext *dec, uint8_t *input)
-{
-    uint32_t t;
-
-    t = LE_32(input); // first dword
-    input += 4;
-
-    dec->flag = t & 1;
-
-    dec->vector[0] = ts_codebook[0][(t >> 1) & 0x1F];
-    dec->vector[1] = ts_codebook[1][(t >> 6) & 0x1F];
-    dec->vector[2] = ts_codebook[2][(t >> 11) & 0xF];
-    dec->vector[3] = ts_codebook[3][(t >> 15) & 0xF];
-    dec->vector[4] = ts_codebook[4][(t >> 19) & 0xF];
-    dec->vector[5] = ts_codebook[5][(t >> 23) & 0x7];
-    dec->vector[6] = ts_codebook[6][(t >> 26) & 0x7];
-    dec->vector[7] = ts_codebook[7][(t >> 29) & 0x7];
-
-
-    t = LE_32(input); // second dword
-    input += 4;
-
-    dec->offset2[0] = (t >> 0) & 0x7F;
-    dec->offset2[1] = (t >> 7) & 0x7F;
-    dec->offset2[2] = (t >> 14) & 0x7F;
-    dec->offset2[3] = (t >> 21) & 0x7F;
-
-    dec->offset1[0] = ((t >> 28) & 0xF) << 4;
-
-
-    t = LE_32(input); // third dword
-    input += 4;
-
-    dec->pulseval[0] = (t >> 0) & 0x3FFF;
-    dec->pulseval[1] = (t >> 14) & 0x3FFF;
-
-    dec->offset1[1] = (t >> 28) & 0x0F;
-
-
-    t = LE_32(input); // fourth dword
-    input += 4;
-
-    dec->pulseval[2] = (t >> 0) & 0x3FFF;
-    dec->pulseval[3] = (t >> 14) & 0x3FFF;
-
-    dec->offset1[1] |= ((t >> 28) & 0x0F) << 4;
-
-
-    t = LE_32(input); // fifth dword
-    input += 4;
-
-    dec->pulsepos[0] = (t >> 4) & 0x7FFFFFF;
-
-    dec->pulseoff[0] = (t >> 0) & 0xF;
-
-    dec->offset1[0] |= (t >> 31) & 1;
-
-
-    t = LE_32(input); // sixth dword
-    input += 4;
-
-    dec->pulsepos[1] = (t >> 4) & 0x7FFFFFF;
-
-    dec->pulseoff[1] = (t >> 0) & 0xF;
-
-    dec->offset1[0] |= ((t >> 31) & 1) << 1;
-
-
-    t = LE_32(input); // seventh dword
-    input += 4;
-
-    dec->pulsepos[2] = (t >> 4) & 0x7FFFFFF;
-
-    dec->pulseoff[2] = (t >> 0) & 0xF;
-
-    dec->offset1[0] |= ((t >> 31) & 1) << 2;
-
-
-    t = LE_32(input); // eighth dword
-    input += 4;
-
-    dec->pulsepos[3] = (t >> 4) & 0x7FFFFFF;
-
-    dec->pulseoff[3] = (t >> 0) & 0xF;
-
-    dec->offset1[0] |= ((t >> 31) & 1) << 3;
-}
-
-static void truespeech_correlate_filter(TSContext *dec)
-{
-    int16_t tmp[8];
-    int i, j;
-
-    for (i = 0; i < 8; i++)
-    {
-	if (i > 0)
-	{
-	    memcpy(tmp, dec->cvector, i * 2);
-	    for (j = 0; j < i; j++)
-		dec->cvector[j] = ((tmp[i - j - 1] * dec->vector[i]) + (dec->cvector[j] << 15) + 0x4000) >> 15;
-	}
-	dec->cvector[i] = (8 - dec->vector[i]) >> 3;
-    }
-
-    for (i = 0; i < 8; i++)
-	dec->cvector[i] = (dec->cvector[i] * ts_230[i]) >> 15;
-
-    dec->filtval = dec->vector[0];
-}
-
-static void truespeech_filters_merge(TSContext *dec)
-{
-    int i;
-
-    if (!dec->flag)
-    {
-	for (i = 0; i < 8; i++)
-	{
-	    dec->filters[i + 0] = dec->prevfilt[i];
-	    dec->filters[i + 8] = dec->prevfilt[i];
-	}
-    }
-    else
-    {
-	for (i = 0; i < 8; i++)
-	{
-	    dec->filters[i + 0] = (dec->cvector[i] * 21846 + dec->prevfilt[i] * 10923 + 16384) >> 15;
-	    dec->filters[i + 8] = (dec->cvector[i] * 10923 + dec->prevfilt[i] * 21846 + 16384) >> 15;
-	}
-    }
-    for (i = 0; i < 8; i++)
-    {
-	dec->filters[i + 16] = dec->cvector[i];
-	dec->filters[i + 24] = dec->cvector[i];
-    }
-}
-
-static void truespeech_apply_twopoint_filter(TSContext *dec, int quart)
-{
-    int16_t tmp[146 + 60], *ptr0, *ptr1, *filter;
-    int i, t, off;
-
-    t = dec->offset2[quart];
-    if (t == 127)
-    {
-	memset(dec->newvec, 0, 60 * 2);
-	return;
-    }
-
-    for (i = 0; i < 146; i++)
-	tmp[i] = dec->filtbuf[i];
-
-    off = (t / 25) + dec->offset1[quart >> 1] + 18;
-    ptr0 = tmp + 145 - off;
-    ptr1 = tmp + 146;
-    filter = (int16_t*)ts_240 + (t % 25) * 2;
-    for (i = 0; i < 60; i++)
-    {
-	t = (ptr0[0] * filter[0] + ptr0[1] * filter[1] + 0x2000) >> 14;
-	ptr0++;
-	dec->newvec[i] = t;
-	ptr1[i] = t;
-    }
-}
-
-static void truespeech_place_pulses(TSContext *dec, int16_t *out, int quart)
-{
-    int16_t tmp[7];
-    int i, j, t;
-    int16_t *ptr1, *ptr2;
-    int coef;
-
-    memset(out, 0, 60 * 2);
-    for (i = 0; i < 7; i++)
-    {
-	t = dec->pulseval[quart] & 3;
-	dec->pulseval[quart] >>= 2;
-	tmp[6 - i] = ts_562[dec->pulseoff[quart] * 4 + t];
-    }
-
-    coef = dec->pulsepos[quart] >> 15;
-    ptr1 = (int16_t*)ts_140 + 30;
-    ptr2 = tmp;
-    for (i = 0, j = 3; (i < 30) && (j > 0); i++)
-    {
-	t = *ptr1++;
-	if (coef >= t)
-	    coef -= t;
-	else
-	{
-	    out[i] = *ptr2++;
-	    ptr1 += 30;
-	    j--;
-	}
-    }
-    coef = dec->pulsepos[quart] & 0x7FFF;
-    ptr1 = (int16_t*)ts_140;
-    for (i = 30, j = 4; (i < 60) && (j > 0); i++)
-    {
-	t = *ptr1++;
-	if (coef >= t)
-	    coef -= t;
-	else
-	{
-	    out[i] = *ptr2++;
-	    ptr1 += 30;
-	    j--;
-	}
-    }
-}
-
-static void truespeech_update_filters(TSContext *dec, int16_t *out, int quart)
-{
-    int i;
-
-    for (i = 0; i < 86; i++)
-	dec->filtbuf[i] = dec->filtbuf[i + 60];
-
-    for (i = 0; i < 60; i++)
-    {
-	dec->filtbuf[i + 86] = out[i] + dec->newvec[i] - (dec->newvec[i] >> 3);
-	out[i] += dec->newvec[i];
-    }
-}
-
-static void truespeech_synth(TSContext *dec, int16_t *out, int quart)
-{
-    int i, k;
-    int t[8];
-    int16_t *ptr0, *ptr1;
-
-    ptr0 = dec->tmp1;
-    ptr1 = dec->filters + quart * 8;
-    for (i = 0; i < 60; i++)
-    {
-	int sum = 0;
-	for (k = 0; k < 8; k++)
-	    sum += ptr0[k] * ptr1[k];
-	sum = (sum + (out[i] << 12) + 0x800) >> 12;
-	out[i] = clip(sum, -0x7FFE, 0x7FFE);
-	for (k = 7; k > 0; k--)
-	    ptr0[k] = ptr0[k - 1];
-	ptr0[0] = out[i];
-    }
-
-    for (i = 0; i < 8; i++)
-	t[i] = (ts_5E2[i] * ptr1[i]) >> 15;
-
-    ptr0 = dec->tmp2;
-    for (i = 0; i < 60; i++)
-    {
-	int sum = 0;
-	for (k = 0; k < 8; k++)
-	    sum += ptr0[k] * t[k];
-	for (k = 7; k > 0; k--)
-	    ptr0[k] = ptr0[k - 1];
-	ptr0[0] = out[i];
-	out[i] = ((out[i] << 12) - sum) >> 12;
-    }
-
-    for (i = 0; i < 8; i++)
-	t[i] = (ts_5F2[i] * ptr1[i]) >> 15;
-
-    ptr0 = dec->tmp3;
-    for (i = 0; i < 60; i++)
-    {
-	int sum = out[i] << 12;
-	for (k = 0; k < 8; k++)
-	    sum += ptr0[k] * t[k];
-	for (k = 7; k > 0; k--)
-	    ptr0[k] = ptr0[k - 1];
-	ptr0[0] = clip((sum + 0x800) >> 12, -0x7FFE, 0x7FFE);
-
-	sum = ((ptr0[1] * (dec->filtval - (dec->filtval >> 2))) >> 4) + sum;
-	sum = sum - (sum >> 3);
-	out[i] = clip((sum + 0x800) >> 12, -0x7FFE, 0x7FFE);
-    }
-}
-
-static void truespeech_save_prevvec(TSContext *c)
-{
-    int i;
-
-    for (i = 0; i < 8; i++)
-	c->prevfilt[i] = c->cvector[i];
-}
-
-static int truespeech_decode_frame(AVCodecContext *avctx, void *data, int *data_size, uint8_t *buf, int buf_size)
-{
-    TSContext *c = avctx->priv_data;
-
-    int i;
-    short *samples = data;
-    int consumed = 0;
-    int16_t out_buf[240];
-
-    if (!buf_size)
-	return 0;
-
-    while (consumed < buf_size)
-    {
-	truespeech_read_frame(c, buf + consumed);
-	consumed += 32;
-
-	truespeech_correlate_filter(c);
-	truespeech_filters_merge(c);
-
-	memset(out_buf, 0, 240 * 2);
-	for (i = 0; i < 4; i++)
-	{
-	    truespeech_apply_twopoint_filter(c, i);
-	    truespeech_place_pulses(c, out_buf + i * 60, i);
-	    truespeech_update_filters(c, out_buf + i * 60, i);
-	    truespeech_synth(c, out_buf + i * 60, i);
-	}
-
-	truespeech_save_prevvec(c);
-
-	for (i = 0; i < 240; i++)      // finally output decoded frame
-	    *samples++ = out_buf[i];
-
-    }
-
-    *data_size = consumed * 15;
-
-    return buf_size;
-}
-
-AVCodec truespeech_decoder =
-{
-	"truespeech",
-	CODEC_TYPE_AUDIO,
-	CODEC_ID_TRUESPEECH,
-	sizeof(TSContext),
-	truespeech_decode_init,
-	NULL,
-	NULL,
-	truespeech_decode_frame,
-};
+#include "avcodec.h"
+#include "dsputil.h"
+
+#include "truespeech_data.h"
+
+// TrueSpeech decoder context
+// 此文件实现true speed 音频解码器
+typedef struct TSContext
+{
+    // input data
+    int16_t vector[8];   // input vector: 5/5/4/4/4/3/3/3
+    int offset1[2];      // 8-bit value, used in one copying offset
+    int offset2[4];      // 7-bit value, encodes offsets for copying and for two-point filter
+    int pulseoff[4];     // 4-bit offset of pulse values block
+    int pulsepos[4];     // 27-bit variable, encodes 7 pulse positions
+    int pulseval[4];     // 7x2-bit pulse values
+    int flag;            // 1-bit flag, shows how to choose filters
+    // temporary data
+    int16_t filtbuf[146 + 60];	// 前146 项是激励历史，后60 项是两点滤波的输出，滤波时延迟短于60 的要读到本次的输出
+    int prevfilt[8];     // filter from previous frame
+    int16_t tmp1[8];     // 三级合成滤波器各自最近的8 个值，第0 项最新
+    int16_t tmp2[8];
+    int16_t tmp3[8];
+    int16_t cvector[8];  // correlated input vector
+    int filtval;         // gain value for one function
+    int16_t newvec[60];  // tmp vector
+    int16_t filters[32]; // filters for every subframe
+    // 送包/取帧接口
+    AVPacket pkt;        // 送入还没解完的数据包
+    int pkt_offset;      // pkt 中已解码的字节数
+    int16_t frame_buf[240];	// 取帧输出的一帧
+} TSContext;
+
+#if !defined(LE_32)
+#define LE_32(x)  ((((uint8_t*)(x))[3] << 24)| (((uint8_t*)(x))[2] << 16) | \
+                   (((uint8_t*)(x))[1] << 8) | ((uint8_t*)(x))[0])
+#endif
+
+static int truespeech_decode_init(AVCodecContext *avctx)
+{
+    return 0; //  TSContext *c = avctx->priv_data;
+}
+
+static void truespeech_read_frame(TSContext *dec, uint8_t *input)
+{
+    uint32_t t;
+
+    t = LE_32(input); // first dword
+    input += 4;
+
+    dec->flag = t & 1;
+
+    dec->vector[0] = ts_codebook[0][(t >> 1) & 0x1F];
+    dec->vector[1] = ts_codebook[1][(t >> 6) & 0x1F];
+    dec->vector[2] = ts_codebook[2][(t >> 11) & 0xF];
+    dec->vector[3] = ts_codebook[3][(t >> 15) & 0xF];
+    dec->vector[4] = ts_codebook[4][(t >> 19) & 0xF];
+    dec->vector[5] = ts_codebook[5][(t >> 23) & 0x7];
+    dec->vector[6] = ts_codebook[6][(t >> 26) & 0x7];
+    dec->vector[7] = ts_codebook[7][(t >> 29) & 0x7];
+
+
+    t = LE_32(input); // second dword
+    input += 4;
+
+    dec->offset2[0] = (t >> 0) & 0x7F;
+    dec->offset2[1] = (t >> 7) & 0x7F;
+    dec->offset2[2] = (t >> 14) & 0x7F;
+    dec->offset2[3] = (t >> 21) & 0x7F;
+
+    dec->offset1[0] = ((t >> 28) & 0xF) << 4;
+
+
+    t = LE_32(input); // third dword
+    input += 4;
+
+    dec->pulseval[0] = (t >> 0) & 0x3FFF;
+    dec->pulseval[1] = (t >> 14) & 0x3FFF;
+
+    dec->offset1[1] = (t >> 28) & 0x0F;
+
+
+    t = LE_32(input); // fourth dword
+    input += 4;
+
+    dec->pulseval[2] = (t >> 0) & 0x3FFF;
+    dec->pulseval[3] = (t >> 14) & 0x3FFF;
+
+    dec->offset1[1] |= ((t >> 28) & 0x0F) << 4;
+
+
+    t = LE_32(input); // fifth dword
+    input += 4;
+
+    dec->pulsepos[0] = (t >> 4) & 0x7FFFFFF;
+
+    dec->pulseoff[0] = (t >> 0) & 0xF;
+
+    dec->offset1[0] |= (t >> 31) & 1;
+
+
+    t = LE_32(input); // sixth dword
+    input += 4;
+
+    dec->pulsepos[1] = (t >> 4) & 0x7FFFFFF;
+
+    dec->pulseoff[1] = (t >> 0) & 0xF;
+
+    dec->offset1[0] |= ((t >> 31) & 1) << 1;
+
+
+    t = LE_32(input); // seventh dword
+    input += 4;
+
+    dec->pulsepos[2] = (t >> 4) & 0x7FFFFFF;
+
+    dec->pulseoff[2] = (t >> 0) & 0xF;
+
+    dec->offset1[0] |= ((t >> 31) & 1) << 2;
+
+
+    t = LE_32(input); // eighth dword
+    input += 4;
+
+    dec->pulsepos[3] = (t >> 4) & 0x7FFFFFF;
+
+    dec->pulseoff[3] = (t >> 0) & 0xF;
+
+    dec->offset1[0] |= ((t >> 31) & 1) << 3;
+}
+
+static void truespeech_correlate_filter(TSContext *dec)
+{
+    int16_t tmp[8];
+    int i, j;
+
+    for (i = 0; i < 8; i++)
+    {
+	if (i > 0)
+	{
+	    memcpy(tmp, dec->cvector, i * 2);
+	    for (j = 0; j < i; j++)
+		dec->cvector[j] = ((tmp[i - j - 1] * dec->vector[i]) + (dec->cvector[j] << 15) + 0x4000) >> 15;
+	}
+	dec->cvector[i] = (8 - dec->vector[i]) >> 3;
+    }
+
+    for (i = 0; i < 8; i++)
+	dec->cvector[i] = (dec->cvector[i] * ts_230[i]) >> 15;
+
+    dec->filtval = dec->vector[0];
+}
+
+static void truespeech_filters_merge(TSContext *dec)
+{
+    int i;
+
+    if (!dec->flag)
+    {
+	for (i = 0; i < 8; i++)
+	{
+	    dec->filters[i + 0] = dec->prevfilt[i];
+	    dec->filters[i + 8] = dec->prevfilt[i];
+	}
+    }
+    else
+    {
+	for (i = 0; i < 8; i++)
+	{
+	    dec->filters[i + 0] = (dec->cvector[i] * 21846 + dec->prevfilt[i] * 10923 + 16384) >> 15;
+	    dec->filters[i + 8] = (dec->cvector[i] * 10923 + dec->prevfilt[i] * 21846 + 16384) >> 15;
+	}
+    }
+    for (i = 0; i < 8; i++)
+    {
+	dec->filters[i + 16] = dec->cvector[i];
+	dec->filters[i + 24] = dec->cvector[i];
+    }
+}
+
+// 激励历史直接存成int16，原来每次滤波前转换成int16 的临时复制省掉了，截断的结果不变。
+static void truespeech_apply_twopoint_filter(TSContext *dec, int quart)
+{
+    int16_t *ptr0, *ptr1, *filter;
+    int i, t, off;
+
+    t = dec->offset2[quart];
+    if (t == 127)
+    {
+	memset(dec->newvec, 0, 60 * 2);
+	return;
+    }
+
+    // 损坏的码流偏移可能超过历史的长度，原来会读到历史之前的内存，这里限制在历史范围内。
+    off = (t / 25) + dec->offset1[quart >> 1] + 18;
+    if (off > 145)
+	off = 145;
+    ptr0 = dec->filtbuf + 145 - off;
+    ptr1 = dec->filtbuf + 146;
+    filter = (int16_t*)ts_240 + (t % 25) * 2;
+    for (i = 0; i < 60; i++)
+    {
+	t = (ptr0[0] * filter[0] + ptr0[1] * filter[1] + 0x2000) >> 14;
+	ptr0++;
+	dec->newvec[i] = t;
+	ptr1[i] = t;
+    }
+}
+
+static void truespeech_place_pulses(TSContext *dec, int16_t *out, int quart)
+{
+    int16_t tmp[7];
+    int i, j, t;
+    int16_t *ptr1, *ptr2;
+    int coef;
+
+    memset(out, 0, 60 * 2);
+    for (i = 0; i < 7; i++)
+    {
+	t = dec->pulseval[quart] & 3;
+	dec->pulseval[quart] >>= 2;
+	tmp[6 - i] = ts_562[dec->pulseoff[quart] * 4 + t];
+    }
+
+    coef = dec->pulsepos[quart] >> 15;
+    ptr1 = (int16_t*)ts_140 + 30;
+    ptr2 = tmp;
+    for (i = 0, j = 3; (i < 30) && (j > 0); i++)
+    {
+	t = *ptr1++;
+	if (coef >= t)
+	    coef -= t;
+	else
+	{
+	    out[i] = *ptr2++;
+	    ptr1 += 30;
+	    j--;
+	}
+    }
+    coef = dec->pulsepos[quart] & 0x7FFF;
+    ptr1 = (int16_t*)ts_140;
+    for (i = 30, j = 4; (i < 60) && (j > 0); i++)
+    {
+	t = *ptr1++;
+	if (coef >= t)
+	    coef -= t;
+	else
+	{
+	    out[i] = *ptr2++;
+	    ptr1 += 30;
+	    j--;
+	}
+    }
+}
+
+static void truespeech_update_filters(TSContext *dec, int16_t *out, int quart)
+{
+    int i;
+
+    memmove(dec->filtbuf, dec->filtbuf + 60, 86 * 2);
+
+    for (i = 0; i < 60; i++)
+    {
+	dec->filtbuf[i + 86] = out[i] + dec->newvec[i] - (dec->newvec[i] >> 3);
+	out[i] += dec->newvec[i];
+    }
+}
+
+// 三级合成滤波器调用DSPContext 中的8 阶定点滤波，由dsputil_init 按CPU 指令集选择实现。
+static void truespeech_synth(TSContext *dec, int16_t *out, int quart)
+{
+    int i;
+    int16_t t[8];		// 系数都是正数，乘积右移15 位后在int16 范围内
+    int16_t *ptr1 = dec->filters + quart * 8;
+
+    ff_dsp.synth_filter8(out, ptr1, dec->tmp1, 60);
+
+    for (i = 0; i < 8; i++)
+	t[i] = (ts_5E2[i] * ptr1[i]) >> 15;
+    ff_dsp.inverse_filter8(out, t, dec->tmp2, 60);
+
+    for (i = 0; i < 8; i++)
+	t[i] = (ts_5F2[i] * ptr1[i]) >> 15;
+    ff_dsp.post_filter8(out, t, dec->tmp3, 60, dec->filtval - (dec->filtval >> 2));
+}
+
+static void truespeech_save_prevvec(TSContext *c)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+	c->prevfilt[i] = c->cvector[i];
+}
+
+// 解码一帧32 字节，输出240 个采样。
+static void truespeech_decode_one(TSContext *c, uint8_t *buf, int16_t *samples)
+{
+    int i;
+
+    truespeech_read_frame(c, buf);
+
+    truespeech_correlate_filter(c);
+    truespeech_filters_merge(c);
+
+    memset(samples, 0, 240 * 2);
+    for (i = 0; i < 4; i++)
+    {
+	truespeech_apply_twopoint_filter(c, i);
+	truespeech_place_pulses(c, samples + i * 60, i);
+	truespeech_update_filters(c, samples + i * 60, i);
+	truespeech_synth(c, samples + i * 60, i);
+    }
+
+    truespeech_save_prevvec(c);
+}
+
+static int truespeech_decode_frame(AVCodecContext *avctx, void *data, int *data_size, uint8_t *buf, int buf_size)
+{
+    TSContext *c = avctx->priv_data;
+
+    short *samples = data;
+    int consumed = 0;
+
+    if (!buf_size)
+	return 0;
+
+    // 每32 字节解出240 个采样，一次最多解满AVCODEC_MAX_AUDIO_FRAME_SIZE 的输出，剩下的数据由调用者下次再送进来。
+    while (consumed < buf_size && (consumed + 32) * 15 <= AVCODEC_MAX_AUDIO_FRAME_SIZE)
+    {
+	truespeech_decode_one(c, buf + consumed, samples);
+	consumed += 32;
+	samples += 240;
+    }
+
+    *data_size = consumed * 15;
+
+    return consumed < buf_size ? consumed : buf_size;
+}
+
+static void truespeech_drop_packet(TSContext *c)
+{
+    if (c->pkt.destruct)
+	c->pkt.destruct(&c->pkt);
+    memset(&c->pkt, 0, sizeof(c->pkt));
+    c->pkt_offset = 0;
+}
+
+// 送包/取帧接口直接按32 字节一帧取出240 个采样，不用像decode 那样受输出缓存大小限制、返回消耗的字节数。
+static int truespeech_send_packet(AVCodecContext *avctx, AVPacket *pkt)
+{
+    TSContext *c = avctx->priv_data;
+
+    if (c->pkt_offset < c->pkt.size)
+	return AVERROR_AGAIN;
+    truespeech_drop_packet(c);
+    c->pkt = *pkt;
+    return 0;
+}
+
+static int truespeech_receive_frame(AVCodecContext *avctx, AVFrame *frame)
+{
+    TSContext *c = avctx->priv_data;
+
+    if (c->pkt_offset >= c->pkt.size)
+	return AVERROR_AGAIN;
+
+    truespeech_decode_one(c, c->pkt.data + c->pkt_offset, c->frame_buf);
+    c->pkt_offset += 32;
+    // 数据包解完就释放，不用等下一个包送进来。
+    if (c->pkt_offset >= c->pkt.size)
+	truespeech_drop_packet(c);
+
+    frame->data[0] = (uint8_t*)c->frame_buf;
+    frame->linesize[0] = 240 * 2;
+    frame->nb_samples = 240 / (avctx->channels > 0 ? avctx->channels : 1);
+    return 0;
+}
+
+static int truespeech_decode_close(AVCodecContext *avctx)
+{
+    truespeech_drop_packet(avctx->priv_data);
+    return 0;
+}
+
+// 多个流同时解码。激励部分(读帧、相关滤波、两点滤波、放置脉冲)按流逐个计算，占大部分运算的合成滤波
+// 把最多8 个流交错放在一起，通过ff_dsp 的8 通道滤波函数一起算：数组的每8 项是8 个流的同一个值。
+// 一个流的合成滤波是递推的，单独算时每个采样都要等上一个采样；8 个流一起算时一条依赖链完成8 个流的采样。
+#define TS_LANES	8
+
+// 和truespeech_synth 相同的三级滤波，一次处理n 个流一整帧的4 个子帧。x 是240 个采样，每个采样8 个通道。
+static void truespeech_synth_lanes(TSContext **dec, int n, int16_t *x)
+{
+    int16_t h1[(8 + 60) * TS_LANES], h2[(8 + 60) * TS_LANES], h3[(8 + 60) * TS_LANES];
+    int16_t c1[8 * TS_LANES], c2[8 * TS_LANES], c3[8 * TS_LANES], gain[TS_LANES];
+    int16_t *ptr1, *px;
+    int k, l, q;
+
+    // 历史窗口从旧到新排列，第7 项是最新的值，新值接在后面，每个子帧结束后把最后8 项移回开头。
+    memset(h1, 0, sizeof(h1));
+    memset(h2, 0, sizeof(h2));
+    memset(h3, 0, sizeof(h3));
+    memset(c1, 0, sizeof(c1));
+    memset(gain, 0, sizeof(gain));
+    for (l = 0; l < n; l++)
+    {
+	for (k = 0; k < 8; k++)
+	{
+	    h1[(7 - k) * TS_LANES + l] = dec[l]->tmp1[k];
+	    h2[(7 - k) * TS_LANES + l] = dec[l]->tmp2[k];
+	    h3[(7 - k) * TS_LANES + l] = dec[l]->tmp3[k];
+	}
+	gain[l] = dec[l]->filtval - (dec[l]->filtval >> 2);
+    }
+
+    for (q = 0; q < 4; q++)
+    {
+	for (l = 0; l < n; l++)
+	{
+	    ptr1 = dec[l]->filters + q * 8;
+	    for (k = 0; k < 8; k++)
+		c1[k * TS_LANES + l] = ptr1[k];
+	}
+	for (k = 0; k < 8 * TS_LANES; k++)
+	{
+	    c2[k] = (ts_5E2[k / TS_LANES] * c1[k]) >> 15;
+	    c3[k] = (ts_5F2[k / TS_LANES] * c1[k]) >> 15;
+	}
+
+	px = x + q * 60 * TS_LANES;
+	ff_dsp.synth_filter8_x8(px, c1, h1, 60);
+	ff_dsp.inverse_filter8_x8(px, c2, h2, 60);
+	ff_dsp.post_filter8_x8(px, c3, h3, 60, gain);
+
+	memcpy(h1, h1 + 60 * TS_LANES, 8 * TS_LANES * 2);
+	memcpy(h2, h2 + 60 * TS_LANES, 8 * TS_LANES * 2);
+	memcpy(h3, h3 + 60 * TS_LANES, 8 * TS_LANES * 2);
+    }
+
+    for (l = 0; l < n; l++)
+    {
+	for (k = 0; k < 8; k++)
+	{
+	    dec[l]->tmp1[k] = h1[(7 - k) * TS_LANES + l];
+	    dec[l]->tmp2[k] = h2[(7 - k) * TS_LANES + l];
+	    dec[l]->tmp3[k] = h3[(7 - k) * TS_LANES + l];
+	}
+    }
+}
+
+// 每个流正好一帧32 字节、并且ff_dsp 有8 通道滤波的加速实现时8 个一组一起解码，其他情况逐个调用truespeech_decode_frame。
+static int truespeech_decode_batch(AVCodecContext **avctx, int count, int16_t **samples, int *frame_size_ptr,
+    int *consumed, uint8_t **buf, int buf_size)
+{
+    TSContext *dec[TS_LANES];
+    int16_t x[240 * TS_LANES], out_buf[240];
+    int g, n, i, l, q, ret;
+
+    if (buf_size != 32 || !ff_dsp.synth_filter8_x8)
+    {
+	for (i = 0; i < count; i++)
+	{
+	    ret = truespeech_decode_frame(avctx[i], samples[i], &frame_size_ptr[i], buf[i], buf_size);
+	    if (ret < 0)
+		return ret;
+	    consumed[i] = ret;
+	}
+	return 0;
+    }
+
+    for (g = 0; g < count; g += TS_LANES)
+    {
+	n = count - g < TS_LANES ? count - g : TS_LANES;
+	memset(x, 0, sizeof(x));
+	for (l = 0; l < n; l++)
+	{
+	    dec[l] = avctx[g + l]->priv_data;
+
+	    truespeech_read_frame(dec[l], buf[g + l]);
+	    truespeech_correlate_filter(dec[l]);
+	    truespeech_filters_merge(dec[l]);
+
+	    // 合成滤波不影响激励，4 个子帧的激励可以先算完。
+	    memset(out_buf, 0, 240 * 2);
+	    for (q = 0; q < 4; q++)
+	    {
+		truespeech_apply_twopoint_filter(dec[l], q);
+		truespeech_place_pulses(dec[l], out_buf + q * 60, q);
+		truespeech_update_filters(dec[l], out_buf + q * 60, q);
+	    }
+	    truespeech_save_prevvec(dec[l]);
+
+	    for (i = 0; i < 240; i++)
+		x[i * TS_LANES + l] = out_buf[i];
+	}
+
+	truespeech_synth_lanes(dec, n, x);
+
+	for (l = 0; l < n; l++)
+	{
+	    for (i = 0; i < 240; i++)
+		samples[g + l][i] = x[i * TS_LANES + l];
+	    frame_size_ptr[g + l] = 240 * 2;
+	    consumed[g + l] = 32;
+	}
+    }
+
+    return 0;
+}
+
+AVCodec truespeech_decoder =
+{
+	"truespeech",
+	CODEC_TYPE_AUDIO,
+	CODEC_ID_TRUESPEECH,
+	sizeof(TSContext),
+	truespeech_decode_init,
+	NULL,
+	truespeech_decode_close,
+	truespeech_decode_frame,
+	truespeech_decode_batch,
+	truespeech_send_packet,
+	truespeech_receive_frame,
+};
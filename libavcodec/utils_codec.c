@@ -1,422 +1,1182 @@
-#include <assert.h>
-#include "avcodec.h"
-#include "dsputil.h"
-
-// ʹõİ͹ߺ
-#define EDGE_WIDTH   16
-#define STRIDE_ALIGN 16
-
-#define INT_MAX 2147483647
-
-#define FFMAX(a,b) ((a) > (b) ? (a) : (b))
-
-// ڴ涯̬亯һ¼򵥲Уϵͳ
-void *av_malloc(unsigned int size)
-{
-    void *ptr;
-
-    if (size > INT_MAX)
-	return NULL;
-    ptr = malloc(size);
-
-    return ptr;
-}
-// ڴ涯̬ط亯һ¼򵥲Уϵͳ
-void *av_realloc(void *ptr, unsigned int size)
-{
-    if (size > INT_MAX)
-	return NULL;
-
-    return realloc(ptr, size);
-}
-// ڴ涯̬ͷźһ¼򵥲Уϵͳ
-void av_free(void *ptr)
-{
-    if (ptr)
-	free(ptr);
-}
-// ڴ涯̬亯av_malloc()ٰѷڴ0
-void *av_mallocz(unsigned int size)
-{
-    void *ptr;
-
-    ptr = av_malloc(size);
-    if (!ptr)
-	return NULL;
-
-    memset(ptr, 0, size);
-    return ptr;
-}
-// ڴ涯̬亯ԤһЩڴεϵͳﵽٵĿ
-void *av_fast_realloc(void *ptr, unsigned int *size, unsigned int min_size)
-{
-    if (min_size < *size)
-	return ptr;
-
-    *size = FFMAX(17 * min_size / 16 + 32, min_size);
-
-    return av_realloc(ptr, *size);
-}
-// ̬ڴͷźע⴫ı͡
-void av_freep(void *arg)
-{
-    void **ptr = (void **)arg;
-    av_free(*ptr);
-    *ptr = NULL;
-}
-
-AVCodec *first_avcodec = NULL;
-
-// ѱһڲҡ
-void register_avcodec(AVCodec *format)
-{
-    AVCodec **p;
-    p = &first_avcodec;
-    while (*p != NULL)
-	p = &(*p)->next;
-    *p = format;
-    format->next = NULL;
-}
-// ڲʹõĻΪƵͼRGB YUV ʽÿĸ
-typedef struct InternalBuffer
-{
-    uint8_t *base[4];
-    uint8_t *data[4];
-    int  linesize[4];
-} InternalBuffer;
-
-#define INTERNAL_BUFFER_SIZE 32
-
-#define ALIGN(x, a) (((x)+(a)-1)&~((a)-1))
-// ͼʽҪͼ񳤿ֽڶ1 2 4 8 16 ֽڶ롣
-void avcodec_align_dimensions(AVCodecContext *s, int *width, int *height)
-{
-    // Ĭϳ1 ֽڶ롣
-    int w_align = 1;
-    int h_align = 1;
-
-    switch (s->pix_fmt)
-    {
-    case PIX_FMT_YUV420P:
-    case PIX_FMT_YUV422:
-    case PIX_FMT_UYVY422:
-    case PIX_FMT_YUV422P:
-    case PIX_FMT_YUV444P:
-    case PIX_FMT_GRAY8:
-    case PIX_FMT_YUVJ420P:
-    case PIX_FMT_YUVJ422P:
-    case PIX_FMT_YUVJ444P: //FIXME check for non mpeg style codecs and use less alignment
-	w_align = 16;
-	h_align = 16;
-	break;
-    case PIX_FMT_YUV411P:
-    case PIX_FMT_UYVY411:
-	w_align = 32;
-	h_align = 8;
-	break;
-    case PIX_FMT_YUV410P:
-    case PIX_FMT_RGB555:
-    case PIX_FMT_PAL8:
-	break;
-    case PIX_FMT_BGR24:
-	break;
-    default:
-	w_align = 1;
-	h_align = 1;
-	break;
-    }
-
-    *width = ALIGN(*width, w_align);
-    *height = ALIGN(*height, h_align);
-}
-// УƵͼĳǷϷ
-int avcodec_check_dimensions(void *av_log_ctx, unsigned int w, unsigned int h)
-{
-    if ((int)w > 0 && (int)h > 0 && (w + 128)*(uint64_t)(h + 128) < INT_MAX / 4)
-	return 0;
-
-    return  -1;
-}
-// ÿȡinternal_buffer_count base[0]жǷѷڴ棬data[0]жǷѱռábase[]data[]ж塣
-// avcodec_alloc_context Ѱinternal_buffer 0Կbase[0]жϡ
-int avcodec_default_get_buffer(AVCodecContext *s, AVFrame *pic)
-{
-    int i;
-    int w = s->width;
-    int h = s->height;
-    int align_off;
-    InternalBuffer *buf;
-
-    assert(pic->data[0] == NULL);
-    assert(INTERNAL_BUFFER_SIZE > s->internal_buffer_count);
-    // УƵͼĳǷϷ
-    if (avcodec_check_dimensions(s, w, h))
-	return  -1;
-    // ûзڴ棬ͷ䶯̬ڴ沢0
-    if (s->internal_buffer == NULL)
-	s->internal_buffer = av_mallocz(INTERNAL_BUFFER_SIZE * sizeof(InternalBuffer));
-    // ȡеĵһûռڴ档
-    buf = &((InternalBuffer*)s->internal_buffer)[s->internal_buffer_count];
-
-    if (buf->base[0])
-    {
-	// ڴѷ
-    }
-    else
-    {
-	// ûзڴͰͼʽҪڴ棬һЩǺͼһЩֵ
-	int h_chroma_shift, v_chroma_shift;
-	int pixel_size, size[3];
-
-
-	AVPicture picture;
-	// CbCr ɫȷY ȷıȣλʵ֡
-	avcodec_get_chroma_sub_sample(s->pix_fmt, &h_chroma_shift, &v_chroma_shift);
-	// ضͼظʽҪ
-	avcodec_align_dimensions(s, &w, &h);
-
-	// ѳŴһЩmpeg4 Ƶб㷨е˶Ҫԭʼͼչ㲻˶ʸҪ(˶ʸԳԭʼͼ߽)
-	w += EDGE_WIDTH * 2;
-	h += EDGE_WIDTH * 2;
-	// ضʽͼĴСг(linesize/stride)ȵȡ
-	avpicture_fill(&picture, NULL, s->pix_fmt, w, h);
-	pixel_size = picture.linesize[0] * 8 / w;
-	assert(pixel_size >= 1);
-
-	if (pixel_size == 3 * 8)
-	    w = ALIGN(w, STRIDE_ALIGN << h_chroma_shift);
-	else
-	    w = ALIGN(pixel_size *w, STRIDE_ALIGN << (h_chroma_shift + 3)) / pixel_size;
-
-	size[1] = avpicture_fill(&picture, NULL, s->pix_fmt, w, h);
-	size[0] = picture.linesize[0] * h;
-	size[1] -= size[0];
-	if (picture.data[2])
-	    size[1] = size[2] = size[1] / 2;
-	else
-	    size[2] = 0;
-
-	// עbase[]data[]黹Ϊǵ;free()ʱķNULL жϣҪ0
-	memset(buf->base, 0, sizeof(buf->base));
-	memset(buf->data, 0, sizeof(buf->data));
-
-	for (i = 0; i < 3 && size[i]; i++)
-	{
-	    const int h_shift = i == 0 ? 0 : h_chroma_shift;
-	    const int v_shift = i == 0 ? 0 : v_chroma_shift;
-
-	    buf->linesize[i] = picture.linesize[i];
-	    // ʵԷڴ棬202 аڴ0
-	    buf->base[i] = av_malloc(size[i] + 16); //FIXME 16
-	    if (buf->base[i] == NULL)
-		return  -1;
-	    memset(buf->base[i], 128, size[i]);
-	    // ڴ㡣
-	    align_off = ALIGN((buf->linesize[i] * EDGE_WIDTH >> v_shift) + (EDGE_WIDTH >> h_shift), STRIDE_ALIGN);
-
-	    if ((s->pix_fmt == PIX_FMT_PAL8) || !size[2])
-		buf->data[i] = buf->base[i];
-	    else
-		buf->data[i] = buf->base[i] + align_off;
-	}
-    }
-
-    for (i = 0; i < 4; i++)
-    {
-	// ѷڴֵpic ָĽṹУݳȥ
-	pic->base[i] = buf->base[i];
-	pic->data[i] = buf->data[i];
-	pic->linesize[i] = buf->linesize[i];
-    }
-    // ڴ+1עͷʱĲ֤Ӧڴǿеġ
-    s->internal_buffer_count++;
-
-    return 0;
-}
-
-// ͷռõڴ֤0 internal_buffer_count-1 ΪЧݣǿ
-void avcodec_default_release_buffer(AVCodecContext *s, AVFrame *pic)
-{
-    int i;
-    InternalBuffer *buf, *last, temp;
-    // 򵥵ĲУ飬ڴѾ
-    assert(s->internal_buffer_count);
-
-    buf = NULL;
-    for (i = 0; i < s->internal_buffer_count; i++)
-    {
-	// ڴ飬ҶӦpic ڴdata[0]ڴַΪȽбǡ
-	buf = &((InternalBuffer*)s->internal_buffer)[i]; //just 3-5 checks so is not worth to optimize
-	if (buf->data[0] == pic->data[0])
-	    break;
-    }
-    assert(i < s->internal_buffer_count);
-    // ڴ-1, ɾһ.
-    s->internal_buffer_count--;
-    last = &((InternalBuffer*)s->internal_buffer)[s->internal_buffer_count];
-
-    // ѽҪеһ֤internal_buffer_count ȷ
-    // עﲢûڴͷŵĶ´θѷڴ
-    temp = *buf;
-    *buf = *last;
-    *last = temp;
-
-    for (i = 0; i < 3; i++)
-    {
-	pic->data[i] = NULL;
-    }
-}
-
-int avcodec_default_reget_buffer(AVCodecContext *s, AVFrame *pic)
-{
-    if (pic->data[0] == NULL)  // If no picture return a new buffer
-    {
-	return s->get_buffer(s, pic);
-    }
-
-    return 0;
-}
-
-void avcodec_default_free_buffers(AVCodecContext *s)
-{
-    int i, j;
-
-    if (s->internal_buffer == NULL)
-	return;
-
-    for (i = 0; i < INTERNAL_BUFFER_SIZE; i++)
-    {
-	InternalBuffer *buf = &((InternalBuffer*)s->internal_buffer)[i];
-	for (j = 0; j < 4; j++)
-	{
-	    av_freep(&buf->base[j]);
-	    buf->data[j] = NULL;
-	}
-    }
-    av_freep(&s->internal_buffer);
-
-    s->internal_buffer_count = 0;
-}
-
-AVCodecContext *avcodec_alloc_context(void)
-{
-    AVCodecContext *s = av_malloc(sizeof(AVCodecContext));
-
-    if (s == NULL)
-	return NULL;
-
-    memset(s, 0, sizeof(AVCodecContext));
-
-    s->get_buffer = avcodec_default_get_buffer;
-    s->release_buffer = avcodec_default_release_buffer;
-
-    s->pix_fmt = PIX_FMT_NONE;
-
-    s->palctrl = NULL;
-    s->reget_buffer = avcodec_default_reget_buffer;
-
-    return s;
-}
-
-int avcodec_open(AVCodecContext *avctx, AVCodec *codec)
-{
-    int ret = -1;
-
-    if (avctx->codec)
-	goto end;
-
-    if (codec->priv_data_size > 0)
-    {
-	avctx->priv_data = av_mallocz(codec->priv_data_size);
-	if (!avctx->priv_data)
-	    goto end;
-    }
-    else
-    {
-	avctx->priv_data = NULL;
-    }
-
-    avctx->codec = codec;
-    avctx->codec_id = codec->id;
-    avctx->frame_number = 0;
-    ret = avctx->codec->init(avctx);
-    if (ret < 0)
-    {
-	av_freep(&avctx->priv_data);
-	avctx->codec = NULL;
-	goto end;
-    }
-    ret = 0;
-end:
-    return ret;
-}
-
-int avcodec_decode_video(AVCodecContext *avctx, AVFrame *picture, int *got_picture_ptr,
-    uint8_t *buf, int buf_size)
-{
-    int ret;
-
-    *got_picture_ptr = 0;
-
-    if (buf_size)
-    {
-	ret = avctx->codec->decode(avctx, picture, got_picture_ptr, buf, buf_size);
-
-	if (*got_picture_ptr)
-	    avctx->frame_number++;
-    }
-    else
-	ret = 0;
-
-    return ret;
-}
-
-int avcodec_decode_audio(AVCodecContext *avctx, int16_t *samples, int *frame_size_ptr,
-    uint8_t *buf, int buf_size)
-{
-    int ret;
-
-    *frame_size_ptr = 0;
-    if (buf_size)
-    {
-	ret = avctx->codec->decode(avctx, samples, frame_size_ptr, buf, buf_size);
-	avctx->frame_number++;
-    }
-    else
-	ret = 0;
-    return ret;
-}
-
-int avcodec_close(AVCodecContext *avctx)
-{
-    if (avctx->codec->close)
-	avctx->codec->close(avctx);
-    avcodec_default_free_buffers(avctx);
-    av_freep(&avctx->priv_data);
-    avctx->codec = NULL;
-    return 0;
-}
-
-AVCodec *avcodec_find_decoder(enum CodecID id)
-{
-    AVCodec *p;
-    p = first_avcodec;
-    while (p)
-    {
-	if (p->decode != NULL && p->id == id)
-	    return p;
-	p = p->next;
-    }
-    return NULL;
-}
-
-void avcodec_init(void)
-{
-    static int inited = 0;
-
-    if (inited != 0)
-	return;
-    inited = 1;
-
-    dsputil_static_init();
-}
+#include <assert.h>
+#include "avcodec.h"
+#include "dsputil.h"
+#include "../libavutil/avthread.h"
+
+#ifndef CONFIG_WIN32
+#include <sys/mman.h>
+#endif
+
+// 编解码库使用的帮助和工具函数
+#define EDGE_WIDTH   16
+#define STRIDE_ALIGN 32	// 分量基地址按MALLOC_ALIGN 对齐，每行再按STRIDE_ALIGN 对齐，满足AVX2 对齐读写
+
+#define INT_MAX 2147483647
+
+#define FFMAX(a,b) ((a) > (b) ? (a) : (b))
+#define FFMIN(a,b) ((a) > (b) ? (b) : (a))
+
+// av_malloc 返回的地址按MALLOC_ALIGN 字节对齐，满足SSE/AVX 对齐读写和缓存行对齐。
+// 对齐地址前面紧挨着放一个MemHeader，记录系统分配的原始地址、大小、分配方式和计入的流统计，
+// 所以av_malloc 分配的内存必须用av_free 释放，不能和系统的malloc/free 混用。
+#define MALLOC_ALIGN	64
+#define MEM_OVERHEAD	(sizeof(MemHeader) + MALLOC_ALIGN - 1)
+
+// 达到此大小的分配才用整页映射，优先用大页，减少大块帧缓存的TLB 缺失。
+#define LARGE_ALLOC_MIN	(2 * 1024 * 1024)
+#define PAGE_SIZE_4K	4096
+
+#define ALIGN_PTR(p, a)	((uint8_t*)(((size_t)(p) + (a) - 1) & ~(size_t)((a) - 1)))
+
+enum
+{
+    MEM_HEAP,		// malloc 分配
+    MEM_MAPPED,		// 普通页映射
+    MEM_HUGE		// 大页映射
+};
+
+typedef struct MemHeader
+{
+    uint8_t *raw;		// 系统分配的原始地址
+    unsigned int size;		// 用户请求的大小
+    unsigned int map_size;	// 整页映射的大小
+    int kind;			// MEM_HEAP/MEM_MAPPED/MEM_HUGE
+    AVMemStats *stats;		// 计入的流统计，NULL 表示只计入全局统计
+} MemHeader;
+
+#define MEM_HEADER(ptr)	((MemHeader*)(ptr) - 1)
+
+static AVMemStats mem_stats_global = { 0, 0, 0, 0, 0, 1 };
+static AV_THREAD_LOCAL AVMemStats *mem_stats_current;	// 本线程当前的分配计入哪个流
+
+static void mem_stats_add(AVMemStats *s, int64_t size, int64_t large, int allocs, int frees)
+{
+    int64_t cur, peak, old;
+
+    cur = av_atomic_add64(&s->cur_bytes, size);
+    if (large)
+	av_atomic_add64(&s->large_bytes, large);
+    if (allocs)
+	av_atomic_add64(&s->nb_allocs, allocs);
+    if (frees)
+	av_atomic_add64(&s->nb_frees, frees);
+
+    peak = av_atomic_add64(&s->peak_bytes, 0);	// 原子读取，其他线程可能同时在更新峰值
+    while (cur > peak)
+    {
+	old = av_atomic_cas64(&s->peak_bytes, peak, cur);
+	if (old == peak)
+	    break;
+	peak = old;
+    }
+}
+
+// 新分配的内存计入全局统计和本线程当前的流统计，流统计被未释放的分配引用着，不会提前释放。
+static void mem_charge(MemHeader *h)
+{
+    int64_t large = h->kind == MEM_HEAP ? 0 : h->map_size;
+
+    h->stats = mem_stats_current;
+    mem_stats_add(&mem_stats_global, h->size, large, 1, 0);
+    if (h->stats)
+    {
+	av_atomic_add64(&h->stats->refs, 1);
+	mem_stats_add(h->stats, h->size, large, 1, 0);
+    }
+}
+
+static void mem_uncharge(MemHeader *h)
+{
+    int64_t large = h->kind == MEM_HEAP ? 0 : h->map_size;
+
+    mem_stats_add(&mem_stats_global, -(int64_t)h->size, -large, 0, 1);
+    if (h->stats)
+    {
+	mem_stats_add(h->stats, -(int64_t)h->size, -large, 0, 1);
+	av_mem_stats_release(h->stats);
+    }
+}
+
+// 把一块av_malloc 分配的内存改计入另一个流统计，NULL 表示只计入全局统计，全局统计不变。
+// 缓存池复用内存时用：放回池中时不再计入原来的流，重新分配出去时计入新的所有者。
+void av_mem_charge_to(void *ptr, AVMemStats *stats)
+{
+    MemHeader *h = MEM_HEADER(ptr);
+    int64_t large = h->kind == MEM_HEAP ? 0 : h->map_size;
+
+    if (h->stats == stats)
+	return;
+    if (h->stats)
+    {
+	mem_stats_add(h->stats, -(int64_t)h->size, -large, 0, 1);
+	av_mem_stats_release(h->stats);
+    }
+    h->stats = stats;
+    if (stats)
+    {
+	av_atomic_add64(&stats->refs, 1);
+	mem_stats_add(stats, h->size, large, 1, 0);
+    }
+}
+
+// 分配一个流统计结构，引用计数为1，所有者用完调用av_mem_stats_release。
+AVMemStats *av_mem_stats_alloc(void)
+{
+    AVMemStats *stats = calloc(1, sizeof(AVMemStats));
+
+    if (stats)
+	stats->refs = 1;
+    return stats;
+}
+
+void av_mem_stats_release(AVMemStats *stats)
+{
+    if (stats && av_atomic_add64(&stats->refs, -1) == 0)
+	free(stats);
+}
+
+// 设置本线程之后的分配计入哪个流统计，返回原来的设置，便于调用者恢复。
+AVMemStats *av_mem_stats_set_current(AVMemStats *stats)
+{
+    AVMemStats *prev = mem_stats_current;
+
+    mem_stats_current = stats;
+    return prev;
+}
+
+AVMemStats *av_mem_stats_get_current(void)
+{
+    return mem_stats_current;
+}
+
+const AVMemStats *av_mem_stats_get_global(void)
+{
+    return &mem_stats_global;
+}
+
+// 内存动态分配函数，做一下简单参数校验后调用系统函数，返回MALLOC_ALIGN 字节对齐的地址。
+void *av_malloc(unsigned int size)
+{
+    uint8_t *raw, *ptr;
+    MemHeader *h;
+
+    if (size > INT_MAX - MEM_OVERHEAD)
+	return NULL;
+    raw = malloc(size + MEM_OVERHEAD);
+    if (!raw)
+	return NULL;
+
+    ptr = ALIGN_PTR(raw + sizeof(MemHeader), MALLOC_ALIGN);
+    h = MEM_HEADER(ptr);
+    h->raw = raw;
+    h->size = size;
+    h->map_size = 0;
+    h->kind = MEM_HEAP;
+    mem_charge(h);
+
+    return ptr;
+}
+
+// 大块内存分配函数，用于帧缓存分量等大块内存。够大时直接整页映射并尽量用大页，
+// 大页不可用时退回普通页映射(linux 上再建议内核用透明大页)，小于LARGE_ALLOC_MIN 时就是av_malloc。
+void *av_malloc_large(unsigned int size)
+{
+    uint8_t *map = NULL, *ptr;
+    unsigned int map_size;
+    int kind = MEM_HUGE;
+    MemHeader *h;
+
+    if (size < LARGE_ALLOC_MIN || size > INT_MAX - LARGE_ALLOC_MIN)
+	return av_malloc(size);
+
+#ifdef CONFIG_WIN32
+    {
+	// 大页需要SeLockMemoryPrivilege 权限，没有权限时VirtualAlloc 失败，退回普通页。
+	SIZE_T large_page = GetLargePageMinimum();
+	if (large_page)
+	{
+	    map_size = (unsigned int)((size + MALLOC_ALIGN + large_page - 1) & ~(large_page - 1));
+	    map = VirtualAlloc(NULL, map_size, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+	}
+	if (!map)
+	{
+	    kind = MEM_MAPPED;
+	    map_size = (size + MALLOC_ALIGN + PAGE_SIZE_4K - 1) & ~(PAGE_SIZE_4K - 1);
+	    map = VirtualAlloc(NULL, map_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+	}
+    }
+#else
+#ifdef MAP_HUGETLB
+    map_size = (size + MALLOC_ALIGN + LARGE_ALLOC_MIN - 1) & ~(LARGE_ALLOC_MIN - 1);
+    map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (map == MAP_FAILED)
+	map = NULL;
+#endif
+    if (!map)
+    {
+	// 系统没有预留大页时退回普通页映射。
+	kind = MEM_MAPPED;
+	map_size = (size + MALLOC_ALIGN + PAGE_SIZE_4K - 1) & ~(PAGE_SIZE_4K - 1);
+	map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (map == MAP_FAILED)
+	    map = NULL;
+#ifdef MADV_HUGEPAGE
+	if (map)
+	    madvise(map, map_size, MADV_HUGEPAGE);
+#endif
+    }
+#endif
+    if (!map)
+	return av_malloc(size);
+
+    ptr = map + MALLOC_ALIGN;
+    h = MEM_HEADER(ptr);
+    h->raw = map;
+    h->size = size;
+    h->map_size = map_size;
+    h->kind = kind;
+    mem_charge(h);
+
+    return ptr;
+}
+
+// 内存动态重分配函数，做一下简单参数校验后调用系统函数，保持MALLOC_ALIGN 字节对齐。
+void *av_realloc(void *ptr, unsigned int size)
+{
+    MemHeader *h, hdr;
+    uint8_t *raw, *ptr1;
+    unsigned int offset;
+
+    if (!ptr)
+	return av_malloc(size);
+    if (size > INT_MAX - MEM_OVERHEAD)
+	return NULL;
+
+    h = MEM_HEADER(ptr);
+    if (h->kind != MEM_HEAP)
+    {
+	// 整页映射的内存不能realloc，重新分配再拷贝。
+	ptr1 = av_malloc(size);
+	if (!ptr1)
+	    return NULL;
+	memcpy(ptr1, ptr, FFMIN(size, h->size));
+	av_free(ptr);
+	return ptr1;
+    }
+
+    hdr = *h;
+    offset = (uint8_t*)ptr - hdr.raw;
+    raw = realloc(hdr.raw, size + MEM_OVERHEAD);
+    if (!raw)
+	return NULL;
+
+    // realloc 后原始地址的对齐余数可能变了，把数据挪到新的对齐位置。
+    ptr1 = ALIGN_PTR(raw + sizeof(MemHeader), MALLOC_ALIGN);
+    if (ptr1 != raw + offset)
+	memmove(ptr1, raw + offset, FFMIN(size, hdr.size));
+
+    h = MEM_HEADER(ptr1);
+    *h = hdr;
+    h->raw = raw;
+    h->size = size;
+
+    mem_stats_add(&mem_stats_global, (int64_t)size - hdr.size, 0, 0, 0);
+    if (hdr.stats)
+	mem_stats_add(hdr.stats, (int64_t)size - hdr.size, 0, 0, 0);
+
+    return ptr1;
+}
+// 内存动态释放函数，做一下简单参数校验后按分配方式调用系统函数
+void av_free(void *ptr)
+{
+    MemHeader *h;
+
+    if (!ptr)
+	return;
+
+    h = MEM_HEADER(ptr);
+    mem_uncharge(h);
+
+    if (h->kind == MEM_HEAP)
+	free(h->raw);
+    else
+#ifdef CONFIG_WIN32
+	VirtualFree(h->raw, 0, MEM_RELEASE);
+#else
+	munmap(h->raw, h->map_size);
+#endif
+}
+// 内存动态分配函数，复用av_malloc()函数，再把分配的内存清0
+void *av_mallocz(unsigned int size)
+{
+    void *ptr;
+
+    ptr = av_malloc(size);
+    if (!ptr)
+	return NULL;
+
+    memset(ptr, 0, size);
+    return ptr;
+}
+// 快速内存动态分配函数，预分配一些内存来避免多次调用系统函数达到快速的目的
+void *av_fast_realloc(void *ptr, unsigned int *size, unsigned int min_size)
+{
+    if (min_size < *size)
+	return ptr;
+
+    *size = FFMAX(17 * min_size / 16 + 32, min_size);
+
+    return av_realloc(ptr, *size);
+}
+// 动态内存释放函数，注意传入的变量的类型。
+void av_freep(void *arg)
+{
+    void **ptr = (void **)arg;
+    av_free(*ptr);
+    *ptr = NULL;
+}
+
+AVCodec *first_avcodec = NULL;
+
+// 把编解码器串联成一个链表，便于查找。
+void register_avcodec(AVCodec *format)
+{
+    AVCodec **p;
+    p = &first_avcodec;
+    while (*p != NULL)
+	p = &(*p)->next;
+    *p = format;
+    format->next = NULL;
+}
+// 引用计数的帧缓存，因为视频图像有RGB 或YUV 分量格式，所以每个数组有四个分量。
+// 每个帧缓存属于一个帧缓存池，引用计数降为0 时回到池的空闲链表，下次直接复用，不再重新清内存。
+typedef struct AVFrameBuf
+{
+    uint8_t *base[4];
+    uint8_t *data[4];
+    int linesize[4];
+
+    int refcount;			// 引用计数，由所属池的互斥量保护
+    int progress;			// 解码进度，AV_FRAME_PROGRESS_DONE 表示整帧已解码完，由所属池的互斥量保护
+    void *opaque;			// 应用程序提供的缓存对象(比如显示表面)，内部分配的帧缓存为NULL
+    struct AVFramePool *pool;		// 所属的帧缓存池
+    struct AVFrameBuf *next;		// 串接池中的空闲帧缓存
+} AVFrameBuf;
+
+// 帧缓存池，按同样的像素格式和长宽分配帧缓存，几何参数相同的多个编解码器上下文可以共享同一个池。
+// 帧缓存可能在解码线程之外(比如显示线程)释放，所以池的操作都要加锁。
+typedef struct AVFramePool
+{
+    AVMutex lock;
+    AVCond progress_cond;		// 帧缓存解码进度更新时广播
+    int pix_fmt;
+    int width, height;
+
+    int refcount;			// 引用此池的编解码器上下文数
+    int nb_used;			// 还有引用的帧缓存数
+    AVFrameBuf *free_list;		// 空闲帧缓存链表
+
+    AVFrameBufAllocCallback alloc_buf;	// 应用程序提供帧缓存内存时的分配和释放函数，NULL 表示池自己分配
+    AVFrameBufFreeCallback free_buf;
+    void *opaque;
+} AVFramePool;
+
+#define ALIGN(x, a) (((x)+(a)-1)&~((a)-1))
+// 计算各种图像格式要求的图像长宽的字节对齐数，是1 个还是2 个，4 个，8 个，16 个字节对齐。
+static void align_dimensions(int pix_fmt, int *width, int *height)
+{
+    // 默认长宽是1 个字节对齐。
+    int w_align = 1;
+    int h_align = 1;
+
+    switch (pix_fmt)
+    {
+    case PIX_FMT_YUV420P:
+    case PIX_FMT_YUV422:
+    case PIX_FMT_UYVY422:
+    case PIX_FMT_YUV422P:
+    case PIX_FMT_YUV444P:
+    case PIX_FMT_GRAY8:
+    case PIX_FMT_YUVJ420P:
+    case PIX_FMT_YUVJ422P:
+    case PIX_FMT_YUVJ444P: //FIXME check for non mpeg style codecs and use less alignment
+	w_align = 16;
+	h_align = 16;
+	break;
+    case PIX_FMT_YUV411P:
+    case PIX_FMT_UYVY411:
+	w_align = 32;
+	h_align = 8;
+	break;
+    case PIX_FMT_YUV410P:
+    case PIX_FMT_RGB555:
+    case PIX_FMT_PAL8:
+	break;
+    case PIX_FMT_BGR24:
+	break;
+    default:
+	w_align = 1;
+	h_align = 1;
+	break;
+    }
+
+    *width = ALIGN(*width, w_align);
+    *height = ALIGN(*height, h_align);
+}
+
+void avcodec_align_dimensions(AVCodecContext *s, int *width, int *height)
+{
+    align_dimensions(s->pix_fmt, width, height);
+}
+// 校验视频图像的长宽是否合法。
+int avcodec_check_dimensions(void *av_log_ctx, unsigned int w, unsigned int h)
+{
+    if ((int)w > 0 && (int)h > 0 && (w + 128)*(uint64_t)(h + 128) < INT_MAX / 4)
+	return 0;
+
+    return  -1;
+}
+// 帧缓存池的创建和引用计数。池在最后一个上下文不再引用并且所有帧缓存都归还后释放。
+AVFramePool *av_frame_pool_create(int pix_fmt, int width, int height)
+{
+    AVFramePool *pool = av_mallocz(sizeof(AVFramePool));
+
+    if (!pool)
+	return NULL;
+
+    av_mutex_init(&pool->lock);
+    av_cond_init(&pool->progress_cond);
+    pool->pix_fmt = pix_fmt;
+    pool->width = width;
+    pool->height = height;
+    pool->refcount = 1;
+
+    return pool;
+}
+
+// 创建由应用程序提供帧缓存内存的池(直接渲染)。解码器需要新帧缓存时调用alloc_buf，
+// 应用程序返回各分量的地址和单行长度，比如直接给出显示表面的内存，输出格式和显示格式一致时解码器就直接写到显示表面上。
+// 这样的帧缓存没有扩展边界，不适合需要EDGE_WIDTH 的解码器；PAL8 格式还要在data[1] 提供AVPALETTE_SIZE 字节的调色板内存。
+// 池释放时对每个帧缓存调用free_buf，可能在最后释放帧引用的任意线程中调用。
+AVFramePool *av_frame_pool_create_external(int pix_fmt, int width, int height,
+    AVFrameBufAllocCallback alloc_buf, AVFrameBufFreeCallback free_buf, void *opaque)
+{
+    AVFramePool *pool;
+
+    if (!alloc_buf)
+	return NULL;
+
+    pool = av_frame_pool_create(pix_fmt, width, height);
+    if (!pool)
+	return NULL;
+
+    pool->alloc_buf = alloc_buf;
+    pool->free_buf = free_buf;
+    pool->opaque = opaque;
+
+    return pool;
+}
+
+AVFramePool *av_frame_pool_ref(AVFramePool *pool)
+{
+    av_mutex_lock(&pool->lock);
+    pool->refcount++;
+    av_mutex_unlock(&pool->lock);
+
+    return pool;
+}
+
+// 调用时必须已持有池的锁，返回后锁已释放，池可能已被释放。
+static void frame_pool_release_locked(AVFramePool *pool)
+{
+    AVFrameBuf *buf;
+    int i;
+
+    if (pool->refcount || pool->nb_used)
+    {
+	av_mutex_unlock(&pool->lock);
+	return;
+    }
+    av_mutex_unlock(&pool->lock);
+
+    while ((buf = pool->free_list) != NULL)
+    {
+	pool->free_list = buf->next;
+	if (pool->alloc_buf)
+	{
+	    if (pool->free_buf)
+		pool->free_buf(pool->opaque, buf->opaque);
+	}
+	else
+	{
+	    for (i = 0; i < 4; i++)
+		av_free(buf->base[i]);
+	}
+	av_free(buf);
+    }
+    av_cond_destroy(&pool->progress_cond);
+    av_mutex_destroy(&pool->lock);
+    av_free(pool);
+}
+
+void av_frame_pool_unref(AVFramePool **ppool)
+{
+    AVFramePool *pool = *ppool;
+
+    if (!pool)
+	return;
+    *ppool = NULL;
+
+    av_mutex_lock(&pool->lock);
+    pool->refcount--;
+    frame_pool_release_locked(pool);
+}
+
+// 按池的几何参数分配一个新的帧缓存，只在第一次分配时把内存设置成128。
+static AVFrameBuf *frame_pool_alloc_buf(AVFramePool *pool)
+{
+    int i;
+    int w = pool->width;
+    int h = pool->height;
+    int align_off;
+    int h_chroma_shift, v_chroma_shift;
+    int pixel_size, size[3];
+    AVPicture picture;
+    AVFrameBuf *buf;
+
+    buf = av_mallocz(sizeof(AVFrameBuf));
+    if (!buf)
+	return NULL;
+
+    if (pool->alloc_buf)
+    {
+	// 内存由应用程序提供，内容也由应用程序决定是否初始化。
+	if (pool->alloc_buf(pool->opaque, pool->pix_fmt, pool->width, pool->height,
+	    buf->data, buf->linesize, &buf->opaque) < 0)
+	{
+	    av_free(buf);
+	    return NULL;
+	}
+	for (i = 0; i < 4; i++)
+	    buf->base[i] = buf->data[i];
+	buf->pool = pool;
+	return buf;
+    }
+
+    // 计算CbCr 色度分量长宽的与Y 亮度分量长宽的比，最后用移位实现。
+    avcodec_get_chroma_sub_sample(pool->pix_fmt, &h_chroma_shift, &v_chroma_shift);
+    // 规整长宽满足特定图像像素格式的要求。
+    align_dimensions(pool->pix_fmt, &w, &h);
+
+    // 把长宽放大一些，比如在mpeg4 视频中编码算法中的运动估计要把原始图像做扩展来满足不受限制运动矢量的要求(运动矢量可以超出原始图像边界)。
+    w += EDGE_WIDTH * 2;
+    h += EDGE_WIDTH * 2;
+    // 计算特定格式的图像参数，包括各分量的大小，单行长度(linesize/stride)等等。
+    avpicture_fill(&picture, NULL, pool->pix_fmt, w, h);
+    pixel_size = picture.linesize[0] * 8 / w;
+    assert(pixel_size >= 1);
+
+    if (pixel_size == 3 * 8)
+	w = ALIGN(w, STRIDE_ALIGN << h_chroma_shift);
+    else
+	w = ALIGN(pixel_size *w, STRIDE_ALIGN << (h_chroma_shift + 3)) / pixel_size;
+
+    size[1] = avpicture_fill(&picture, NULL, pool->pix_fmt, w, h);
+    size[0] = picture.linesize[0] * h;
+    size[1] -= size[0];
+    if (picture.data[2])
+	size[1] = size[2] = size[1] / 2;
+    else
+	size[2] = 0;
+
+    for (i = 0; i < 3 && size[i]; i++)
+    {
+	const int h_shift = i == 0 ? 0 : h_chroma_shift;
+	const int v_shift = i == 0 ? 0 : v_chroma_shift;
+
+	buf->linesize[i] = picture.linesize[i];
+	// 实质性分配内存，并把内存设置成128，复用时不再重复设置。
+	// av_malloc_large 返回的地址已按MALLOC_ALIGN 对齐，不需要再多分配字节来手工对齐。
+	buf->base[i] = av_malloc_large(size[i]);
+	if (buf->base[i] == NULL)
+	{
+	    while (i--)
+		av_free(buf->base[i]);
+	    av_free(buf);
+	    return NULL;
+	}
+	memset(buf->base[i], 128, size[i]);
+	// 内存对齐计算。
+	align_off = ALIGN((buf->linesize[i] * EDGE_WIDTH >> v_shift) + (EDGE_WIDTH >> h_shift), STRIDE_ALIGN);
+
+	if ((pool->pix_fmt == PIX_FMT_PAL8) || !size[2])
+	    buf->data[i] = buf->base[i];
+	else
+	    buf->data[i] = buf->base[i] + align_off;
+    }
+    buf->pool = pool;
+
+    return buf;
+}
+
+// 取帧缓存对应的应用程序缓存对象，帧不是来自应用程序提供内存的池时返回NULL。
+void *av_frame_get_buf_opaque(const AVFrame *frame)
+{
+    return frame->buf ? frame->buf->opaque : NULL;
+}
+
+// 增加帧缓存的引用，dst 和src 共用同一块图像内存，不拷贝数据。
+int av_frame_ref(AVFrame *dst, const AVFrame *src)
+{
+    *dst = *src;
+
+    if (src->buf)
+    {
+	AVFramePool *pool = src->buf->pool;
+	av_mutex_lock(&pool->lock);
+	src->buf->refcount++;
+	av_mutex_unlock(&pool->lock);
+    }
+    return 0;
+}
+
+// 释放一个帧缓存引用，最后一个引用释放时帧缓存回到池的空闲链表。
+void av_frame_unref(AVFrame *frame)
+{
+    AVFrameBuf *buf = frame->buf;
+    int i;
+
+    if (buf)
+    {
+	AVFramePool *pool = buf->pool;
+
+	av_mutex_lock(&pool->lock);
+	if (--buf->refcount == 0)
+	{
+	    buf->next = pool->free_list;
+	    pool->free_list = buf;
+	    pool->nb_used--;
+	}
+	frame_pool_release_locked(pool);
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+	frame->data[i] = NULL;
+	frame->base[i] = NULL;
+    }
+    frame->buf = NULL;
+}
+
+// 解码进度信号。解码器把帧交出去之后，别的线程(比如显示线程)或依赖这一帧的下一帧可能要读它，
+// 解码器写完若干行后调用report 报告进度，读的一方调用await 等到需要的行都写好。
+// 进度只增不减，AV_FRAME_PROGRESS_DONE 表示整帧完成。不归帧缓存池管理的帧没有进度，视为已完成。
+void av_frame_report_progress(AVFrame *frame, int progress)
+{
+    AVFrameBuf *buf = frame->buf;
+
+    if (!buf)
+	return;
+
+    av_mutex_lock(&buf->pool->lock);
+    if (progress > buf->progress)
+    {
+	buf->progress = progress;
+	av_cond_broadcast(&buf->pool->progress_cond);
+    }
+    av_mutex_unlock(&buf->pool->lock);
+}
+
+void av_frame_await_progress(const AVFrame *frame, int progress)
+{
+    AVFrameBuf *buf = frame->buf;
+
+    if (!buf)
+	return;
+
+    av_mutex_lock(&buf->pool->lock);
+    while (buf->progress < progress)
+	av_cond_wait(&buf->pool->progress_cond, &buf->pool->lock);
+    av_mutex_unlock(&buf->pool->lock);
+}
+
+// 从上下文的帧缓存池取一个帧缓存，引用计数为1。池的几何参数和上下文不符时换一个新池，
+// 这样多个上下文可以事先共享同一个池(avctx->frame_pool = av_frame_pool_ref(...))。
+int avcodec_default_get_buffer(AVCodecContext *s, AVFrame *pic)
+{
+    int i;
+    AVFramePool *pool;
+    AVFrameBuf *buf;
+
+    assert(pic->data[0] == NULL);
+    // 校验视频图像的长宽是否合法。
+    if (avcodec_check_dimensions(s, s->width, s->height))
+	return  -1;
+
+    pool = s->frame_pool;
+    if (pool && (pool->pix_fmt != s->pix_fmt || pool->width != s->width || pool->height != s->height))
+	av_frame_pool_unref(&s->frame_pool);
+
+    if (!s->frame_pool)
+    {
+	s->frame_pool = av_frame_pool_create(s->pix_fmt, s->width, s->height);
+	if (!s->frame_pool)
+	    return  -1;
+    }
+    pool = s->frame_pool;
+
+    // 优先复用空闲帧缓存，没有时才分配新的。
+    av_mutex_lock(&pool->lock);
+    buf = pool->free_list;
+    if (buf)
+	pool->free_list = buf->next;
+    av_mutex_unlock(&pool->lock);
+
+    if (!buf)
+    {
+	buf = frame_pool_alloc_buf(pool);
+	if (!buf)
+	    return  -1;
+    }
+
+    av_mutex_lock(&pool->lock);
+    buf->refcount = 1;
+    buf->progress = 0;
+    buf->next = NULL;
+    pool->nb_used++;
+    av_mutex_unlock(&pool->lock);
+
+    for (i = 0; i < 4; i++)
+    {
+	// 把分配的内存参数赋值到pic 指向的结构中，传递出去。
+	pic->base[i] = buf->base[i];
+	pic->data[i] = buf->data[i];
+	pic->linesize[i] = buf->linesize[i];
+    }
+    pic->buf = buf;
+
+    return 0;
+}
+
+void avcodec_default_release_buffer(AVCodecContext *s, AVFrame *pic)
+{
+    av_frame_unref(pic);
+}
+
+// 解码器要在上一帧的基础上继续修改图像。如果帧缓存还被别人引用(比如显示队列)，
+// 就先复制一份再改(写时复制)，不影响别人手里的图像。
+int avcodec_default_reget_buffer(AVCodecContext *s, AVFrame *pic)
+{
+    AVFrame tmp;
+    int shared = 0;
+
+    if (pic->data[0] == NULL)  // If no picture return a new buffer
+    {
+	return s->get_buffer(s, pic);
+    }
+
+    if (pic->buf)
+    {
+	av_mutex_lock(&pic->buf->pool->lock);
+	shared = pic->buf->refcount > 1;
+	av_mutex_unlock(&pic->buf->pool->lock);
+    }
+    if (!shared)
+	return 0;
+
+    memset(&tmp, 0, sizeof(tmp));
+    if (s->get_buffer(s, &tmp))
+	return  -1;
+
+    // 新帧依赖上一帧的全部内容，复制前要等上一帧解码完成。
+    av_frame_await_progress(pic, AV_FRAME_PROGRESS_DONE);
+    img_copy((AVPicture*)&tmp, (const AVPicture*)pic, s->pix_fmt, s->width, s->height);
+    s->release_buffer(s, pic);
+    *pic = tmp;
+
+    return 0;
+}
+
+void avcodec_default_free_buffers(AVCodecContext *s)
+{
+    av_frame_pool_unref(&s->frame_pool);
+}
+
+AVCodecContext *avcodec_alloc_context(void)
+{
+    AVCodecContext *s = av_malloc(sizeof(AVCodecContext));
+
+    if (s == NULL)
+	return NULL;
+
+    memset(s, 0, sizeof(AVCodecContext));
+
+    s->get_buffer = avcodec_default_get_buffer;
+    s->release_buffer = avcodec_default_release_buffer;
+
+    s->pix_fmt = PIX_FMT_NONE;
+    s->request_pix_fmt = PIX_FMT_NONE;
+    s->skip_frame = AVDISCARD_DEFAULT;
+    s->thread_count = 1;
+
+    s->palctrl = NULL;
+    s->pkt = NULL;
+    s->reget_buffer = avcodec_default_reget_buffer;
+
+    return s;
+}
+
+int avcodec_open(AVCodecContext *avctx, AVCodec *codec)
+{
+    int ret = -1;
+    AVMemStats *prev = av_mem_stats_set_current(avctx->mem_stats);
+
+    if (avctx->codec)
+	goto end;
+
+    if (codec->priv_data_size > 0)
+    {
+	avctx->priv_data = av_mallocz(codec->priv_data_size);
+	if (!avctx->priv_data)
+	    goto end;
+    }
+    else
+    {
+	avctx->priv_data = NULL;
+    }
+
+    avctx->codec = codec;
+    avctx->codec_id = codec->id;
+    avctx->frame_number = 0;
+    ret = avctx->codec->init(avctx);
+    if (ret < 0)
+    {
+	av_freep(&avctx->priv_data);
+	avctx->codec = NULL;
+	goto end;
+    }
+    ret = 0;
+end:
+    av_mem_stats_set_current(prev);
+    return ret;
+}
+
+int avcodec_decode_video(AVCodecContext *avctx, AVFrame *picture, int *got_picture_ptr,
+    uint8_t *buf, int buf_size)
+{
+    int ret;
+    AVMemStats *prev;
+
+    *got_picture_ptr = 0;
+
+    if (buf_size && avctx->skip_frame >= AVDISCARD_ALL)
+    {
+	// 全部跳过时连解码都省了，增量编码的图像要到下一个关键帧才能恢复正确。
+	avctx->frame_number++;
+	ret = buf_size;
+    }
+    else if (buf_size)
+    {
+	// 解码期间分配的帧缓存等内存计入本流的统计。
+	prev = av_mem_stats_set_current(avctx->mem_stats);
+	ret = avctx->codec->decode(avctx, picture, got_picture_ptr, buf, buf_size);
+	av_mem_stats_set_current(prev);
+
+	// 解码函数返回时图像一定已写完，不自己报告进度的解码器由这里统一报告整帧完成。
+	// 解码器跳过不输出的帧也计数，输出帧的序号不连续时调用者就知道中间有帧被跳过了。
+	if (*got_picture_ptr)
+	{
+	    av_frame_report_progress(picture, AV_FRAME_PROGRESS_DONE);
+	    picture->coded_picture_number = avctx->frame_number;
+	}
+	if (ret >= 0)
+	    avctx->frame_number++;
+    }
+    else
+	ret = 0;
+
+    return ret;
+}
+
+// 一次解码count 个独立音频流各一个数据包，数据包大小都是buf_size(TrueSpeech 每流一帧32 字节时最快)。
+// 所有上下文必须用同一个解码器打开。解码器支持时多个流一起计算，否则逐个解码，每个流的输出和单独解码完全一样。
+// 成功返回0，frame_size_ptr[i] 是第i 个流输出的字节数，consumed[i] 是第i 个流消耗的字节数。
+// 一个输出缓存放不下整个数据包时consumed[i] 小于buf_size，调用者要把剩下的数据再送进来。
+int avcodec_decode_audio_batch(AVCodecContext **avctx, int count, int16_t **samples, int *frame_size_ptr,
+    int *consumed, uint8_t **buf, int buf_size)
+{
+    int i, ret = 0;
+
+    if (count <= 0 || buf_size <= 0)
+	return 0;
+
+    if (avctx[0]->codec->decode_batch)
+    {
+	ret = avctx[0]->codec->decode_batch(avctx, count, samples, frame_size_ptr, consumed, buf, buf_size);
+	for (i = 0; ret >= 0 && i < count; i++)
+	    avctx[i]->frame_number++;
+    }
+    else
+    {
+	for (i = 0; ret >= 0 && i < count; i++)
+	{
+	    ret = avcodec_decode_audio(avctx[i], samples[i], &frame_size_ptr[i], buf[i], buf_size);
+	    consumed[i] = ret < 0 ? 0 : ret;
+	}
+    }
+
+    return ret < 0 ? ret : 0;
+}
+
+// 编码一帧视频，返回写入buf 的字节数，buf 不够大时返回负数。是否关键帧见avctx->coded_frame->key_frame。
+int avcodec_encode_video(AVCodecContext *avctx, uint8_t *buf, int buf_size, const AVFrame *pict)
+{
+    int ret;
+    AVMemStats *prev;
+
+    prev = av_mem_stats_set_current(avctx->mem_stats);
+    ret = avctx->codec->encode(avctx, buf, buf_size, (void*)pict);
+    av_mem_stats_set_current(prev);
+
+    if (ret >= 0)
+	avctx->frame_number++;
+    return ret;
+}
+
+// 以数据包为单位解码视频，解码期间avctx->pkt 指向avpkt，解码器可以读取包附带的调色板等附加数据。
+int avcodec_decode_video2(AVCodecContext *avctx, AVFrame *picture, int *got_picture_ptr,
+    AVPacket *avpkt)
+{
+    int ret;
+
+    avctx->pkt = avpkt;
+    ret = avcodec_decode_video(avctx, picture, got_picture_ptr, avpkt->data, avpkt->size);
+    avctx->pkt = NULL;
+
+    return ret;
+}
+
+int avcodec_decode_audio(AVCodecContext *avctx, int16_t *samples, int *frame_size_ptr,
+    uint8_t *buf, int buf_size)
+{
+    int ret;
+    AVMemStats *prev;
+
+    *frame_size_ptr = 0;
+    if (buf_size)
+    {
+	prev = av_mem_stats_set_current(avctx->mem_stats);
+	ret = avctx->codec->decode(avctx, samples, frame_size_ptr, buf, buf_size);
+	av_mem_stats_set_current(prev);
+	avctx->frame_number++;
+    }
+    else
+	ret = 0;
+    return ret;
+}
+
+// 送包/取帧解码接口。解码器有send_packet/receive_frame 时数据包交给解码器，每次取一帧；
+// 否则解码器内部仍然是原来的一包进、最多一帧出的decode 函数，这里把送入的数据包保存下来，
+// 每次取帧时接着上次的位置解码，调用者不用再自己保存半个数据包的状态。
+// 一个音频包可以解出多帧，视频包总是一次解完。
+typedef struct AVDecodeQueue
+{
+    AVPacket pkt;		// 送入还没解码完的数据包，归解码器所有，解码器自己保存数据包时不用
+    int offset;			// pkt 中已解码的字节数
+    int draining;		// 送入了空包，数据包解完后返回AVERROR_EOF
+    int16_t *audio_buf;		// 音频输出缓存，取到的音频帧指向这里
+} AVDecodeQueue;
+
+static void decode_queue_drop_packet(AVDecodeQueue *q)
+{
+    if (q->pkt.destruct)
+	q->pkt.destruct(&q->pkt);
+    memset(&q->pkt, 0, sizeof(q->pkt));
+    q->offset = 0;
+}
+
+static void decode_queue_free(AVCodecContext *avctx)
+{
+    AVDecodeQueue *q = avctx->decode_queue;
+
+    if (!q)
+	return;
+    decode_queue_drop_packet(q);
+    av_free(q->audio_buf);
+    av_freep(&avctx->decode_queue);
+}
+
+// 送入一个数据包，数据包连同数据内存一起交给解码器，调用后avpkt 被清空，调用者不再释放。
+// avpkt 为NULL 或大小为0 表示输入结束。上一个数据包还没解完时返回AVERROR_AGAIN，数据包不动，应先取帧。
+int avcodec_send_packet(AVCodecContext *avctx, AVPacket *avpkt)
+{
+    AVDecodeQueue *q = avctx->decode_queue;
+    AVMemStats *prev;
+    int ret;
+
+    if (!avctx->codec)
+	return  -1;
+
+    if (!q)
+    {
+	q = av_mallocz(sizeof(AVDecodeQueue));
+	if (!q)
+	    return  -1;
+	avctx->decode_queue = q;
+    }
+
+    if (q->draining)
+	return AVERROR_EOF;
+
+    if (!avpkt || avpkt->size <= 0)
+    {
+	if (q->offset < q->pkt.size)
+	    return AVERROR_AGAIN;
+	decode_queue_drop_packet(q);
+	q->draining = 1;
+	if (avpkt && avpkt->destruct)
+	    avpkt->destruct(avpkt);
+    }
+    else if (avctx->codec->send_packet)
+    {
+	prev = av_mem_stats_set_current(avctx->mem_stats);
+	ret = avctx->codec->send_packet(avctx, avpkt);
+	av_mem_stats_set_current(prev);
+	if (ret < 0)
+	    return ret;
+    }
+    else
+    {
+	if (q->offset < q->pkt.size)
+	    return AVERROR_AGAIN;
+	decode_queue_drop_packet(q);
+	q->pkt = *avpkt;
+    }
+
+    if (avpkt)
+	memset(avpkt, 0, sizeof(AVPacket));
+    return 0;
+}
+
+// 取一帧解码输出。视频帧就是解码器自己的帧(可以用av_frame_ref 保留)，音频帧指向内部缓存，都只保证在下次取帧前有效。
+// 没有完整的数据包可解时返回AVERROR_AGAIN，输入已结束并且全部解完时返回AVERROR_EOF。
+int avcodec_receive_frame(AVCodecContext *avctx, AVFrame *frame)
+{
+    AVDecodeQueue *q = avctx->decode_queue;
+    AVMemStats *prev;
+    int ret, got, data_size;
+
+    if (!q)
+	return AVERROR_AGAIN;
+
+    if (avctx->codec->receive_frame)
+    {
+	prev = av_mem_stats_set_current(avctx->mem_stats);
+	ret = avctx->codec->receive_frame(avctx, frame);
+	av_mem_stats_set_current(prev);
+	if (ret != AVERROR_AGAIN)
+	{
+	    if (ret >= 0)
+		avctx->frame_number++;
+	    return ret;
+	}
+    }
+    else if (avctx->codec_type == CODEC_TYPE_VIDEO)
+    {
+	while (q->offset < q->pkt.size)
+	{
+	    ret = avcodec_decode_video2(avctx, frame, &got, &q->pkt);
+	    decode_queue_drop_packet(q);
+	    if (ret < 0)
+		return ret;
+	    if (got)
+		return 0;
+	}
+    }
+    else
+    {
+	if (!q->audio_buf)
+	{
+	    q->audio_buf = av_malloc(AVCODEC_MAX_AUDIO_FRAME_SIZE);
+	    if (!q->audio_buf)
+		return  -1;
+	}
+
+	while (q->offset < q->pkt.size)
+	{
+	    ret = avcodec_decode_audio(avctx, q->audio_buf, &data_size,
+		q->pkt.data + q->offset, q->pkt.size - q->offset);
+	    if (ret < 0)
+	    {
+		// 出错时丢掉整个数据包，下次从新的数据包开始。
+		decode_queue_drop_packet(q);
+		return ret;
+	    }
+	    // 不消耗数据又没有输出的解码器按整包消耗处理，避免死循环。
+	    if (ret == 0 && data_size <= 0)
+		ret = q->pkt.size - q->offset;
+	    q->offset += ret;
+	    if (q->offset >= q->pkt.size)
+		decode_queue_drop_packet(q);
+
+	    if (data_size > 0)
+	    {
+		frame->data[0] = (uint8_t*)q->audio_buf;
+		frame->linesize[0] = data_size;
+		frame->nb_samples = data_size / (2 * (avctx->channels > 0 ? avctx->channels : 1));
+		return 0;
+	    }
+	}
+    }
+
+    return q->draining ? AVERROR_EOF : AVERROR_AGAIN;
+}
+
+int avcodec_close(AVCodecContext *avctx)
+{
+    decode_queue_free(avctx);
+    if (avctx->codec->close)
+	avctx->codec->close(avctx);
+    avcodec_default_free_buffers(avctx);
+    av_freep(&avctx->priv_data);
+    avctx->codec = NULL;
+    return 0;
+}
+
+AVCodec *avcodec_find_decoder(enum CodecID id)
+{
+    AVCodec *p;
+    p = first_avcodec;
+    while (p)
+    {
+	if (p->decode != NULL && p->id == id)
+	    return p;
+	p = p->next;
+    }
+    return NULL;
+}
+
+AVCodec *avcodec_find_encoder(enum CodecID id)
+{
+    AVCodec *p;
+    p = first_avcodec;
+    while (p)
+    {
+	if (p->encode != NULL && p->id == id)
+	    return p;
+	p = p->next;
+    }
+    return NULL;
+}
+
+void avcodec_init(void)
+{
+    static int inited = 0;
+
+    if (inited != 0)
+	return;
+    inited = 1;
+
+    dsputil_static_init();
+    dsputil_init(&ff_dsp, mm_support());
+}
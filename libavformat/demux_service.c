@@ -0,0 +1,372 @@
+#include "avformat.h"
+#include "../libavutil/avthread.h"
+
+// 多文件并行解复用服务。固定数目的工作线程，每个线程有自己的任务双端队列，
+// 自己从队尾取任务，空闲时从其他线程的队头偷任务。一个任务就是一个文件，每次只读一小段数据包，
+// 没读完就放回自己的队尾，这样大文件不会长期霸占一个线程，别的线程也能偷走。
+// 还没打开的文件放在等待链表中，打开文件数、线程数和已交给回调还没释放的数据字节数都有上限。
+
+#define DEMUX_SLICE_PACKETS	64	// 一个任务一次最多连续读的数据包数
+#define DEMUX_MAX_THREADS	64
+
+typedef struct DemuxTask
+{
+    char filename[1024];
+    AVFormatContext *ic;		// NULL 表示文件还没打开
+
+    AVDemuxPacketCallback on_packet;
+    AVDemuxDoneCallback on_done;
+    void *opaque;
+
+    struct DemuxTask *next;		// 等待打开的文件链表
+} DemuxTask;
+
+typedef struct DemuxWorker
+{
+    struct AVDemuxService *svc;
+    AVThread thread;
+
+    AVMutex lock;			// 保护本线程的任务双端队列，要同时拿svc->lock 时先拿这个锁
+    DemuxTask **tasks;			// 环形数组，head 为队头(被偷的一端)，队尾归本线程
+    int head, count, size;
+} DemuxWorker;
+
+struct AVDemuxService
+{
+    AVMutex lock;			// 保护下面的计数和等待链表
+    AVCond cond;
+
+    DemuxWorker workers[DEMUX_MAX_THREADS];
+    int nb_workers;			// 创建后不再修改，工作线程偷任务时不加锁读取
+    int nb_started;			// 成功启动的线程数，只在创建和关闭服务的线程中使用
+
+    DemuxTask *pending_first, *pending_last;	// 等待打开的文件
+    int nb_queued;			// 各双端队列中的任务总数，和队列的长度在同一个临界区内修改
+    int nb_active;			// 还没结束的文件总数
+    int nb_open, max_open_files;
+    int inflight_bytes, max_inflight_bytes;
+    int quit;
+};
+
+// 修改了队列长度，在队列锁内同步更新任务总数，空闲线程看到nb_queued > 0 时一定有任务可偷，不会空转。
+static void deque_update_queued(DemuxWorker *w, int delta)
+{
+    AVDemuxService *svc = w->svc;
+
+    av_mutex_lock(&svc->lock);
+    svc->nb_queued += delta;
+    if (delta > 0)
+	av_cond_broadcast(&svc->cond);
+    av_mutex_unlock(&svc->lock);
+}
+
+// 放回队尾，并唤醒空闲线程来偷。
+static int deque_push(DemuxWorker *w, DemuxTask *task)
+{
+    av_mutex_lock(&w->lock);
+    if (w->count == w->size)
+    {
+	// 满了就扩容，把环形数组展开到新数组的开头。
+	int i, size = w->size ? w->size * 2 : 16;
+	DemuxTask **tasks = av_malloc(size * sizeof(DemuxTask*));
+	if (!tasks)
+	{
+	    av_mutex_unlock(&w->lock);
+	    return  -1;
+	}
+	for (i = 0; i < w->count; i++)
+	    tasks[i] = w->tasks[(w->head + i) % w->size];
+	av_free(w->tasks);
+	w->tasks = tasks;
+	w->head = 0;
+	w->size = size;
+    }
+    w->tasks[(w->head + w->count) % w->size] = task;
+    w->count++;
+    deque_update_queued(w, 1);
+    av_mutex_unlock(&w->lock);
+    return 0;
+}
+
+// 本线程从队尾取任务，后进先出，刚读过的文件数据还在缓存里。
+static DemuxTask *deque_pop(DemuxWorker *w)
+{
+    DemuxTask *task = NULL;
+
+    av_mutex_lock(&w->lock);
+    if (w->count > 0)
+    {
+	w->count--;
+	task = w->tasks[(w->head + w->count) % w->size];
+	deque_update_queued(w, -1);
+    }
+    av_mutex_unlock(&w->lock);
+    return task;
+}
+
+// 别的线程从队头偷任务，先进先出，偷走的是等得最久的文件。
+static DemuxTask *deque_steal(DemuxWorker *w)
+{
+    DemuxTask *task = NULL;
+
+    av_mutex_lock(&w->lock);
+    if (w->count > 0)
+    {
+	task = w->tasks[w->head];
+	w->head = (w->head + 1) % w->size;
+	w->count--;
+	deque_update_queued(w, -1);
+    }
+    av_mutex_unlock(&w->lock);
+    return task;
+}
+
+static DemuxTask *demux_get_task(DemuxWorker *w)
+{
+    AVDemuxService *svc = w->svc;
+    DemuxTask *task;
+    int i, self = w - svc->workers;
+
+    task = deque_pop(w);
+    for (i = 1; !task && i < svc->nb_workers; i++)
+	task = deque_steal(&svc->workers[(self + i) % svc->nb_workers]);
+    return task;
+}
+
+static void demux_finish_task(AVDemuxService *svc, DemuxTask *task, int status)
+{
+    int opened = task->ic != NULL;
+
+    if (task->ic)
+	av_close_input_file(task->ic);
+
+    if (task->on_done)
+	task->on_done(task->opaque, task->filename, status);
+
+    av_mutex_lock(&svc->lock);
+    if (opened)
+	svc->nb_open--;
+    svc->nb_active--;
+    av_cond_broadcast(&svc->cond);
+    av_mutex_unlock(&svc->lock);
+
+    av_free(task);
+}
+
+// 连续读一小段数据包交给回调。返回1 表示文件还没读完，0 表示读完，<0 表示出错或回调要求停止。
+static int demux_run_slice(AVDemuxService *svc, DemuxTask *task)
+{
+    AVFormatContext *ic = task->ic;
+    AVPacket pkt;
+    int i, ret;
+
+    for (i = 0; i < DEMUX_SLICE_PACKETS; i++)
+    {
+	// 已交给回调还没释放的数据太多时先等一等，超出部分最多是每个线程一个包。
+	av_mutex_lock(&svc->lock);
+	while (svc->inflight_bytes >= svc->max_inflight_bytes)
+	    av_cond_wait(&svc->cond, &svc->lock);
+	av_mutex_unlock(&svc->lock);
+
+	ret = av_read_packet(ic, &pkt);
+	if (ret < 0)
+	    return url_ferror(&ic->pb) ? url_ferror(&ic->pb) : 0;
+
+	if (pkt.size <= 0)
+	{
+	    av_free_packet(&pkt);
+	    if (url_feof(&ic->pb))
+		return 0;
+	    continue;
+	}
+
+	av_mutex_lock(&svc->lock);
+	svc->inflight_bytes += pkt.size;
+	av_mutex_unlock(&svc->lock);
+
+	// 数据包交给回调后归回调所有，用完要调用av_demux_service_free_packet 释放。
+	ret = task->on_packet(task->opaque, task->filename, ic, &pkt);
+	if (ret < 0)
+	    return ret;
+    }
+
+    return 1;
+}
+
+static void *demux_worker(void *arg)
+{
+    DemuxWorker *w = arg;
+    AVDemuxService *svc = w->svc;
+    DemuxTask *task;
+    int ret;
+
+    for (;;)
+    {
+	task = demux_get_task(w);
+
+	if (!task)
+	{
+	    // 没有可运行的任务，在打开文件数的上限内从等待链表取一个新文件，否则睡眠等待。
+	    av_mutex_lock(&svc->lock);
+	    if (svc->pending_first && svc->nb_open < svc->max_open_files)
+	    {
+		task = svc->pending_first;
+		svc->pending_first = task->next;
+		if (!svc->pending_first)
+		    svc->pending_last = NULL;
+		svc->nb_open++;
+		av_mutex_unlock(&svc->lock);
+
+		if (av_open_input_file(&task->ic, task->filename, NULL, 0, NULL) < 0)
+		{
+		    task->ic = NULL;
+		    av_mutex_lock(&svc->lock);
+		    svc->nb_open--;
+		    av_mutex_unlock(&svc->lock);
+		    demux_finish_task(svc, task, AVERROR_IO);
+		    continue;
+		}
+	    }
+	    else if (svc->quit && svc->nb_active == 0)
+	    {
+		av_mutex_unlock(&svc->lock);
+		break;
+	    }
+	    else
+	    {
+		if (svc->nb_queued == 0)
+		    av_cond_wait(&svc->cond, &svc->lock);
+		av_mutex_unlock(&svc->lock);
+		continue;
+	    }
+	}
+
+	ret = demux_run_slice(svc, task);
+	if (ret <= 0)
+	{
+	    demux_finish_task(svc, task, ret);
+	    continue;
+	}
+
+	// 文件没读完，放回自己的队尾。
+	if (deque_push(w, task) < 0)
+	    demux_finish_task(svc, task, AVERROR_NOMEM);
+    }
+
+    return NULL;
+}
+
+// 创建解复用服务并启动工作线程。全局的文件格式、协议和解码器链表在这里一次注册好，
+// 之后工作线程只读这些链表，所以服务运行期间不要再调用register_protocol 等注册函数。
+AVDemuxService *av_demux_service_create(int nb_threads, int max_open_files, int max_inflight_bytes)
+{
+    AVDemuxService *svc;
+    int i;
+
+    if (nb_threads <= 0 || max_open_files <= 0 || max_inflight_bytes <= 0)
+	return NULL;
+    if (nb_threads > DEMUX_MAX_THREADS)
+	nb_threads = DEMUX_MAX_THREADS;
+
+    av_register_all();
+
+    svc = av_mallocz(sizeof(AVDemuxService));
+    if (!svc)
+	return NULL;
+
+    av_mutex_init(&svc->lock);
+    av_cond_init(&svc->cond);
+    svc->max_open_files = max_open_files;
+    svc->max_inflight_bytes = max_inflight_bytes;
+
+    for (i = 0; i < nb_threads; i++)
+    {
+	svc->workers[i].svc = svc;
+	av_mutex_init(&svc->workers[i].lock);
+    }
+    svc->nb_workers = nb_threads;
+
+    for (i = 0; i < nb_threads; i++)
+    {
+	if (av_thread_create(&svc->workers[i].thread, demux_worker, &svc->workers[i]) < 0)
+	{
+	    // 已启动的线程正常退出后再返回失败。没启动的线程的队列一直是空的，偷任务时跳过也没有关系。
+	    av_demux_service_close(svc);
+	    return NULL;
+	}
+	svc->nb_started++;
+    }
+
+    return svc;
+}
+
+// 添加一个输入文件。on_packet 在工作线程中调用，同一文件的数据包按顺序交付，但可能来自不同线程。
+int av_demux_service_add(AVDemuxService *svc, const char *filename,
+    AVDemuxPacketCallback on_packet, AVDemuxDoneCallback on_done, void *opaque)
+{
+    DemuxTask *task;
+
+    if (!on_packet)
+	return  -1;
+
+    task = av_mallocz(sizeof(DemuxTask));
+    if (!task)
+	return AVERROR_NOMEM;
+
+    pstrcpy(task->filename, sizeof(task->filename), filename);
+    task->on_packet = on_packet;
+    task->on_done = on_done;
+    task->opaque = opaque;
+
+    av_mutex_lock(&svc->lock);
+    if (svc->pending_last)
+	svc->pending_last->next = task;
+    else
+	svc->pending_first = task;
+    svc->pending_last = task;
+    svc->nb_active++;
+    av_cond_broadcast(&svc->cond);
+    av_mutex_unlock(&svc->lock);
+
+    return 0;
+}
+
+// 回调用完数据包后调用，释放数据并归还在途字节配额。
+void av_demux_service_free_packet(AVDemuxService *svc, AVPacket *pkt)
+{
+    int size = pkt->size;
+
+    av_free_packet(pkt);
+
+    av_mutex_lock(&svc->lock);
+    svc->inflight_bytes -= size;
+    av_cond_broadcast(&svc->cond);
+    av_mutex_unlock(&svc->lock);
+}
+
+// 等所有已添加的文件处理完，然后停止工作线程并释放服务。
+void av_demux_service_close(AVDemuxService *svc)
+{
+    int i;
+
+    av_mutex_lock(&svc->lock);
+    svc->quit = 1;
+    av_cond_broadcast(&svc->cond);
+    av_mutex_unlock(&svc->lock);
+
+    for (i = 0; i < svc->nb_started; i++)
+	av_thread_join(svc->workers[i].thread);
+
+    for (i = 0; i < DEMUX_MAX_THREADS; i++)
+    {
+	if (svc->workers[i].svc)
+	{
+	    av_free(svc->workers[i].tasks);
+	    av_mutex_destroy(&svc->workers[i].lock);
+	}
+    }
+
+    av_cond_destroy(&svc->cond);
+    av_mutex_destroy(&svc->lock);
+    av_free(svc);
+}
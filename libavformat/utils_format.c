@@ -1,370 +1,567 @@
-#include "../berrno.h"
-#include "avformat.h"
-#include <assert.h>
-
-#define UINT_MAX  (0xffffffff)
-
-#define PROBE_BUF_MIN 2048
-#define PROBE_BUF_MAX 131072
-
-// ʶļʽýʽʹõһЩຯ
-
-AVInputFormat *first_iformat = NULL;
-
-
-void av_register_input_format(AVInputFormat *format)
-{
-    AVInputFormat **p;
-    p = &first_iformat;
-    // ѭƶڵָ뵽һļʽ
-    while (*p != NULL)
-	p = &(*p)->next;
-    // ֱӹҽҪעļʽ
-    *p = format;
-    format->next = NULL;
-}
-
-// Ƚļչʶļ͡
-int match_ext(const char *filename, const char *extensions)
-{
-    const char *ext, *p;
-    char ext1[32], *q;
-
-    if (!filename)
-	return 0;
-
-    // '.'Ϊչָļչָ
-    ext = strrchr(filename, '.');
-    if (ext)
-    {
-	ext++;
-	p = extensions;
-	for (;;)
-	{
-	    // ļпжţȡżһһַչȽжļͣԿҪαȽϣһѭ
-	    q = ext1;
-	    // λһŻַַ֮չַС
-	    while (*p != '\0' &&  *p != ',' && q - ext1 < sizeof(ext1) - 1)
-		*q++ = *p++;
-	    // չַ0
-	    *q = '\0';
-	    // ȽʶչǷչͬͬͷ1
-	    if (!strcasecmp(ext1, ext))
-		return 1;
-	    if (*p == '\0')
-		break;
-	    p++;
-	}
-    }
-    // ǰѭûƥ䵽չǲʶļͷ0
-    return 0;
-}
-
-// ̽ļʽʶļʽûʶͷسʼֵNULL
-AVInputFormat *av_probe_input_format(AVProbeData *pd, int is_opened)
-{
-    AVInputFormat *fmt1, *fmt;
-    // scorescore_max ʶļʽȷ
-    // ļʽʶȫȷ趨Ϊ100ȷ趨Ϊ50ûʶ趨Ϊ0ʶ𷽷ͬµȼͬ
-    int score, score_max;
-
-    fmt = NULL;
-    score_max = 0;
-    for (fmt1 = first_iformat; fmt1 != NULL; fmt1 = fmt1->next)
-    {
-	if (!is_opened)
-	    continue;
-
-	score = 0;
-	if (fmt1->read_probe)
-	{
-	    // ȡļͷжļͷʶļʽʶ𷽷ǳɿ趨score Ϊ100
-	    score = fmt1->read_probe(pd);
-	}
-	else if (fmt1->extensions)
-	{
-	    // ͨļչʶļʽΪļչκ˶Ըģıչַʹıչʶ𷽷еɿۺϵȼΪ50
-	    if (match_ext(pd->filename, fmt1->extensions))
-		score = 50;
-	}
-	// ʶĵȼҪĵȼΪȷʶزֵ󣬽һѭ󷵻߼Ӧļʽ
-	if (score > score_max)
-	{
-	    score_max = score;
-	    fmt = fmt1;
-	}
-    }
-    return fmt;
-}
-
-// AVFormatParameters *ap ffplay ûõΪ˲ıӿ
-int av_open_input_stream(AVFormatContext **ic_ptr, ByteIOContext *pb, const char *filename,
-    AVInputFormat *fmt, AVFormatParameters *ap)
-{
-    int err;
-    AVFormatContext *ic;
-    AVFormatParameters default_ap;
-
-    if (!ap)
-    {
-	ap = &default_ap;
-	memset(ap, 0, sizeof(default_ap));
-    }
-    //AVFormatContext ڴ棬ֳԱڽĳиֳֵԱõic->iformat->read_header(ic, ap)иֵ
-    ic = av_mallocz(sizeof(AVFormatContext));
-    if (!ic)
-    {
-	err = AVERROR_NOMEM;
-	goto fail;
-    }
-    // AVFormatContextAVInputFormat
-    ic->iformat = fmt;
-    // AVFormatContext͹ļByteIOContext
-    if (pb)
-	ic->pb = *pb;
-
-    if (fmt->priv_data_size > 0)
-    {
-	// priv_data ָڴ档
-	ic->priv_data = av_mallocz(fmt->priv_data_size);
-	if (!ic->priv_data)
-	{
-	    err = AVERROR_NOMEM;
-	    goto fail;
-	}
-    }
-    else
-    {
-	ic->priv_data = NULL;
-    }
-    // ȡļͷʶýʽ
-    err = ic->iformat->read_header(ic, ap);
-    if (err < 0)
-	goto fail;
-
-    *ic_ptr = ic;
-    return 0;
-
-    // 򵥳Ĵ
-fail:
-    if (ic)
-	av_freep(&ic->priv_data);
-
-    av_free(ic);
-    *ic_ptr = NULL;
-    return err;
-}
-
-// ļʶļʽȻúʶýʽ
-int av_open_input_file(AVFormatContext **ic_ptr, const char *filename, AVInputFormat *fmt,
-    int buf_size, AVFormatParameters *ap)
-{
-    int err, must_open_file, file_opened, probe_size;
-    AVProbeData probe_data, *pd = &probe_data;
-    ByteIOContext pb1, *pb = &pb1;
-
-    file_opened = 0;
-    pd->filename = "";
-    if (filename)
-	pd->filename = filename;
-    pd->buf = NULL;
-    pd->buf_size = 0;
-
-    must_open_file = 1;
-
-    if (!fmt || must_open_file)
-    {
-	// ļByteIOContextתκʵʵļϵͳopen()ʵʴļ
-	if (url_fopen(pb, filename, URL_RDONLY) < 0)
-	{
-	    err = AVERROR_IO;
-	    goto fail;
-	}
-	file_opened = 1;
-	// ָByteIOContext ڲʹõĻСڲСָͨС
-	if (buf_size > 0)
-	    url_setbufsize(pb, buf_size);
-
-	// ȶPROBE_BUF_MIN(2048)ֽļʼʶļʽ
-	// ʶļʽͰʶļ2 ٶļʼʶֱʶļʽ߳131072 ֽڻ档
-	for (probe_size = PROBE_BUF_MIN; probe_size <= PROBE_BUF_MAX && !fmt; probe_size <<= 1)
-	{
-	    // ·仺棬¶ļʼݡ
-	    pd->buf = av_realloc(pd->buf, probe_size);
-	    pd->buf_size = url_fread(pb, pd->buf, probe_size);
-	    // ļָseek ļʼһζ
-	    if (url_fseek(pb, 0, SEEK_SET) == (offset_t)-EPIPE)
-	    {
-		// seek󣬹رļ´򿪡
-		url_fclose(pb);
-		// ´ļô룬
-		if (url_fopen(pb, filename, URL_RDONLY) < 0)
-		{
-		    file_opened = 0;
-		    err = AVERROR_IO;
-		    goto fail;
-		}
-	    }
-
-	    // ʶļʽΪһαһݶ࣬ٵʱʶ𲻳ݶ˿ܾͿˡ
-	    fmt = av_probe_input_format(pd, 1);
-	}
-	av_freep(&pd->buf);
-    }
-
-    if (!fmt)
-    {
-	err = AVERROR_NOFMT;
-	goto fail;
-    }
-
-    // ʶļʽ󣬵úʶav_open_input_stream ʽ
-    err = av_open_input_stream(ic_ptr, pb, filename, fmt, ap);
-    if (err)
-	goto fail;
-    return 0;
-
-fail:
-    // 򵥵쳣
-    av_freep(&pd->buf);
-    if (file_opened)
-	url_fclose(pb);
-    *ic_ptr = NULL;
-    return err;
-}
-
-// һζȡһݰffplay Уһζȡһ֡ݰ
-int av_read_packet(AVFormatContext *s, AVPacket *pkt)
-{
-    return s->iformat->read_packet(s, pkt);
-}
-
-// ЩýļΪseekƵ֡ffplay ЩʱŵһСֵ
-int av_add_index_entry(AVStream *st, int64_t pos, int64_t timestamp, int size, int distance, int flags)
-{
-    AVIndexEntry *entries, *ie;
-    int index;
-
-    if ((unsigned)st->nb_index_entries + 1 >= UINT_MAX / sizeof(AVIndexEntry)) // Խж
-	return  -1;
-
-    entries = av_fast_realloc(st->index_entries, &st->index_entries_allocated_size,
-	(st->nb_index_entries + 1) * sizeof(AVIndexEntry));
-    if (!entries)
-	return  -1;
-
-    st->index_entries = entries;
-
-    index = av_index_search_timestamp(st, timestamp, AVSEEK_FLAG_ANY);
-
-    if (index < 0)	// 
-    {
-	index = st->nb_index_entries++;
-	ie = &entries[index];
-	assert(index == 0 || ie[-1].timestamp < timestamp);
-    }
-    else			// в
-    {
-	ie = &entries[index];
-	if (ie->timestamp != timestamp)
-	{
-	    if (ie->timestamp <= timestamp)
-		return  -1;
-
-	    memmove(entries + index + 1, entries + index,
-		sizeof(AVIndexEntry)*(st->nb_index_entries - index));
-
-	    st->nb_index_entries++;
-	}
-    }
-
-    ie->pos = pos;
-    ie->timestamp = timestamp;
-    ie->size = size;
-    ie->flags = flags;
-
-    return index;
-}
-
-int av_index_search_timestamp(AVStream *st, int64_t wanted_timestamp, int flags)
-{
-    AVIndexEntry *entries = st->index_entries;
-    int nb_entries = st->nb_index_entries;
-    int a, b, m;
-    int64_t timestamp;
-
-    a = -1;
-    b = nb_entries;
-
-    while (b - a > 1) //ûм¼idxֵõ۰
-    {
-	m = (a + b) >> 1;
-	timestamp = entries[m].timestamp;
-	if (timestamp >= wanted_timestamp)
-	    b = m;
-	if (timestamp <= wanted_timestamp)
-	    a = m;
-    }
-
-    m = (flags &AVSEEK_FLAG_BACKWARD) ? a : b;
-
-    if (!(flags &AVSEEK_FLAG_ANY))
-    {
-	while (m >= 0 && m < nb_entries && !(entries[m].flags &AVINDEX_KEYFRAME))
-	{
-	    m += (flags &AVSEEK_FLAG_BACKWARD) ? -1 : 1;
-	}
-    }
-
-    if (m == nb_entries)
-	return  -1;
-
-    return m;
-}
-
-// رýļһѵĹرͷŲ
-void av_close_input_file(AVFormatContext *s)
-{
-    int i;
-    AVStream *st;
-
-    if (s->iformat->read_close)
-	s->iformat->read_close(s);
-
-    for (i = 0; i < s->nb_streams; i++)
-    {
-	st = s->streams[i];
-	av_free(st->index_entries);
-	av_free(st->actx);
-	av_free(st);
-    }
-
-    url_fclose(&s->pb);
-
-    av_freep(&s->priv_data);
-    av_free(s);
-}
-// new һµýAVStream ָ
-AVStream *av_new_stream(AVFormatContext *s, int id)
-{
-    AVStream *st;
-
-    if (s->nb_streams >= MAX_STREAMS)
-	return NULL;
-
-    st = av_mallocz(sizeof(AVStream));
-    if (!st)
-	return NULL;
-
-    st->actx = avcodec_alloc_context();
-
-    s->streams[s->nb_streams++] = st;
-    return st;
-}
-
-// üpts ʱӵز
-void av_set_pts_info(AVStream *s, int pts_wrap_bits, int pts_num, int pts_den)
-{
-    s->time_base.num = pts_num;
-    s->time_base.den = pts_den;
-}
+#include "../berrno.h"
+#include "avformat.h"
+#include "../libavutil/avthread.h"
+#include <assert.h>
+
+#define UINT_MAX  (0xffffffff)
+#define INT_MAX   2147483647
+
+#define PROBE_BUF_MIN 2048
+#define PROBE_BUF_MAX 131072
+
+// 识别文件格式和媒体格式部分使用的一些工具类函数。
+
+AVInputFormat *first_iformat = NULL;
+
+
+void av_register_input_format(AVInputFormat *format)
+{
+    AVInputFormat **p;
+    p = &first_iformat;
+    // 循环移动节点指针到最后一个文件容器格式。
+    while (*p != NULL)
+	p = &(*p)->next;
+    // 直接挂接要注册的文件容器格式。
+    *p = format;
+    format->next = NULL;
+}
+
+// 比较文件的扩展名来识别文件类型。
+int match_ext(const char *filename, const char *extensions)
+{
+    const char *ext, *p;
+    char ext1[32], *q;
+
+    if (!filename)
+	return 0;
+
+    // 用'.'号作为扩展名分割符，在文件名中找扩展名分割符。
+    ext = strrchr(filename, '.');
+    if (ext)
+    {
+	ext++;
+	p = extensions;
+	for (;;)
+	{
+	    // 文件名中可能有多个标点符号，取两个标点符号间或一个标点和一个结束符间的字符串和扩展名比较来判断文件类型，所以可能要多次比较，所以这里有一个循环。
+	    q = ext1;
+	    // 定位下一个标点符号或字符串结束符，把这之间的字符拷贝到扩展名字符数组中。
+	    while (*p != '\0' &&  *p != ',' && q - ext1 < sizeof(ext1) - 1)
+		*q++ = *p++;
+	    // 添加扩展名字符串结束标记0。
+	    *q = '\0';
+	    // 比较识别的扩展名是否后给定的扩展名相同，如果相同就返回1，否则继续
+	    if (!strcasecmp(ext1, ext))
+		return 1;
+	    if (*p == '\0')
+		break;
+	    p++;
+	}
+    }
+    // 如果在前面的循环中没有匹配到扩展名，就是不识别的文件类型返回0
+    return 0;
+}
+
+// 探测输入的文件容器格式，返回识别出来的文件格式。如果没有识别出来，就返回初始值NULL。
+AVInputFormat *av_probe_input_format(AVProbeData *pd, int is_opened)
+{
+    AVInputFormat *fmt1, *fmt;
+    // score，score_max 可以理解识别文件容器格式的正确级别。
+    // 文件容器格式识别结果，如果完全正确可以设定为100，如果可能正确可以设定为50，没识别出来设定为0。识别方法不同导致等级不同。
+    int score, score_max;
+
+    fmt = NULL;
+    score_max = 0;
+    for (fmt1 = first_iformat; fmt1 != NULL; fmt1 = fmt1->next)
+    {
+	if (!is_opened)
+	    continue;
+
+	score = 0;
+	if (fmt1->read_probe)
+	{
+	    // 读取文件头，判断文件头的内容来识别文件容器格式，这种识别方法非常可靠，设定score 为100。
+	    score = fmt1->read_probe(pd);
+	}
+	else if (fmt1->extensions)
+	{
+	    // 通过文件扩展名来识别文件容器格式，因为文件扩展名任何人都可以改，如果改变扩展名，这种方法就错误，如果不改变扩展名，这种识别方法有点可靠，综合等级为50。
+	    if (match_ext(pd->filename, fmt1->extensions))
+		score = 50;
+	}
+	// 如果识别出来的等级大于最大要求的等级，就认为正确识别，相关参数赋值后，进下一个循环，最后返回最高级别对应的文件容器格式。
+	if (score > score_max)
+	{
+	    score_max = score;
+	    fmt = fmt1;
+	}
+    }
+    return fmt;
+}
+
+// 打开输入流，其中AVFormatParameters *ap 参数在瘦身后的ffplay 中没有用到，保留为了不改变接口
+int av_open_input_stream(AVFormatContext **ic_ptr, ByteIOContext *pb, const char *filename,
+    AVInputFormat *fmt, AVFormatParameters *ap)
+{
+    int err;
+    AVFormatContext *ic;
+    AVFormatParameters default_ap;
+
+    if (!ap)
+    {
+	ap = &default_ap;
+	memset(ap, 0, sizeof(default_ap));
+    }
+    //分配AVFormatContext 内存，部分成员变量在接下来的程序代码中赋值，部分成员变量在下面调用的ic->iformat->read_header(ic, ap)函数中赋值。
+    ic = av_mallocz(sizeof(AVFormatContext));
+    if (!ic)
+    {
+	err = AVERROR_NOMEM;
+	goto fail;
+    }
+    // 关联AVFormatContext和AVInputFormat
+    ic->iformat = fmt;
+    // 关联AVFormatContext和广义文件ByteIOContext
+    if (pb)
+	ic->pb = *pb;
+
+    if (fmt->priv_data_size > 0)
+    {
+	// 分配priv_data 指向的内存。
+	ic->priv_data = av_mallocz(fmt->priv_data_size);
+	if (!ic->priv_data)
+	{
+	    err = AVERROR_NOMEM;
+	    goto fail;
+	}
+    }
+    else
+    {
+	ic->priv_data = NULL;
+    }
+    // 读取文件头，识别媒体流格式。
+    err = ic->iformat->read_header(ic, ap);
+    if (err < 0)
+	goto fail;
+
+    *ic_ptr = ic;
+    return 0;
+
+    // 简单常规的错误处理。
+fail:
+    if (ic)
+	av_freep(&ic->priv_data);
+
+    av_free(ic);
+    *ic_ptr = NULL;
+    return err;
+}
+
+// 打开输入文件，并识别文件格式，然后调用函数识别媒体流格式。
+int av_open_input_file(AVFormatContext **ic_ptr, const char *filename, AVInputFormat *fmt,
+    int buf_size, AVFormatParameters *ap)
+{
+    int err, must_open_file, file_opened, probe_size;
+    AVProbeData probe_data, *pd = &probe_data;
+    ByteIOContext pb1, *pb = &pb1;
+
+    file_opened = 0;
+    pd->filename = "";
+    if (filename)
+	pd->filename = filename;
+    pd->buf = NULL;
+    pd->buf_size = 0;
+
+    must_open_file = 1;
+
+    if (!fmt || must_open_file)
+    {
+	// 打开输入文件，关联ByteIOContext，经过跳转几次后才实质调用文件系统open()函数实质打开文件。
+	if (url_fopen(pb, filename, URL_RDONLY) < 0)
+	{
+	    err = AVERROR_IO;
+	    goto fail;
+	}
+	file_opened = 1;
+	// 如果程序指定ByteIOContext 内部使用的缓存大小，就重新设置内部缓存大小。通常不指定大小。
+	if (buf_size > 0)
+	    url_setbufsize(pb, buf_size);
+
+	// 先用PROBE_BUF_MIN(2048)字节文件开始数据识别文件格式，
+	// 如果不能识别文件格式，就把识别数据以2 倍的增长扩大再识别，直到识别出文件格式或者超过131072 字节。
+	// 识别数据直接就是ByteIOContext 内部缓存，每次只把新增的数据接着读进缓存，不seek 也不重新打开文件，
+	// 读指针始终停在文件开始处，识别完后read_header 直接从缓存中继续解析，整个打开过程每个字节只读一次。
+	for (probe_size = PROBE_BUF_MIN; probe_size <= PROBE_BUF_MAX && !fmt; probe_size <<= 1)
+	{
+	    pd->buf_size = url_fensure(pb, probe_size);
+	    pd->buf = pb->buf_ptr;
+
+	    // 重新识别文件格式，因为一次比一次数据多，数据少的时候可能识别不出，数据多了可能就可以了。
+	    fmt = av_probe_input_format(pd, 1);
+
+	    // 文件已经读完，数据不会再多了。
+	    if (pd->buf_size < probe_size)
+		break;
+	}
+	pd->buf = NULL;
+    }
+
+    if (!fmt)
+    {
+	err = AVERROR_NOFMT;
+	goto fail;
+    }
+
+    // 识别出文件格式后，调用函数识别流av_open_input_stream 格式。
+    err = av_open_input_stream(ic_ptr, pb, filename, fmt, ap);
+    if (err)
+	goto fail;
+    return 0;
+
+fail:
+    // 简单的异常错误处理。
+    if (file_opened)
+	url_fclose(pb);
+    *ic_ptr = NULL;
+    return err;
+}
+
+// 一次读取一个数据包，在瘦身后的ffplay 中，一次读取一个完整的数据帧，数据包。
+int av_read_packet(AVFormatContext *s, AVPacket *pkt)
+{
+    return s->iformat->read_packet(s, pkt);
+}
+
+// 数据包链表节点和数据包数据缓存的池分配。每个数据包原来至少要两次malloc(数据和队列节点)，
+// 数据包多时(比如很小的TrueSpeech 音频包)分配器的开销和锁竞争很明显，这里用空闲链表复用。
+// 生产者(解复用线程)和消费者(解码线程)不同，池用一把小锁保护，临界区只有几条指针操作。
+// 池中空闲的数据缓存只计入全局内存统计，分配出去时才计入当前线程设置的流统计。
+
+#define PACKET_LIST_SLAB	256	// 每次批量分配的链表节点数，av_packet_pool_free 时归还系统
+
+#define PACKET_BUF_HEADER	64	// 数据缓存前的头部，记录所属的大小级别，和av_malloc 的对齐一样，数据仍然64 字节对齐
+#define PACKET_BUF_MIN_SHIFT	8	// 最小级别256 字节
+#define PACKET_BUF_CLASSES	9	// 256 字节到64K 字节，更大的直接av_malloc
+#define PACKET_BUF_MAX_FREE	64	// 每个级别最多缓存的空闲数据缓存数，限制池占用的内存
+
+typedef struct PacketBuf
+{
+    int size_class;			// 大小级别，PACKET_BUF_CLASSES 表示不属于池
+    struct PacketBuf *next;		// 空闲链表
+} PacketBuf;
+
+typedef struct PacketListSlab
+{
+    struct PacketListSlab *next;
+    AVPacketList nodes[PACKET_LIST_SLAB];
+} PacketListSlab;
+
+static AVMutex packet_pool_lock = AV_MUTEX_INITIALIZER;
+static PacketListSlab *packet_list_slabs;
+static AVPacketList *packet_list_free;
+static PacketBuf *packet_buf_free[PACKET_BUF_CLASSES];
+static int packet_buf_nb_free[PACKET_BUF_CLASSES];
+
+// 分配一个数据包链表节点，空闲链表为空时一次分配一整块节点串到空闲链表上。
+AVPacketList *av_packet_list_alloc(void)
+{
+    AVPacketList *node;
+
+    av_mutex_lock(&packet_pool_lock);
+    if (!packet_list_free)
+    {
+	PacketListSlab *slab = av_malloc(sizeof(PacketListSlab));
+	int i;
+
+	if (!slab)
+	{
+	    av_mutex_unlock(&packet_pool_lock);
+	    return NULL;
+	}
+	for (i = 0; i < PACKET_LIST_SLAB - 1; i++)
+	    slab->nodes[i].next = &slab->nodes[i + 1];
+	slab->nodes[i].next = NULL;
+	packet_list_free = slab->nodes;
+	slab->next = packet_list_slabs;
+	packet_list_slabs = slab;
+    }
+    node = packet_list_free;
+    packet_list_free = node->next;
+    av_mutex_unlock(&packet_pool_lock);
+
+    node->next = NULL;
+    return node;
+}
+
+void av_packet_list_free(AVPacketList *node)
+{
+    if (!node)
+	return;
+
+    av_mutex_lock(&packet_pool_lock);
+    node->next = packet_list_free;
+    packet_list_free = node;
+    av_mutex_unlock(&packet_pool_lock);
+}
+
+// 按2 的幂大小级别分配数据包数据缓存，优先复用同级别的空闲缓存。
+uint8_t *av_packet_buffer_alloc(unsigned int size)
+{
+    PacketBuf *buf = NULL;
+    int size_class = 0;
+
+    if (size > INT_MAX - PACKET_BUF_HEADER)
+	return NULL;
+
+    while (size_class < PACKET_BUF_CLASSES && size > (1U << (size_class + PACKET_BUF_MIN_SHIFT)))
+	size_class++;
+
+    if (size_class < PACKET_BUF_CLASSES)
+    {
+	av_mutex_lock(&packet_pool_lock);
+	buf = packet_buf_free[size_class];
+	if (buf)
+	{
+	    packet_buf_free[size_class] = buf->next;
+	    packet_buf_nb_free[size_class]--;
+	}
+	av_mutex_unlock(&packet_pool_lock);
+
+	if (buf)
+	    av_mem_charge_to(buf, av_mem_stats_get_current());
+	else
+	    buf = av_malloc(PACKET_BUF_HEADER + (1U << (size_class + PACKET_BUF_MIN_SHIFT)));
+    }
+    else
+    {
+	buf = av_malloc(PACKET_BUF_HEADER + size);
+    }
+
+    if (!buf)
+	return NULL;
+
+    buf->size_class = size_class;
+    return (uint8_t*)buf + PACKET_BUF_HEADER;
+}
+
+// 数据包数据缓存回到所属级别的空闲链表，超过缓存上限或不属于池时直接释放。
+void av_packet_buffer_free(uint8_t *data)
+{
+    PacketBuf *buf;
+    int size_class;
+
+    if (!data)
+	return;
+
+    buf = (PacketBuf*)(data - PACKET_BUF_HEADER);
+    size_class = buf->size_class;
+
+    if (size_class < PACKET_BUF_CLASSES)
+    {
+	// 放回池中之前不再计入原来的流，流关闭后它的统计结构不会被池中的缓存拖住。
+	av_mem_charge_to(buf, NULL);
+
+	av_mutex_lock(&packet_pool_lock);
+	if (packet_buf_nb_free[size_class] < PACKET_BUF_MAX_FREE)
+	{
+	    buf->next = packet_buf_free[size_class];
+	    packet_buf_free[size_class] = buf;
+	    packet_buf_nb_free[size_class]++;
+	    buf = NULL;
+	}
+	av_mutex_unlock(&packet_pool_lock);
+    }
+
+    av_free(buf);
+}
+
+// 释放池中缓存的数据缓存和所有链表节点块。程序退出时调用，调用时所有数据包和链表节点都必须已经释放。
+void av_packet_pool_free(void)
+{
+    PacketListSlab *slab;
+    PacketBuf *buf;
+    int i;
+
+    av_mutex_lock(&packet_pool_lock);
+    while (packet_list_slabs)
+    {
+	slab = packet_list_slabs;
+	packet_list_slabs = slab->next;
+	av_free(slab);
+    }
+    packet_list_free = NULL;
+
+    for (i = 0; i < PACKET_BUF_CLASSES; i++)
+    {
+	while (packet_buf_free[i])
+	{
+	    buf = packet_buf_free[i];
+	    packet_buf_free[i] = buf->next;
+	    av_free(buf);
+	}
+	packet_buf_nb_free[i] = 0;
+    }
+    av_mutex_unlock(&packet_pool_lock);
+}
+
+// 批量读取最多max 个数据包到pkts 数组，*nb_pkts 返回实际读到的包数，一个包也没读到时返回错误码。
+// 文件容器格式不支持批量读取时，退化为每次只读一个包。
+int av_read_packets(AVFormatContext *s, AVPacket *pkts, int max, int *nb_pkts)
+{
+    int n;
+
+    *nb_pkts = 0;
+    if (max <= 0)
+	return 0;
+
+    if (s->iformat->read_packets)
+    {
+	n = s->iformat->read_packets(s, pkts, max);
+	if (n <= 0)
+	    return  -1;
+    }
+    else
+    {
+	if (s->iformat->read_packet(s, pkts) < 0)
+	    return  -1;
+	n = 1;
+    }
+
+    *nb_pkts = n;
+    return 0;
+}
+
+// 添加索引到索引表。有些媒体文件为便于seek，有音视频数据帧有索引，ffplay 把这些索引以时间排序放到一个数据中。返回值添加项的索引。
+int av_add_index_entry(AVStream *st, int64_t pos, int64_t timestamp, int size, int distance, int flags)
+{
+    AVIndexEntry *entries, *ie;
+    int index;
+
+    if ((unsigned)st->nb_index_entries + 1 >= UINT_MAX / sizeof(AVIndexEntry)) // 越界判断
+	return  -1;
+
+    entries = av_fast_realloc(st->index_entries, &st->index_entries_allocated_size,
+	(st->nb_index_entries + 1) * sizeof(AVIndexEntry));
+    if (!entries)
+	return  -1;
+
+    st->index_entries = entries;
+
+    index = av_index_search_timestamp(st, timestamp, AVSEEK_FLAG_ANY);
+
+    if (index < 0)	// 后续
+    {
+	index = st->nb_index_entries++;
+	ie = &entries[index];
+	assert(index == 0 || ie[-1].timestamp < timestamp);
+    }
+    else			// 中插
+    {
+	ie = &entries[index];
+	if (ie->timestamp != timestamp)
+	{
+	    if (ie->timestamp <= timestamp)
+		return  -1;
+
+	    memmove(entries + index + 1, entries + index,
+		sizeof(AVIndexEntry)*(st->nb_index_entries - index));
+
+	    st->nb_index_entries++;
+	}
+    }
+
+    ie->pos = pos;
+    ie->timestamp = timestamp;
+    ie->size = size;
+    ie->flags = flags;
+
+    return index;
+}
+
+int av_index_search_timestamp(AVStream *st, int64_t wanted_timestamp, int flags)
+{
+    AVIndexEntry *entries = st->index_entries;
+    int nb_entries = st->nb_index_entries;
+    int a, b, m;
+    int64_t timestamp;
+
+    a = -1;
+    b = nb_entries;
+
+    while (b - a > 1) //并没有记录idx值，采用的是折半查找
+    {
+	m = (a + b) >> 1;
+	timestamp = entries[m].timestamp;
+	if (timestamp >= wanted_timestamp)
+	    b = m;
+	if (timestamp <= wanted_timestamp)
+	    a = m;
+    }
+
+    m = (flags &AVSEEK_FLAG_BACKWARD) ? a : b;
+
+    if (!(flags &AVSEEK_FLAG_ANY))
+    {
+	while (m >= 0 && m < nb_entries && !(entries[m].flags &AVINDEX_KEYFRAME))
+	{
+	    m += (flags &AVSEEK_FLAG_BACKWARD) ? -1 : 1;
+	}
+    }
+
+    if (m == nb_entries)
+	return  -1;
+
+    return m;
+}
+
+// 关闭输入媒体文件，一大堆的关闭释放操作。
+void av_close_input_file(AVFormatContext *s)
+{
+    int i;
+    AVStream *st;
+
+    if (s->iformat->read_close)
+	s->iformat->read_close(s);
+
+    for (i = 0; i < s->nb_streams; i++)
+    {
+	st = s->streams[i];
+	av_free(st->index_entries);
+	av_free(st->actx);
+	av_mem_stats_release(st->mem_stats);
+	av_free(st);
+    }
+
+    url_fclose(&s->pb);
+
+    av_freep(&s->priv_data);
+    av_free(s);
+}
+// new 一个新的媒体流，返回AVStream 指针
+AVStream *av_new_stream(AVFormatContext *s, int id)
+{
+    AVStream *st;
+
+    if (s->nb_streams >= MAX_STREAMS)
+	return NULL;
+
+    st = av_mallocz(sizeof(AVStream));
+    if (!st)
+	return NULL;
+
+    st->actx = avcodec_alloc_context();
+
+    // 流统计在最后一个计入它的内存释放后才真正释放，解码器上下文借用同一个统计。
+    st->mem_stats = av_mem_stats_alloc();
+    st->actx->mem_stats = st->mem_stats;
+
+    s->streams[s->nb_streams++] = st;
+    return st;
+}
+
+// 设置计算pts 时钟的相关参数。
+void av_set_pts_info(AVStream *s, int pts_wrap_bits, int pts_num, int pts_den)
+{
+    s->time_base.num = pts_num;
+    s->time_base.den = pts_den;
+}
@@ -0,0 +1,194 @@
+#ifndef AVTHREAD_H
+#define AVTHREAD_H
+
+// 最简单的线程、互斥量、条件变量、线程局部变量和原子操作封装，屏蔽windows 和linux 的差别，供库内部需要并发的模块使用。
+// windows 用SRWLOCK 和CONDITION_VARIABLE(Vista 以上)，其他平台用pthread，都支持静态初始化。
+
+#include "common.h"
+
+#ifdef CONFIG_WIN32
+
+#include <windows.h>
+
+typedef SRWLOCK AVMutex;
+typedef CONDITION_VARIABLE AVCond;
+typedef HANDLE AVThread;
+
+#define AV_MUTEX_INITIALIZER	SRWLOCK_INIT
+
+static inline void av_mutex_init(AVMutex *m)
+{
+    InitializeSRWLock(m);
+}
+
+static inline void av_mutex_destroy(AVMutex *m)
+{
+}
+
+static inline void av_mutex_lock(AVMutex *m)
+{
+    AcquireSRWLockExclusive(m);
+}
+
+static inline void av_mutex_unlock(AVMutex *m)
+{
+    ReleaseSRWLockExclusive(m);
+}
+
+static inline void av_cond_init(AVCond *c)
+{
+    InitializeConditionVariable(c);
+}
+
+static inline void av_cond_destroy(AVCond *c)
+{
+}
+
+static inline void av_cond_wait(AVCond *c, AVMutex *m)
+{
+    SleepConditionVariableSRW(c, m, INFINITE, 0);
+}
+
+static inline void av_cond_signal(AVCond *c)
+{
+    WakeConditionVariable(c);
+}
+
+static inline void av_cond_broadcast(AVCond *c)
+{
+    WakeAllConditionVariable(c);
+}
+
+// windows 线程函数的原型和pthread 不同，用一个小结构中转一下。
+typedef struct AVThreadStart
+{
+    void *(*func)(void*);
+    void *arg;
+} AVThreadStart;
+
+static inline DWORD WINAPI av_thread_start(LPVOID param)
+{
+    AVThreadStart start = *(AVThreadStart*)param;
+
+    free(param);
+    start.func(start.arg);
+    return 0;
+}
+
+static inline int av_thread_create(AVThread *t, void *(*func)(void*), void *arg)
+{
+    AVThreadStart *start = malloc(sizeof(AVThreadStart));
+
+    if (!start)
+	return  -1;
+    start->func = func;
+    start->arg = arg;
+
+    *t = CreateThread(NULL, 0, av_thread_start, start, 0, NULL);
+    if (*t == NULL)
+    {
+	free(start);
+	return  -1;
+    }
+    return 0;
+}
+
+static inline void av_thread_join(AVThread t)
+{
+    WaitForSingleObject(t, INFINITE);
+    CloseHandle(t);
+}
+
+#define AV_THREAD_LOCAL	__declspec(thread)
+
+// 64 位原子操作，返回加后的新值/交换前的旧值。
+static inline int64_t av_atomic_add64(volatile int64_t *p, int64_t v)
+{
+    return InterlockedExchangeAdd64((volatile LONGLONG*)p, v) + v;
+}
+
+static inline int64_t av_atomic_cas64(volatile int64_t *p, int64_t oldv, int64_t newv)
+{
+    return InterlockedCompareExchange64((volatile LONGLONG*)p, newv, oldv);
+}
+
+#else
+
+#include <pthread.h>
+
+typedef pthread_mutex_t AVMutex;
+typedef pthread_cond_t AVCond;
+typedef pthread_t AVThread;
+
+#define AV_MUTEX_INITIALIZER	PTHREAD_MUTEX_INITIALIZER
+
+static inline void av_mutex_init(AVMutex *m)
+{
+    pthread_mutex_init(m, NULL);
+}
+
+static inline void av_mutex_destroy(AVMutex *m)
+{
+    pthread_mutex_destroy(m);
+}
+
+static inline void av_mutex_lock(AVMutex *m)
+{
+    pthread_mutex_lock(m);
+}
+
+static inline void av_mutex_unlock(AVMutex *m)
+{
+    pthread_mutex_unlock(m);
+}
+
+static inline void av_cond_init(AVCond *c)
+{
+    pthread_cond_init(c, NULL);
+}
+
+static inline void av_cond_destroy(AVCond *c)
+{
+    pthread_cond_destroy(c);
+}
+
+static inline void av_cond_wait(AVCond *c, AVMutex *m)
+{
+    pthread_cond_wait(c, m);
+}
+
+static inline void av_cond_signal(AVCond *c)
+{
+    pthread_cond_signal(c);
+}
+
+static inline void av_cond_broadcast(AVCond *c)
+{
+    pthread_cond_broadcast(c);
+}
+
+static inline int av_thread_create(AVThread *t, void *(*func)(void*), void *arg)
+{
+    return pthread_create(t, NULL, func, arg) ? -1 : 0;
+}
+
+static inline void av_thread_join(AVThread t)
+{
+    pthread_join(t, NULL);
+}
+
+#define AV_THREAD_LOCAL	__thread
+
+static inline int64_t av_atomic_add64(volatile int64_t *p, int64_t v)
+{
+    return __sync_add_and_fetch(p, v);
+}
+
+static inline int64_t av_atomic_cas64(volatile int64_t *p, int64_t oldv, int64_t newv)
+{
+    return __sync_val_compare_and_swap(p, oldv, newv);
+}
+
+#endif
+
+#endif
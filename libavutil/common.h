@@ -1,74 +1,90 @@
-
-#ifndef COMMON_H
-#define COMMON_H
-
-#include <stdlib.h>
-#include <stdio.h>
-#include <string.h>
-#include <ctype.h>
-
-#if defined(WIN32) && !defined(__MINGW32__) && !defined(__CYGWIN__)
-#define CONFIG_WIN32
-#endif
-
-// Ĺؼlinux gcc windows vc еĶǲͬģgcc inlinevc __inline
-// ΪǴlinux ֲģһ궨޸Լ򵥡
-#ifdef CONFIG_WIN32
-#define inline __inline
-#endif
-
-typedef signed char int8_t;
-typedef signed short int16_t;
-typedef signed int int32_t;
-typedef unsigned char uint8_t;
-typedef unsigned short uint16_t;
-typedef unsigned int uint32_t;
-
-// 򵥵Ͷ壬 linux gcc windows vc ͬ
-// ú꿪CONFIG_WIN3264λ͵Ĳ
-#ifdef CONFIG_WIN32
-typedef signed __int64 int64_t;
-typedef unsigned __int64 uint64_t;
-#else
-typedef signed long long int64_t;
-typedef unsigned long long uint64_t;
-#endif
-
-// 64 λĶ﷨linux gcc windows vc ͬú꿪CONFIG_WIN32 64λĲ
-// Linux LL / ULL ʾ64 λVC i64 ʾ64 λ##ӷ##ǰַӳһַ
-#ifdef CONFIG_WIN32
-#define int64_t_C(c)     (c ## i64)
-#define uint64_t_C(c)    (c ## i64)
-#else
-#define int64_t_C(c)     (c ## LL)
-#define uint64_t_C(c)    (c ## ULL)
-#endif
-
-// 64 λ
-#ifndef INT64_MAX
-#define INT64_MAX int64_t_C(9223372036854775807)
-#endif
-
-// СдеַȽϺffplayֻǷȣ˭˭С
-static int strcasecmp(char *s1, const char *s2)
-{
-    while (toupper((unsigned char)*s1) == toupper((unsigned char)*s2++))
-	if (*s1++ == '\0')
-	    return 0;
-
-    return (toupper((unsigned char)*s1) - toupper((unsigned char) *--s2));
-}
-
-// ޷ʹü򵥵ıȽ߼ʵ֣Ƚ࣬жCPU ָˮߣܵ¡
-// a ȡֵΧȽСóĿռ任ʱĲŻ
-static inline int clip(int a, int amin, int amax)
-{
-    if (a < amin)
-	return amin;
-    else if (a > amax)
-	return amax;
-    else
-	return a;
-}
-
-#endif
+
+#ifndef COMMON_H
+#define COMMON_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#if defined(WIN32) && !defined(__MINGW32__) && !defined(__CYGWIN__)
+#define CONFIG_WIN32
+#endif
+
+// 内联函数的关键字在linux gcc 和windows vc 中的定义是不同的，gcc 是inline，vc 是__inline。
+// 因为代码是从linux 下移植过来的，在这里做一个宏定义修改相对简单。
+#ifdef CONFIG_WIN32
+#define inline __inline
+#endif
+
+// 简单的数据类型定义， linux gcc 和windows vc 编译器有稍许不同，
+// 老版本vc 没有stdint.h，用宏开关CONFIG_WIN32 自己定义，其他平台直接用标准头文件，避免和系统定义冲突。
+#ifdef CONFIG_WIN32
+typedef signed char int8_t;
+typedef signed short int16_t;
+typedef signed int int32_t;
+typedef unsigned char uint8_t;
+typedef unsigned short uint16_t;
+typedef unsigned int uint32_t;
+typedef signed __int64 int64_t;
+typedef unsigned __int64 uint64_t;
+#else
+#include <stdint.h>
+#endif
+
+// 编译目标支持SSE2 指令时定义HAVE_SSE2：x64，vc 的/arch:SSE2(vs2012 以后32 位的默认值)，gcc 的-msse2 或x86_64。
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAVE_SSE2
+#endif
+
+// 编译器能生成SSSE3 和AVX2 指令时定义HAVE_SSSE3 和HAVE_AVX2：vc 2013 以后，gcc 4.9 以后用target 属性
+// 单独编译这些函数，不需要-mssse3/-mavx2。只表示编译了这些实现，是否使用由运行时的CPU 检测决定。
+#if defined(HAVE_SSE2) && ((defined(_MSC_VER) && _MSC_VER >= 1800) || \
+    (defined(__GNUC__) && !defined(__clang__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define HAVE_SSSE3
+#define HAVE_AVX2
+#endif
+
+// 64 位整数的定义语法，linux gcc 和windows vc 编译器有稍许不同，用宏开关CONFIG_WIN32 来屏蔽64位整数定义的差别。
+// Linux 用LL / ULL 来表示64 位整数，VC 用i64 来表示64 位整数。##是连接符，把##前后的两个字符串连接成一个字符串。
+#ifdef CONFIG_WIN32
+#define int64_t_C(c)     (c ## i64)
+#define uint64_t_C(c)    (c ## i64)
+#else
+#define int64_t_C(c)     (c ## LL)
+#define uint64_t_C(c)    (c ## ULL)
+#endif
+
+// 定义最大的64 位整数。
+#ifndef INT64_MAX
+#define INT64_MAX int64_t_C(9223372036854775807)
+#endif
+
+// 大小写敏感的字符串比较函数。在ffplay中只关心是否相等，不关心谁大谁小。
+// vc 的C 库没有strcasecmp，自己实现一个，其他平台用strings.h 中的。
+#ifdef CONFIG_WIN32
+static int strcasecmp(char *s1, const char *s2)
+{
+    while (toupper((unsigned char)*s1) == toupper((unsigned char)*s2++))
+	if (*s1++ == '\0')
+	    return 0;
+
+    return (toupper((unsigned char)*s1) - toupper((unsigned char) *--s2));
+}
+#else
+#include <strings.h>
+#endif
+
+// 限幅函数，这个函数使用简单的比较逻辑来实现，比较语句多，容易中断CPU 的指令流水线，导致性能低下。
+// 如果变量a 的取值范围比较小，可以用常规的空间换时间的查表方法来优化。
+static inline int clip(int a, int amin, int amax)
+{
+    if (a < amin)
+	return amin;
+    else if (a > amax)
+	return amax;
+    else
+	return a;
+}
+
+#endif